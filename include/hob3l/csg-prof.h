@@ -0,0 +1,89 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/**
+ * @file
+ * Attribution of the slicing and boolean work to source locations.
+ *
+ * Every vertex of a polygon carries the location of the source
+ * statement it originates from.  The boolean sweep counts its input
+ * edges and its events by the location of their vertices, and splits
+ * its run time among the locations in proportion to their events.
+ * The slicing time of each 3D object is attributed to the object's
+ * location.  All is summed up over all layers.
+ */
+
+#ifndef __CP_CSG_PROF_H
+#define __CP_CSG_PROF_H
+
+#include <hob3lbase/err_tam.h>
+#include <hob3lbase/dict_tam.h>
+#include <hob3lbase/vec_tam.h>
+#include <hob3l/csg_fwd.h>
+
+/**
+ * Work attributed to one source location.
+ */
+typedef struct {
+    cp_dict_t node;
+
+    cp_loc_t loc;
+
+    /** Number of input edges of the boolean sweeps */
+    size_t edge_cnt;
+
+    /** Number of events processed by the boolean sweeps */
+    size_t event_cnt;
+
+    /** Share of the run time of the boolean sweeps, in seconds */
+    double time_sweep;
+
+    /** Run time of slicing, in seconds */
+    double time_slice;
+
+    /** Events in the current sweep, for splitting its time */
+    size_t cur_event_cnt;
+} cp_csg_prof_loc_t;
+
+typedef CP_VEC_T(cp_csg_prof_loc_t*) cp_v_csg_prof_loc_p_t;
+
+struct cp_csg_prof {
+    /** The entries, by location */
+    cp_dict_t *loc;
+
+    /** Last entry looked up: consecutive lookups often hit the same */
+    cp_csg_prof_loc_t *last;
+
+    /** Entries with events in the current sweep */
+    cp_v_csg_prof_loc_p_t cur;
+};
+
+/**
+ * Get the entry for a location, adding a new one if there is none.
+ */
+extern cp_csg_prof_loc_t *cp_csg_prof_get(
+    cp_csg_prof_t *p,
+    cp_loc_t loc);
+
+/**
+ * Count an event of the current boolean sweep.
+ */
+extern void cp_csg_prof_event(
+    cp_csg_prof_t *p,
+    cp_loc_t loc);
+
+/**
+ * End the current boolean sweep: split its run time among the
+ * locations of its events.
+ */
+extern void cp_csg_prof_sweep_end(
+    cp_csg_prof_t *p,
+    double time);
+
+/**
+ * Free all entries.
+ */
+extern void cp_csg_prof_fini(
+    cp_csg_prof_t *p);
+
+#endif /* __CP_CSG_PROF_H */
@@ -48,4 +48,33 @@ static inline size_t cp_csg_add_size(
     return (a == NULL) ? 0 : a->add.size;
 }
 
+/**
+ * Number of steps in the inner loops of the algorithms between
+ * checks of cp_csg_cancelled().
+ */
+#define CP_CANCEL_CHECK_CNT 1024
+
+/**
+ * Whether processing was cancelled via opt->progress.
+ *
+ * opt may be NULL.
+ */
+static inline bool cp_csg_cancelled(
+    cp_csg_opt_t const *opt)
+{
+    return (opt != NULL) && (opt->progress != NULL) &&
+        atomic_load_explicit(&opt->progress->cancel, memory_order_relaxed);
+}
+
+/**
+ * The trace file of opt, or NULL.
+ *
+ * opt may be NULL.
+ */
+static inline cp_trace_t *cp_csg_trace(
+    cp_csg_opt_t const *opt)
+{
+    return (opt == NULL) ? NULL : opt->trace;
+}
+
 #endif /* __CP_CSG_H */
@@ -7,6 +7,11 @@
 #include <hob3lbase/stream_tam.h>
 #include <hob3l/csg2_tam.h>
 
+/**
+ * Context for printing a JavaScript file layer by layer.
+ */
+typedef struct cp_csg2_js cp_csg2_js_t;
+
 /**
  * Print as JavaScript file containing a WebGL scene configuration.
  *
@@ -18,4 +23,39 @@ extern void cp_csg2_tree_put_js(
     cp_stream_t *s,
     cp_csg2_tree_t *t);
 
+/**
+ * Begin printing a JavaScript file layer by layer.
+ *
+ * After this, cp_csg2_tree_put_js_layer() prints the layers in
+ * order, and cp_csg2_tree_put_js_end() finishes the file.  The
+ * result is the same as with cp_csg2_tree_put_js().
+ *
+ * The vertices of several layers are collected into one scene
+ * object, so the returned context holds data until it is
+ * flushed.  It is freed by cp_csg2_tree_put_js_end().
+ */
+extern cp_csg2_js_t *cp_csg2_tree_put_js_begin(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t);
+
+/**
+ * Print a single layer of a JavaScript file.
+ *
+ * The tree root must be a single stack, as constructed by
+ * cp_csg2_op_tree_init().
+ */
+extern void cp_csg2_tree_put_js_layer(
+    cp_csg2_js_t *c,
+    cp_stream_t *s,
+    size_t zi);
+
+/**
+ * Finish printing a JavaScript file layer by layer.
+ *
+ * This frees c.
+ */
+extern void cp_csg2_tree_put_js_end(
+    cp_csg2_js_t *c,
+    cp_stream_t *s);
+
 #endif /* __CP_CSG2_2JS_H */
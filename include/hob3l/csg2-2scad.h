@@ -24,4 +24,33 @@ extern void cp_csg2_tree_put_scad(
     cp_stream_t *s,
     cp_csg2_tree_t *t);
 
+/**
+ * Begin printing a scad file layer by layer.
+ *
+ * After this, cp_csg2_tree_put_scad_layer() prints the layers in
+ * order, and cp_csg2_tree_put_scad_end() finishes the file.  The
+ * result is the same as with cp_csg2_tree_put_scad().
+ *
+ * The tree root must be a single stack, as constructed by
+ * cp_csg2_op_tree_init().
+ */
+extern void cp_csg2_tree_put_scad_begin(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t);
+
+/**
+ * Print a single layer of a scad file.
+ */
+extern void cp_csg2_tree_put_scad_layer(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t,
+    size_t zi);
+
+/**
+ * Finish printing a scad file layer by layer.
+ */
+extern void cp_csg2_tree_put_scad_end(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t);
+
 #endif /* __CP_CSG2_2SCAD_H */
@@ -23,4 +23,33 @@ extern void cp_csg2_tree_put_stl(
     cp_stream_t *s,
     cp_csg2_tree_t *t);
 
+/**
+ * Begin printing an STL file layer by layer.
+ *
+ * After this, cp_csg2_tree_put_stl_layer() prints the layers in
+ * order, and cp_csg2_tree_put_stl_end() finishes the file.  The
+ * result is the same as with cp_csg2_tree_put_stl().
+ */
+extern void cp_csg2_tree_put_stl_begin(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t);
+
+/**
+ * Print a single layer of an STL file.
+ *
+ * The tree root must be a single stack, as constructed by
+ * cp_csg2_op_tree_init().
+ */
+extern void cp_csg2_tree_put_stl_layer(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t,
+    size_t zi);
+
+/**
+ * Finish printing an STL file layer by layer.
+ */
+extern void cp_csg2_tree_put_stl_end(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t);
+
 #endif /* __CP_CSG2_2STL_H */
@@ -21,6 +21,7 @@
  * space from the polygons for storing the result.
  */
 extern void cp_csg2_op_reduce(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_csg2_lazy_t *r);
 
@@ -86,6 +87,8 @@ extern void cp_csg2_op_lazy(
  * and the layer ID must be in range.
  *
  * r is filled from a.  In the process, a is cleared/reused, if necessary.
+ * The new layer in r shares no objects with a, so layer zi of a can be
+ * deleted afterwards.
  *
  * Runtime: O(j * k log k)
  * Space O(k)
@@ -121,6 +124,25 @@ extern cp_csg2_poly_t *cp_csg2_flatten(
     cp_pool_t *tmp,
     cp_v_obj_p_t *root);
 
+/**
+ * Clip a polygon to an axis parallel rectangle, i.e., intersect it
+ * with the rectangle.
+ *
+ * The result is stored in a.  If a is completely inside the
+ * rectangle, it is left unchanged.  If the result is empty, a has no
+ * paths afterwards.
+ *
+ * Triangles are not clipped, so this must be done before
+ * triangulation.
+ *
+ * Runtime and space: see cp_csg2_op_add_layer.
+ */
+extern void cp_csg2_op_clip(
+    cp_csg_opt_t const *opt,
+    cp_pool_t *tmp,
+    cp_csg2_poly_t *a,
+    cp_vec2_minmax_t const *w);
+
 /**
  * Diff a layer with the next and store the result in diff_above/diff_below.
  *
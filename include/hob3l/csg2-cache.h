@@ -0,0 +1,185 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/**
+ * @file
+ * Content addressed on-disk cache of layers.
+ *
+ * Each layer of the result of the 2D CSG stage (i.e., the sliced,
+ * combined, and possibly triangulated polygon) is stored in a file
+ * in a cache directory.  The file name is a hash of everything the
+ * layer depends on: the z coordinate, the options, the epsilons, the
+ * structure of the CSG3 tree, and the content of all CSG3 leaf
+ * objects whose bounding box touches the z coordinate.
+ *
+ * So if an object of a large model changes, only the layers that
+ * intersect with the old or new object need to be computed again.
+ *
+ * Diffs between adjacent layers are not stored: they are computed
+ * again from the layers.
+ *
+ * The layers can also be kept in memory, so that a long running
+ * process (see --watch) can reuse them without a cache directory.
+ */
+
+#ifndef __CP_CSG2_CACHE_H
+#define __CP_CSG2_CACHE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <hob3lbase/err_tam.h>
+#include <hob3lbase/dict_tam.h>
+#include <hob3l/csg2_tam.h>
+#include <hob3l/csg3_tam.h>
+
+typedef struct {
+    /** hash of the object */
+    uint64_t hash;
+
+    /** z range of bounding box */
+    cp_dim_t z_min, z_max;
+} cp_csg2_cache_leaf_t;
+
+typedef CP_VEC_T(cp_csg2_cache_leaf_t) cp_v_csg2_cache_leaf_t;
+
+/**
+ * A layer kept in memory.
+ */
+typedef struct {
+    cp_dict_t node;
+
+    uint64_t key;
+
+    /** Value of cp_csg2_cache_t::gen when the entry was last used */
+    unsigned gen;
+
+    /** The layer, in the same format as in a file */
+    cp_vchar_t data;
+} cp_csg2_cache_entry_t;
+
+typedef struct {
+    /** Cache directory, or NULL to use no files */
+    char const *dir;
+
+    /** Whether to keep layers in memory */
+    bool mem;
+
+    /** Layers in memory, ordered by key */
+    cp_dict_t *entry;
+
+    /** Current generation, see cp_csg2_cache_sweep() */
+    unsigned gen;
+
+    /**
+     * If non-NULL, the key of each layer that is found or stored is
+     * written to this file, together with the layer if it was stored.
+     * The file can be read with cp_csg2_cache_read_log().
+     */
+    FILE *log;
+
+    /** The 3D tree the layers are computed from */
+    cp_csg3_tree_t const *csg3;
+
+    /** Hash of the options and epsilons */
+    uint64_t base;
+
+    /** Leaf objects of the tree, in tree order */
+    cp_v_csg2_cache_leaf_t leaf;
+
+    /** Number of layers found by cp_csg2_cache_get() */
+    size_t hit_cnt;
+
+    /** Number of layers not found by cp_csg2_cache_get() */
+    size_t miss_cnt;
+} cp_csg2_cache_t;
+
+/**
+ * Initialise a layer cache.
+ *
+ * dir may be NULL to use no cache directory.  Otherwise, the
+ * directory is created if it does not exist.
+ *
+ * If mem is true, layers are also kept in memory.
+ *
+ * Before the cache can be used, cp_csg2_cache_set_tree() must be
+ * called.
+ *
+ * On error, returns false and fills in err.
+ */
+extern bool cp_csg2_cache_init(
+    cp_csg2_cache_t *c,
+    cp_err_t *err,
+    char const *dir,
+    bool mem);
+
+/**
+ * Set the CSG3 tree the layers are computed from.
+ *
+ * tri must be true iff the layers are triangulated.
+ *
+ * This can be called again for a new tree, e.g., after the input
+ * file changed.  The layers already in the cache stay valid, and
+ * the hit and miss counts are reset.
+ */
+extern void cp_csg2_cache_set_tree(
+    cp_csg2_cache_t *c,
+    cp_csg3_tree_t const *csg3,
+    bool tri);
+
+/**
+ * Free the data of a layer cache, including the layers in memory.
+ */
+extern void cp_csg2_cache_fini(
+    cp_csg2_cache_t *c);
+
+/**
+ * Load layer zi of r from the cache.
+ *
+ * r must have been initialised by cp_csg2_op_tree_init().
+ *
+ * Layers in memory are tried first, then the cache directory.
+ *
+ * Returns whether the layer was found.  Unreadable or corrupt
+ * entries are treated as not found.
+ */
+extern bool cp_csg2_cache_get(
+    cp_csg2_cache_t *c,
+    cp_csg2_tree_t *r,
+    size_t zi);
+
+/**
+ * Store layer zi of r in the cache.
+ *
+ * In a cache directory, the file is written under a temporary name
+ * and then renamed, so that concurrent readers never see a partial
+ * file.
+ *
+ * On error, returns false and fills in err.
+ */
+extern bool cp_csg2_cache_put(
+    cp_csg2_cache_t *c,
+    cp_err_t *err,
+    cp_csg2_tree_t *r,
+    size_t zi);
+
+/**
+ * Read a file written via the log member of a cache.
+ *
+ * Each layer in the file is stored in memory, and each layer that is
+ * mentioned in the file is marked as used for cp_csg2_cache_sweep().
+ *
+ * Returns false if the file ends in the middle of an entry.  The
+ * entries before that are still stored.
+ */
+extern bool cp_csg2_cache_read_log(
+    cp_csg2_cache_t *c,
+    FILE *f);
+
+/**
+ * Remove all layers from memory that were not used since the previous
+ * call of this function.
+ */
+extern void cp_csg2_cache_sweep(
+    cp_csg2_cache_t *c);
+
+#endif /* __CP_CSG2_CACHE_H */
@@ -23,8 +23,10 @@ extern void cp_csg_add_init_perhaps(
 
 /**
  * Initialises a CSG2 structure with a tree derived from a CSG3
- * structure, and reserves, for each simple object in the tree, an
- * array of layers of size layer_cnt.
+ * structure, with layers at the z coordinates of range s.
+ *
+ * Each simple object in the tree reserves only the layers that
+ * intersect its bounding box.
  *
  * This assumes a freshly zeroed r to be initialised.
  */
@@ -34,4 +36,50 @@ extern void cp_csg2_tree_from_csg3(
     cp_range_t const *s,
     cp_csg_opt_t const *o);
 
+/**
+ * Initialises a CSG2 structure with a tree derived from a CSG3
+ * structure, with layers at the given z coordinates, which must be
+ * sorted in ascending order, e.g., to slice only a few layers on
+ * demand.
+ *
+ * thick is the thickness of each layer in the output.
+ *
+ * Each simple object in the tree reserves only the layers that
+ * intersect its bounding box.
+ *
+ * This assumes a freshly zeroed r to be initialised.
+ */
+extern void cp_csg2_tree_from_csg3_z(
+    cp_csg2_tree_t *r,
+    cp_csg3_tree_t const *d,
+    double const *z,
+    size_t z_cnt,
+    cp_dim_t thick,
+    cp_csg_opt_t const *o);
+
+/**
+ * Delete a CSG2 object and all its children, including the
+ * layers of stacks and the diff polygons.
+ */
+extern void cp_csg2_delete(
+    cp_csg2_t *r);
+
+/**
+ * Delete the contents of layer zi in all stacks of the tree.
+ *
+ * The layer slots themselves are kept, but are empty afterwards.
+ * This is used to release layers that are no longer needed,
+ * e.g., after they have been written.
+ */
+extern void cp_csg2_tree_delete_layer(
+    cp_csg2_tree_t *t,
+    size_t zi);
+
+/**
+ * Delete all objects and layers of a CSG2 tree.  The tree itself is
+ * not freed.
+ */
+extern void cp_csg2_tree_fini(
+    cp_csg2_tree_t *t);
+
 #endif /* __CP_CSG2_TREE_H */
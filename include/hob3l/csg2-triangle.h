@@ -59,11 +59,15 @@
  * Uses \p tmp for all temporary allocations (but not for constructing
  * point_arr or tri).
  *
+ * If processing is cancelled via opt->progress, this fails with a
+ * 'Cancelled' error.  opt may be NULL.
+ *
  * Runtime: O(n log n)
  * Space: O(n)
  * Where n = number of points.
  */
 extern bool cp_csg2_tri_set(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_vec2_arr_ref_t *point_arr,
@@ -86,6 +90,7 @@ extern bool cp_csg2_tri_set(
  * Where n = number of points.
  */
 extern bool cp_csg2_tri_path(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg2_poly_t *g,
@@ -107,6 +112,7 @@ extern bool cp_csg2_tri_path(
  * Where n = number of points.
  */
 extern bool cp_csg2_tri_poly(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg2_poly_t *g);
@@ -116,6 +122,7 @@ extern bool cp_csg2_tri_poly(
  */
 extern bool cp_csg2_tri_vec2_arr_ref(
     cp_v_size3_t *tri,
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_loc_t loc,
@@ -0,0 +1,79 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/**
+ * @file
+ * Binary cache of CSG3 trees.
+ *
+ * The cache file stores a CSG3 tree with all leaves (points, faces,
+ * edge adjacency, graphics context), the tree structure, and the
+ * options that influence the CSG3 conversion.  All references inside
+ * the file are offsets from the start of the file, so the file is
+ * position independent and can be read via mmap() without parsing.
+ *
+ * The file also records the names and content hashes of all source
+ * files the tree was generated from, so that a stale cache can be
+ * detected.
+ *
+ * Source locations are not stored, so error messages about objects
+ * loaded from the cache cannot cite the source.
+ */
+
+#ifndef __CP_CSG3_CACHE_H
+#define __CP_CSG3_CACHE_H
+
+#include <stdint.h>
+#include <hob3lbase/vchar.h>
+#include <hob3lbase/err_tam.h>
+#include <hob3l/csg3_tam.h>
+#include <hob3l/syn_tam.h>
+
+/**
+ * Write a CSG3 tree into a cache file.
+ *
+ * The source files are taken from syn: their content is hashed by
+ * reading them again.  The file is written under a temporary name
+ * and then renamed, so that readers never see a partial file.
+ *
+ * On error, returns false and fills in err.
+ */
+extern bool cp_csg3_cache_save(
+    cp_err_t *err,
+    char const *filename,
+    cp_csg3_tree_t const *t,
+    cp_syn_tree_t const *syn);
+
+/**
+ * Load a CSG3 tree from a cache file written by cp_csg3_cache_save().
+ *
+ * r->opt must be set: it is compared with the options stored in the
+ * file.
+ *
+ * If the cache is stale, i.e., if any of the source files it was
+ * generated from has changed, or if it was generated with different
+ * options, r is left empty, *stale is set to true, and the name of
+ * the top-level source file is stored in src.  If a source file
+ * cannot be read, a warning is printed and the cache is used.  If the
+ * file is corrupt or truncated, but the top-level source file is
+ * known, a warning is printed and the cache is treated as stale, too.
+ *
+ * On error, returns false and fills in err.
+ */
+extern bool cp_csg3_cache_load(
+    cp_csg3_tree_t *r,
+    bool *stale,
+    cp_vchar_t *src,
+    cp_err_t *err,
+    char const *filename);
+
+/**
+ * Hash a CSG3 object and all its children.
+ *
+ * The hash is computed from the same data that cp_csg3_cache_save()
+ * stores, i.e., from the geometry, the transformation, and the
+ * graphics context, but not from the source location.
+ */
+extern uint64_t cp_csg3_cache_hash(
+    cp_obj_t const *o);
+
+#endif /* __CP_CSG3_CACHE_H */
@@ -45,6 +45,26 @@ extern void cp_csg3_tree_bb(
     cp_csg3_tree_t const *r,
     bool max);
 
+/**
+ * Delete all objects and matrices of a CSG3 tree.  The tree itself is
+ * not freed.
+ */
+extern void cp_csg3_tree_fini(
+    cp_csg3_tree_t *r);
+
+/**
+ * Get bounding box of a single CSG3 object.
+ *
+ * If max is non-false, the bb will include structures that are
+ * subtracted.
+ *
+ * bb will not be cleared, but only updated.
+ */
+extern void cp_csg3_bb(
+    cp_vec3_minmax_t *bb,
+    cp_csg3_t const *r,
+    bool max);
+
 /**
  * Convert a SCAD AST into a CSG3 tree.
  */
@@ -55,4 +75,20 @@ extern bool cp_csg3_from_scad_tree(
     cp_err_t *t,
     cp_scad_tree_t const *scad);
 
+/**
+ * Simplify a CSG3 tree before it is sliced, so that each layer has
+ * less to process.  This flattens nested unions, drops subtrahends
+ * whose bounding box does not intersect the minuend, sorts the
+ * operands of intersections by bounding box volume, smallest first,
+ * removes empty operations, and drops identical duplicate leaves in
+ * unions.
+ *
+ * The resulting solid is the same.  Objects that are removed are
+ * freed, so cp_csg3_tree_fini() still works.
+ *
+ * Does nothing unless r->opt->optimise has CP_CSG2_OPT_SIMPLIFY_TREE.
+ */
+extern void cp_csg3_tree_optimise(
+    cp_csg3_tree_t *r);
+
 #endif /* __CP_CSG3_H */
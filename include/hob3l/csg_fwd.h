@@ -6,4 +6,6 @@
 
 typedef struct cp_csg cp_csg_t;
 
+typedef struct cp_csg_prof cp_csg_prof_t;
+
 #endif /* __CP_CSG_FWD_H */
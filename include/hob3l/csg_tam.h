@@ -4,6 +4,8 @@
 #ifndef __CP_CSG_TAM_H
 #define __CP_CSG_TAM_H
 
+#include <stdatomic.h>
+#include <hob3lbase/trace_tam.h>
 #include <hob3l/obj_tam.h>
 #include <hob3l/csg_fwd.h>
 #include <hob3l/csg2_fwd.h>
@@ -101,10 +103,104 @@ struct cp_csg { _CP_OBJ };
  */
 #define CP_CSG2_OPT_DROP_COLLINEAR 0x08
 
+/**
+ * Simplify the CSG3 tree before slicing, see cp_csg3_tree_optimise().
+ */
+#define CP_CSG2_OPT_SIMPLIFY_TREE 0x10
+
 /**
  * Default set of optimisations
  */
-#define CP_CSG2_OPT_DEFAULT (CP_CSG2_OPT_SKIP_EMPTY | CP_CSG2_OPT_DROP_COLLINEAR)
+#define CP_CSG2_OPT_DEFAULT \
+    (CP_CSG2_OPT_SKIP_EMPTY | CP_CSG2_OPT_DROP_COLLINEAR | CP_CSG2_OPT_SIMPLIFY_TREE)
+
+/**
+ * Processing stage reported to a progress callback.
+ */
+typedef enum {
+    /** Reading the input and converting it into 3D CSG. */
+    CP_PROGRESS_READ,
+    /** Slicing, boolean operations, and triangulation of each layer. */
+    CP_PROGRESS_SLICE,
+    /** XOR between adjacent layers. */
+    CP_PROGRESS_DIFF,
+    /** Writing the output after all layers are done. */
+    CP_PROGRESS_WRITE,
+    /** All done. */
+    CP_PROGRESS_DONE,
+} cp_progress_stage_t;
+
+/**
+ * Progress callback.
+ *
+ * zi is the number of layers done in the stage, zi_cnt is the total
+ * number of layers, and written is the number of output bytes written
+ * so far, or 0 if unknown.
+ */
+typedef void (*cp_progress_func_t)(
+    void *user,
+    cp_progress_stage_t stage,
+    size_t zi,
+    size_t zi_cnt,
+    size_t written);
+
+/**
+ * Progress reporting and cancellation.
+ */
+typedef struct {
+    /** Called between layers, may be NULL. */
+    cp_progress_func_t func;
+
+    /** Passed to func. */
+    void *user;
+
+    /**
+     * If set, e.g., from a signal handler or another thread, processing
+     * stops as soon as possible: between layers, and inside the sweeps
+     * of the boolean operations and the triangulation.  The current
+     * step then fails with a 'Cancelled' error.
+     *
+     * This is atomic, not only volatile, so that the write from a
+     * signal handler or another thread is well-defined.  Access with
+     * relaxed order suffices: it guards no other data.
+     */
+    atomic_bool cancel;
+} cp_progress_t;
+
+/**
+ * Counters of the work done by the algorithms, for statistics.
+ *
+ * The counters are only incremented, so they sum up over all
+ * layers until they are reset by the user.
+ */
+typedef struct {
+    /** Number of polygon paths in the result of the layer boolean operations */
+    size_t poly_cnt;
+
+    /** Number of input edges of the boolean sweeps */
+    size_t edge_cnt;
+
+    /** Number of events processed by the boolean sweeps */
+    size_t event_cnt;
+
+    /** Number of intersection points found by the boolean sweeps */
+    size_t intersection_cnt;
+
+    /** Number of edges split by the boolean sweeps */
+    size_t divide_cnt;
+
+    /** Number of events put back into the queue after misclassification */
+    size_t requeue_cnt;
+
+    /** Number of boolean sweeps run by cp_csg2_op_reduce() */
+    size_t reduce_cnt;
+
+    /** Number of input nodes of the triangulation */
+    size_t tri_node_cnt;
+
+    /** Number of triangles constructed */
+    size_t triangle_cnt;
+} cp_csg_stat_t;
 
 /**
  * Options for CSG rendering.
@@ -162,6 +258,34 @@ typedef struct {
      * Treatment of 2D object outside 2D context. (CP_ERR_*)
      */
     unsigned err_outside_2d;
+
+    /**
+     * If non-NULL, only the part of each layer inside this xy
+     * rectangle is computed: objects outside are skipped, and the
+     * others are clipped right after slicing.
+     */
+    cp_vec2_minmax_t const *xy_window;
+
+    /**
+     * Progress reporting and cancellation, or NULL.
+     */
+    cp_progress_t *progress;
+
+    /**
+     * Work counters to increment, or NULL.
+     */
+    cp_csg_stat_t *stat;
+
+    /**
+     * Attribution of the work to source locations, or NULL.
+     */
+    cp_csg_prof_t *prof;
+
+    /**
+     * Trace file for spans of the boolean operations and the
+     * triangulation, or NULL.
+     */
+    cp_trace_t *trace;
 } cp_csg_opt_t;
 
 
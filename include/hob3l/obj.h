@@ -82,10 +82,13 @@
     _cp_try_cast_aux(CP_GENSYM(__x), CP_GENSYM(__t), CP_GENSYM(__n), g, t, x)
 
 /** Cast to abstract type cast w/ static check */
-#define cp_obj(t) \
+#define cp_obj(t) _cp_obj_aux(CP_GENSYM(__t), t)
+
+#define _cp_obj_aux(_t, t) \
     ({ \
-        assert((t)->type != 0); \
-        (cp_obj_t*)(t); \
+        __typeof__(*(t)) *_t = (t); \
+        assert(_t->type != 0); \
+        (cp_obj_t*)_t; \
     })
 
 static inline bool _cp_is_compatible(
@@ -22,6 +22,9 @@
 #include <hob3l/scad-2scad.h>
 #include <hob3l/obj.h>
 
+/** Create a SCAD instance */
+#define cp_scad_new(r, l) _cp_new(cp_scad_typeof, r, l)
+
 /** Cast w/ dynamic check */
 #define cp_scad_cast(t, s) _cp_cast(cp_scad_typeof, t, s)
 
@@ -39,4 +42,16 @@ extern bool cp_scad_from_syn_tree(
     cp_scad_tree_t *result,
     cp_syn_tree_t *syn);
 
+/**
+ * Delete a SCAD object and all its children.
+ */
+extern void cp_scad_delete(
+    cp_scad_t *s);
+
+/**
+ * Delete all objects of a SCAD tree.  The tree itself is not freed.
+ */
+extern void cp_scad_tree_fini(
+    cp_scad_tree_t *t);
+
 #endif /* __CP_SCAD_H */
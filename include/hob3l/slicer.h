@@ -0,0 +1,277 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/**
+ * @file
+ * Stable C API for slicing models in-process.
+ *
+ * This is the interface of libhob3l.so.  It does not depend on any
+ * other header of this package, and the shared library exports only
+ * the functions declared here, so that programs linked against it
+ * keep working with later versions of the library.
+ *
+ * Usage:
+ *
+ *     cp_slicer_t *s = cp_slicer_new();
+ *     cp_slicer_set_step(s, 0.2);
+ *     if (!cp_slicer_load_file(s, "model.scad")) {
+ *         fprintf(stderr, "%s", cp_slicer_error(s));
+ *     }
+ *     for (size_t i = 0; i < cp_slicer_layer_cnt(s); i++) {
+ *         cp_slicer_layer_t l;
+ *         if (!cp_slicer_get_layer(s, i, &l)) { ... }
+ *         ... use l.point, l.path_idx, l.triangle ...
+ *     }
+ *     cp_slicer_delete(s);
+ *
+ * A slicer object must not be used by multiple threads at the same
+ * time, except for cp_slicer_set_cancel().  The epsilons and the cache
+ * of library files read via 'use' or 'include' are shared by the whole
+ * process, so only one thread may use the library at a time.  Internal
+ * consistency checks abort the process, like in the command line tool.
+ */
+
+#ifndef __CP_SLICER_H
+#define __CP_SLICER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Version of this API.  This changes only when the API changes
+ * incompatibly.
+ */
+#define CP_SLICER_API_VERSION 1
+
+#ifndef CP_SLICER_EXPORT
+#define CP_SLICER_EXPORT __attribute__((visibility("default")))
+#endif
+
+/** Stage reported to the progress callback: reading the model */
+#define CP_SLICER_STAGE_READ 0
+
+/** Stage reported to the progress callback: computing a layer */
+#define CP_SLICER_STAGE_SLICE 1
+
+/**
+ * Progress callback.  stage is one of the CP_SLICER_STAGE_* values,
+ * zi is the index of the layer that is about to be computed, and
+ * zi_cnt is cp_slicer_layer_cnt().  When reading, both are 0.
+ */
+typedef void (*cp_slicer_progress_t)(
+    void *user,
+    unsigned stage,
+    size_t zi,
+    size_t zi_cnt);
+
+/**
+ * Slicer: options, the loaded model, and the current layer.
+ */
+typedef struct cp_slicer cp_slicer_t;
+
+/**
+ * A layer of the sliced model.
+ *
+ * The arrays are owned by the slicer and stay valid until the next
+ * call of cp_slicer_get_layer(), cp_slicer_get_layer_at(),
+ * cp_slicer_load_file(), cp_slicer_load_buffer(), or
+ * cp_slicer_delete().
+ */
+typedef struct {
+    /** z coordinate of the layer */
+    double z;
+
+    /** Number of points */
+    size_t point_cnt;
+
+    /** Coordinates of the points: x and y of each point, 2 * point_cnt entries */
+    double const *point;
+
+    /** Number of contour paths */
+    size_t path_cnt;
+
+    /**
+     * Start of each path in path_idx, path_cnt + 1 entries: path i
+     * consists of the points path_idx[path_start[i]] up to, but
+     * excluding, path_idx[path_start[i+1]].
+     */
+    size_t const *path_start;
+
+    /** Point indices of all paths */
+    size_t const *path_idx;
+
+    /** Number of triangles, 0 if triangulation is switched off */
+    size_t triangle_cnt;
+
+    /** Point indices of the triangles, 3 * triangle_cnt entries */
+    size_t const *triangle;
+} cp_slicer_layer_t;
+
+/**
+ * Returns CP_SLICER_API_VERSION of the library.
+ */
+CP_SLICER_EXPORT
+extern unsigned cp_slicer_api_version(void);
+
+/**
+ * Allocate a new slicer with default options.
+ */
+CP_SLICER_EXPORT
+extern cp_slicer_t *cp_slicer_new(void);
+
+/**
+ * Free a slicer and everything it contains.
+ */
+CP_SLICER_EXPORT
+extern void cp_slicer_delete(
+    cp_slicer_t *s);
+
+/**
+ * Set the distance between layers (default: 0.2).
+ *
+ * Options must be set before the model is loaded.
+ */
+CP_SLICER_EXPORT
+extern void cp_slicer_set_step(
+    cp_slicer_t *s,
+    double step);
+
+/**
+ * Set the z coordinate of the first and last layer.  By default, the
+ * layers cover the bounding box of the model.
+ */
+CP_SLICER_EXPORT
+extern void cp_slicer_set_range(
+    cp_slicer_t *s,
+    double z_min,
+    double z_max);
+
+/**
+ * Compute only the part of each layer inside the given xy rectangle.
+ * Objects outside are skipped, and the others are clipped right after
+ * slicing.  By default, the whole layer is computed.
+ *
+ * If the rectangle is empty, i.e., if x0 >= x1 or y0 >= y1, the
+ * setting is not changed, and this returns false, and
+ * cp_slicer_error() returns the message.
+ */
+CP_SLICER_EXPORT
+extern bool cp_slicer_set_xy_window(
+    cp_slicer_t *s,
+    double x0,
+    double y0,
+    double x1,
+    double y1);
+
+/**
+ * Set the maximum number of polygon vertices of a circle (default: 100).
+ */
+CP_SLICER_EXPORT
+extern void cp_slicer_set_max_fn(
+    cp_slicer_t *s,
+    size_t max_fn);
+
+/**
+ * Set whether layers are triangulated (default: true).
+ */
+CP_SLICER_EXPORT
+extern void cp_slicer_set_tri(
+    cp_slicer_t *s,
+    bool tri);
+
+/**
+ * Set a callback that is invoked before reading a model and before
+ * computing each layer, or NULL for none (the default).
+ */
+CP_SLICER_EXPORT
+extern void cp_slicer_set_progress(
+    cp_slicer_t *s,
+    cp_slicer_progress_t func,
+    void *user);
+
+/**
+ * Set or clear the cancellation flag.
+ *
+ * This may be called from another thread or from a signal handler
+ * while the slicer is working.  When set, loading a model and
+ * computing layers fail with a 'Cancelled' error as soon as possible,
+ * also in the middle of a layer.  The flag stays set until it is
+ * cleared again.
+ */
+CP_SLICER_EXPORT
+extern void cp_slicer_set_cancel(
+    cp_slicer_t *s,
+    bool cancel);
+
+/**
+ * Load a model from a SCAD file, or from an STL file if the name ends
+ * in '.stl'.  Any previously loaded model is freed.
+ *
+ * On error, returns false, and cp_slicer_error() returns the message.
+ */
+CP_SLICER_EXPORT
+extern bool cp_slicer_load_file(
+    cp_slicer_t *s,
+    char const *file_name);
+
+/**
+ * Load a model from memory.  name is used in error messages, and as
+ * the base for relative 'use' and 'include' file names.  If it ends in
+ * '.stl', the data is read as an STL file.
+ *
+ * On error, returns false, and cp_slicer_error() returns the message.
+ */
+CP_SLICER_EXPORT
+extern bool cp_slicer_load_buffer(
+    cp_slicer_t *s,
+    char const *name,
+    void const *data,
+    size_t size);
+
+/**
+ * Returns the number of layers of the loaded model.
+ */
+CP_SLICER_EXPORT
+extern size_t cp_slicer_layer_cnt(
+    cp_slicer_t const *s);
+
+/**
+ * Compute layer zi of the loaded model.
+ *
+ * Layers can be computed in any order.  Only the current layer is kept
+ * in memory.
+ *
+ * On error, returns false, and cp_slicer_error() returns the message.
+ */
+CP_SLICER_EXPORT
+extern bool cp_slicer_get_layer(
+    cp_slicer_t *s,
+    size_t zi,
+    cp_slicer_layer_t *layer);
+
+/**
+ * Compute a layer of the loaded model at an arbitrary z coordinate,
+ * independent of the step and range settings.
+ *
+ * This does the work of a single layer: no other layers are computed
+ * or allocated.
+ *
+ * The result is valid as for cp_slicer_get_layer().
+ *
+ * On error, returns false, and cp_slicer_error() returns the message.
+ */
+CP_SLICER_EXPORT
+extern bool cp_slicer_get_layer_at(
+    cp_slicer_t *s,
+    double z,
+    cp_slicer_layer_t *layer);
+
+/**
+ * Returns the message of the last error, including the source
+ * location, or an empty string if there was no error.
+ */
+CP_SLICER_EXPORT
+extern char const *cp_slicer_error(
+    cp_slicer_t const *s);
+
+#endif /* __CP_SLICER_H */
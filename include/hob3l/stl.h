@@ -0,0 +1,42 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/**
+ * @file
+ * STL file reader.
+ *
+ * Both binary and ASCII STL files are read.  The triangle soup of the
+ * file is converted into a polyhedron by welding vertices that are
+ * closer than cp_pt_epsilon.
+ */
+
+#ifndef __CP_STL_H
+#define __CP_STL_H
+
+#include <stdio.h>
+#include <hob3lbase/err_tam.h>
+#include <hob3l/scad_tam.h>
+#include <hob3l/syn_tam.h>
+
+/**
+ * Read an STL file into a polyhedron.
+ *
+ * The file content is registered with the syntax tree so that
+ * locations of ASCII STL files can be reported in error messages.
+ * Locations of binary STL files refer to \a loc instead.
+ *
+ * The faces of the result are clockwise when viewed from the outside,
+ * like in SCAD polyhedra, i.e., the result can be processed like any
+ * polyhedron read from a SCAD file.
+ *
+ * On error, returns false and fills in err.
+ */
+extern bool cp_stl_parse(
+    cp_syn_tree_t *syn,
+    cp_err_t *err,
+    cp_scad_polyhedron_t *r,
+    cp_loc_t loc,
+    char const *filename,
+    FILE *file);
+
+#endif /* __CP_STL_H */
@@ -25,6 +25,24 @@
 /** Cast w/ dynamic check */
 #define cp_syn_try_cast(t, s) _cp_try_cast(cp_syn_typeof, t, s)
 
+/**
+ * Read a file into memory and append it to the list of files of the
+ * syntax tree, so that pointers into its content can be used as
+ * source locations.
+ *
+ * The content is NUL terminated and cut into lines, i.e., this
+ * sets up everything cp_syn_get_loc() needs.
+ *
+ * If fp is non-NULL, the new file entry is stored in *fp.
+ *
+ * On error, returns false and fills in r->err.
+ */
+extern bool cp_syn_read(
+    cp_syn_file_t **fp,
+    cp_syn_tree_t *r,
+    char const *filename,
+    FILE *file);
+
 /**
  * Parse a file into a SCAD syntax tree.
  */
@@ -33,6 +51,65 @@ extern bool cp_syn_parse(
     char const *filename,
     FILE *file);
 
+/**
+ * Parse a file statement by statement.
+ *
+ * After each top-level statement is parsed, tree->toplevel contains
+ * only that statement, and cb is invoked.  After cb returns, the
+ * statement is deleted and tree->toplevel is cleared again.  The
+ * file content is kept, so source locations remain valid.
+ *
+ * This way, the syntax tree of only one top-level statement is in
+ * memory at any time.
+ *
+ * On error, returns false and fills in r->err.
+ */
+extern bool cp_syn_parse_each(
+    cp_syn_tree_t *r,
+    char const *filename,
+    FILE *file,
+    cp_syn_stmt_cb_t cb,
+    void *user);
+
+/**
+ * Parse a library file referenced by 'use' or 'include'.
+ *
+ * Each file is parsed only once per process: the result is cached
+ * under the real path of the file and shared by all references and
+ * all syntax trees.  If the modification time or size of the file
+ * has changed, it is parsed again.  The file is added to r->file so
+ * that source locations inside it can be reported.
+ *
+ * loc is the location of the referencing statement.
+ *
+ * On success, *fp is set to the file, whose toplevel member
+ * contains the parsed statements.
+ *
+ * On error, returns false and fills in r->err.
+ */
+extern bool cp_syn_parse_lib(
+    cp_syn_file_t **fp,
+    cp_syn_tree_t *r,
+    cp_loc_t loc,
+    char const *filename);
+
+/**
+ * Delete a statement and all its sub-statements and values.
+ */
+extern void cp_syn_stmt_delete(
+    cp_syn_stmt_t *s);
+
+/**
+ * Delete all statements and files of a syntax tree.  The tree itself
+ * is not freed.
+ *
+ * Library files read via 'use' or 'include' stay in the process-wide
+ * cache for other syntax trees, unless they have changed on disk and
+ * no other tree uses them.
+ */
+extern void cp_syn_tree_fini(
+    cp_syn_tree_t *r);
+
 /**
  * Return a file location for a pointer to a token or any
  * other pointer into the file contents.
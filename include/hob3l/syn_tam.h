@@ -34,7 +34,8 @@ typedef CP_VEC_T(cp_syn_value_t*) cp_v_syn_value_p_t;
         cp_syn_value_array_t:  CP_SYN_VALUE_ARRAY, \
         cp_syn_stmt_t:         CP_SYN_STMT_TYPE, \
         cp_syn_stmt_item_t:    CP_SYN_STMT_ITEM, \
-        cp_syn_stmt_use_t:     CP_SYN_STMT_USE)
+        cp_syn_stmt_use_t:     CP_SYN_STMT_USE, \
+        cp_syn_stmt_include_t: CP_SYN_STMT_INCLUDE)
 
 /**
  * SCAD parser value type */
@@ -52,6 +53,7 @@ typedef enum {
 typedef enum {
     CP_SYN_STMT_ITEM = CP_SYN_STMT_TYPE + 1,
     CP_SYN_STMT_USE,
+    CP_SYN_STMT_INCLUDE,
 #if 0
     /* NYI: */
     CP_SYN_STMT_ASSIGN,
@@ -92,6 +94,14 @@ typedef struct {
     char const *path;
 } cp_syn_stmt_use_t;
 
+/**
+ * SCAD parser include statement.
+ */
+typedef struct {
+    CP_SYN_STMT_BASE
+    char const *path;
+} cp_syn_stmt_include_t;
+
 /**
  * SCAD parser argument to function.
  */
@@ -262,6 +272,12 @@ typedef struct {
      * first inclusion command.
      */
     char const *include_loc;
+
+    /**
+     * If this file was read as a library by 'use' or 'include',
+     * this is the list of its top-level statements.
+     */
+    cp_v_syn_stmt_p_t toplevel;
 } cp_syn_file_t;
 
 typedef CP_VEC_T(cp_syn_file_t *) cp_v_syn_file_p_t;
@@ -288,6 +304,17 @@ typedef struct {
     cp_err_t err;
 } cp_syn_tree_t;
 
+/**
+ * Callback for cp_syn_parse_each(), invoked for each top-level
+ * statement.
+ *
+ * Returns whether parsing should continue.  If false is returned,
+ * the callback should fill in tree->err.
+ */
+typedef bool (*cp_syn_stmt_cb_t)(
+    void *user,
+    cp_syn_tree_t *tree);
+
 /**
  * SCAD parser source location
  */
@@ -38,12 +38,76 @@
 #  define CP_LINE 0
 #endif
 
+/** Kind of memory for cp_alloc_count(): malloc() and friends */
+#define CP_ALLOC_HEAP 0
+
+/** Kind of memory for cp_alloc_count(): cp_pool_calloc() */
+#define CP_ALLOC_POOL 1
+
+/** Number of kinds of memory */
+#define CP_ALLOC_KIND_CNT 2
+
+/** Maximum number of stages for cp_alloc_stage() */
+#define CP_ALLOC_STAGE_MAX 16
+
+#ifdef CP_ALLOC_STATS
+
+/**
+ * Count an allocation of size bytes at the given call site.
+ *
+ * Call sites are only distinguished if CP_FILE and CP_LINE are
+ * defined, i.e., in builds without NDEBUG.
+ */
+extern void cp_alloc_count(
+    char const *file,
+    int line,
+    unsigned kind,
+    size_t size);
+
+/**
+ * Attribute all allocations since the previous call to the given stage.
+ *
+ * name must be a static string.  stage must be less than
+ * CP_ALLOC_STAGE_MAX.
+ */
+extern void cp_alloc_stage(
+    unsigned stage,
+    char const *name);
+
+/**
+ * Print the allocations by stage, module, and call site to stderr.
+ */
+extern void cp_alloc_print(void);
+
+#else
+
+static inline void cp_alloc_count(
+    char const *file __unused,
+    int line __unused,
+    unsigned kind __unused,
+    size_t size __unused)
+{
+}
+
+static inline void cp_alloc_stage(
+    unsigned stage __unused,
+    char const *name __unused)
+{
+}
+
+static inline void cp_alloc_print(void)
+{
+}
+
+#endif /* CP_ALLOC_STATS */
+
 static inline void *cp_malloc(char const *file, int line, size_t a)
 {
     void *r = malloc(a);
     if (r == NULL) {
         cp_panic(file, line, "Out of memory allocating %"_Pz"u bytes.", a);
     }
+    cp_alloc_count(file, line, CP_ALLOC_HEAP, a);
     return r;
 }
 
@@ -53,6 +117,7 @@ static inline void *cp_calloc(char const *file, int line, size_t a, size_t b)
     if (r == NULL) {
         cp_panic(file, line, "Out of memory allocating %"_Pz"u * %"_Pz"u bytes.", a, b);
     }
+    cp_alloc_count(file, line, CP_ALLOC_HEAP, a * b);
     return r;
 }
 
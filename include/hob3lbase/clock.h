@@ -0,0 +1,18 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+#ifndef __CP_CLOCK_H
+#define __CP_CLOCK_H
+
+/**
+ * Current wall clock time in seconds, from a monotonic clock, for
+ * measuring run time.
+ */
+extern double cp_clock_wall(void);
+
+/**
+ * CPU time used by the process in seconds.
+ */
+extern double cp_clock_cpu(void);
+
+#endif /* __CP_CLOCK_H */
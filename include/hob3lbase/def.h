@@ -7,6 +7,7 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <string.h>
+#include <strings.h>
 #include <assert.h>
 
 #include <math.h>
@@ -281,6 +282,17 @@ static inline char const *is_prefix(char const *haystack, char const *needle)
     return NULL;
 }
 
+/**
+ * Whether haystack ends in needle, ignoring case, e.g., for checking
+ * file name extensions.
+ */
+static inline bool has_suffix(char const *haystack, char const *needle)
+{
+    size_t len1 = strlen(haystack);
+    size_t len2 = strlen(needle);
+    return (len1 >= len2) && (strcasecmp(haystack + len1 - len2, needle) == 0);
+}
+
 static inline size_t cp_align_down(size_t n, size_t a)
 {
     assert((a != 0) && "Alignment is zero");
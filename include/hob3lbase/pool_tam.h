@@ -11,6 +11,24 @@ typedef struct cp_pool_block cp_pool_block_t;
 typedef struct {
     cp_pool_block_t *cur;
     size_t block_size;
+
+    /** Bytes allocated since the last cp_pool_clear() */
+    size_t used;
+
+    /** Maximum of 'used', i.e., the high-water mark */
+    size_t used_max;
+
+    /**
+     * Array elements allocated since the last cp_pool_clear().  Unlike
+     * 'used', this does not depend on the size of pointers.
+     */
+    size_t elem;
+
+    /** Maximum of 'elem' */
+    size_t elem_max;
+
+    /** Bytes of all blocks */
+    size_t block_total;
 } cp_pool_t;
 
 #endif /*__CP_POOL_H */
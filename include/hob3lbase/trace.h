@@ -0,0 +1,65 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/**
+ * @file
+ * Writer of spans in Chrome trace-event format, for viewing in
+ * Perfetto or chrome://tracing.
+ *
+ * A span is written as a single 'complete' event when it ends, so
+ * spans that are left early on error are simply missing.
+ *
+ * All functions accept t == NULL and then do nothing, so that callers
+ * need not check whether tracing is enabled.
+ */
+
+#ifndef __CP_TRACE_H
+#define __CP_TRACE_H
+
+#include <stdbool.h>
+#include <hob3lbase/trace_tam.h>
+
+/**
+ * Open a trace file.
+ *
+ * On error, returns false, and errno is set.
+ */
+extern bool cp_trace_open(
+    cp_trace_t *t,
+    char const *file_name);
+
+/**
+ * Finish and close the trace file.
+ *
+ * On error, returns false, and errno is set.
+ */
+extern bool cp_trace_close(
+    cp_trace_t *t);
+
+/**
+ * Current time in seconds, the start of a span, or 0 if t is NULL.
+ */
+extern double cp_trace_now(
+    cp_trace_t const *t);
+
+/**
+ * Write a span from t0 (as returned by cp_trace_now()) until now.
+ */
+extern void cp_trace_span(
+    cp_trace_t *t,
+    char const *name,
+    double t0);
+
+/**
+ * Write a span like cp_trace_span() with arguments.  args are the
+ * members of a JSON object, e.g. "\"zi\":%zu".
+ */
+__attribute__((format(printf,4,5)))
+extern void cp_trace_span_args(
+    cp_trace_t *t,
+    char const *name,
+    double t0,
+    char const *args,
+    ...);
+
+#endif /* __CP_TRACE_H */
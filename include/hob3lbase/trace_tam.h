@@ -0,0 +1,20 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+#ifndef __CP_TRACE_TAM_H
+#define __CP_TRACE_TAM_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+typedef struct cp_trace {
+    FILE *file;
+
+    /** Process ID, also used as thread ID */
+    unsigned pid;
+
+    /** Number of events written so far */
+    size_t event_cnt;
+} cp_trace_t;
+
+#endif /* __CP_TRACE_TAM_H */
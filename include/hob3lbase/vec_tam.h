@@ -31,6 +31,7 @@
 
 typedef CP_VEC_T(void) cp_v_t;
 typedef CP_VEC_T(size_t) cp_v_size_t;
+typedef CP_VEC_T(double) cp_v_double_t;
 
 typedef CP_ARR_T(double) cp_a_double_t;
 typedef CP_ARR_T(size_t) cp_a_size_t;
@@ -0,0 +1,255 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <hob3lbase/arith.h>
+#include <hob3lbase/alloc.h>
+
+#ifdef CP_ALLOC_STATS
+
+/**
+ * Maximum number of call sites, a power of 2.  If there are more, the
+ * rest are counted as one unknown site.
+ */
+#define SITE_MAX 4096
+
+/** Number of call sites printed by cp_alloc_print() */
+#define SITE_PRINT_MAX 30
+
+/**
+ * Number of calls and bytes allocated, per kind of memory.
+ */
+typedef struct {
+    size_t cnt[CP_ALLOC_KIND_CNT];
+    size_t size[CP_ALLOC_KIND_CNT];
+} count_t;
+
+typedef struct {
+    char const *file;
+    int line;
+    count_t c;
+} site_t;
+
+typedef struct {
+    char const *name;
+    count_t c;
+} stage_t;
+
+/**
+ * The counters are static so that counting never allocates.
+ */
+static struct {
+    /** Hash table of call sites, by file pointer and line */
+    site_t site[SITE_MAX];
+    size_t site_cnt;
+
+    /** Call sites that did not fit into 'site' */
+    site_t site_other;
+
+    /** Total of all allocations */
+    count_t total;
+
+    /** Value of total at the previous cp_alloc_stage() */
+    count_t total_staged;
+
+    stage_t stage[CP_ALLOC_STAGE_MAX];
+
+    /** Scratch space for cp_alloc_print() */
+    site_t sorted[SITE_MAX + 1];
+} a;
+
+static void count_add(
+    count_t *c,
+    unsigned kind,
+    size_t size)
+{
+    c->cnt[kind]++;
+    c->size[kind] += size;
+}
+
+static void count_add_diff(
+    count_t *c,
+    count_t const *x,
+    count_t const *y)
+{
+    for (cp_size_each(k, CP_ALLOC_KIND_CNT)) {
+        c->cnt[k] += x->cnt[k] - y->cnt[k];
+        c->size[k] += x->size[k] - y->size[k];
+    }
+}
+
+static void count_add_all(
+    count_t *c,
+    count_t const *x)
+{
+    count_add_diff(c, x, &(count_t){0});
+}
+
+static size_t count_size(
+    count_t const *c)
+{
+    return c->size[CP_ALLOC_HEAP] + c->size[CP_ALLOC_POOL];
+}
+
+static bool site_used(
+    site_t const *s)
+{
+    return (s->c.cnt[CP_ALLOC_HEAP] + s->c.cnt[CP_ALLOC_POOL]) > 0;
+}
+
+static site_t *site_get(
+    char const *file,
+    int line)
+{
+    size_t h = (((size_t)(uintptr_t)file >> 3) * 31) + (size_t)line;
+    for (;; h++) {
+        site_t *s = &a.site[h & (SITE_MAX - 1)];
+        if (!site_used(s)) {
+            /* keep the table half empty so that probing stays short */
+            if (a.site_cnt >= (SITE_MAX / 2)) {
+                return &a.site_other;
+            }
+            a.site_cnt++;
+            s->file = file;
+            s->line = line;
+            return s;
+        }
+        if ((s->file == file) && (s->line == line)) {
+            return s;
+        }
+    }
+}
+
+/**
+ * Count an allocation of size bytes at the given call site.
+ *
+ * Call sites are only distinguished if CP_FILE and CP_LINE are
+ * defined, i.e., in builds without NDEBUG.
+ */
+extern void cp_alloc_count(
+    char const *file,
+    int line,
+    unsigned kind,
+    size_t size)
+{
+    count_add(&site_get(file, line)->c, kind, size);
+    count_add(&a.total, kind, size);
+}
+
+/**
+ * Attribute all allocations since the previous call to the given stage.
+ *
+ * name must be a static string.  stage must be less than
+ * CP_ALLOC_STAGE_MAX.
+ */
+extern void cp_alloc_stage(
+    unsigned stage,
+    char const *name)
+{
+    assert(stage < CP_ALLOC_STAGE_MAX);
+    stage_t *s = &a.stage[stage];
+    s->name = name;
+    count_add_diff(&s->c, &a.total, &a.total_staged);
+    a.total_staged = a.total;
+}
+
+static int cmp_site_size(
+    void const *_x,
+    void const *_y)
+{
+    site_t const *x = _x;
+    site_t const *y = _y;
+    size_t sx = count_size(&x->c);
+    size_t sy = count_size(&y->c);
+    return (sx < sy) - (sx > sy);
+}
+
+static int cmp_site_file(
+    void const *_x,
+    void const *_y)
+{
+    site_t const *x = _x;
+    site_t const *y = _y;
+    if ((x->file == NULL) || (y->file == NULL)) {
+        return (x->file != NULL) - (y->file != NULL);
+    }
+    return strcmp(x->file, y->file);
+}
+
+static void count_print(
+    char const *name,
+    int line,
+    count_t const *c)
+{
+    if (line > 0) {
+        fprintf(stderr, "Alloc:   %s:%d:", name, line);
+    }
+    else {
+        fprintf(stderr, "Alloc:   %s:", name);
+    }
+    fprintf(stderr,
+        " heap %"_Pz"u bytes in %"_Pz"u calls, pool %"_Pz"u bytes in %"_Pz"u calls\n",
+        c->size[CP_ALLOC_HEAP], c->cnt[CP_ALLOC_HEAP],
+        c->size[CP_ALLOC_POOL], c->cnt[CP_ALLOC_POOL]);
+}
+
+/**
+ * Print the allocations by stage, module, and call site to stderr.
+ */
+extern void cp_alloc_print(void)
+{
+    fprintf(stderr, "Alloc: total, heap includes pool blocks:\n");
+    count_print("all", 0, &a.total);
+
+    fprintf(stderr, "Alloc: by stage:\n");
+    for (cp_arr_each(i, a.stage)) {
+        stage_t const *s = &a.stage[i];
+        if (s->name != NULL) {
+            count_print(s->name, 0, &s->c);
+        }
+    }
+    count_t other = {0};
+    count_add_diff(&other, &a.total, &a.total_staged);
+    count_print("other", 0, &other);
+
+    /* collect the sites */
+    size_t n = 0;
+    for (cp_arr_each(i, a.site)) {
+        if (site_used(&a.site[i])) {
+            a.sorted[n++] = a.site[i];
+        }
+    }
+    if (site_used(&a.site_other)) {
+        a.sorted[n] = a.site_other;
+        a.sorted[n].file = NULL;
+        a.sorted[n].line = 0;
+        n++;
+    }
+
+    /* modules: merge sites of the same file */
+    qsort(a.sorted, n, sizeof(a.sorted[0]), cmp_site_file);
+    fprintf(stderr, "Alloc: by module:\n");
+    for (size_t i = 0; i < n;) {
+        count_t c = {0};
+        size_t j = i;
+        for (; (j < n) && (cmp_site_file(&a.sorted[i], &a.sorted[j]) == 0); j++) {
+            count_add_all(&c, &a.sorted[j].c);
+        }
+        count_print(a.sorted[i].file ? a.sorted[i].file : "<unknown>", 0, &c);
+        i = j;
+    }
+
+    /* largest sites */
+    qsort(a.sorted, n, sizeof(a.sorted[0]), cmp_site_size);
+    size_t m = cp_min(n, SITE_PRINT_MAX);
+    fprintf(stderr, "Alloc: by call site, largest %"_Pz"u of %"_Pz"u:\n", m, n);
+    for (cp_size_each(i, m)) {
+        site_t const *s = &a.sorted[i];
+        count_print(s->file ? s->file : "<unknown>", s->line, &s->c);
+    }
+}
+
+#endif /* CP_ALLOC_STATS */
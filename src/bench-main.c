@@ -0,0 +1,29 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+#include <stdio.h>
+#include <hob3lbase/def.h>
+#include "bench.h"
+#include "csg2-bench.h"
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        char const *arg = argv[i];
+        if (strequ(arg, "--quick")) {
+            cp_bench_quick = true;
+        }
+        else if (arg[0] == '-') {
+            fprintf(stderr, "Usage: %s [--quick] [NAME]\n", argv[0]);
+            return 1;
+        }
+        else {
+            cp_bench_filter = arg;
+        }
+    }
+
+    cp_csg2_bench_bool();
+    cp_csg2_bench_tri();
+    cp_csg2_bench_layer();
+    return 0;
+}
@@ -0,0 +1,101 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "bench.h"
+
+bool cp_bench_quick = false;
+
+char const *cp_bench_filter = NULL;
+
+/**
+ * Start a series.  Returns false if the series is filtered out.
+ */
+extern bool cp_bench_begin(
+    cp_bench_t *b,
+    char const *name)
+{
+    CP_ZERO(b);
+    b->name = name;
+    return (cp_bench_filter == NULL) || (strstr(name, cp_bench_filter) != NULL);
+}
+
+/**
+ * Whether the current measurement needs another repetition.
+ */
+extern bool cp_bench_more(
+    cp_bench_t *b)
+{
+    if (b->rep < CP_BENCH_REP_MIN) {
+        return true;
+    }
+    return (b->rep < CP_BENCH_REP_MAX) && (b->t_sum < CP_BENCH_TIME_MIN);
+}
+
+/**
+ * Record the time of one repetition.
+ */
+extern void cp_bench_add(
+    cp_bench_t *b,
+    double time)
+{
+    if ((b->rep == 0) || (time < b->t_best)) {
+        b->t_best = time;
+    }
+    b->t_sum += time;
+    b->rep++;
+}
+
+/**
+ * Print the current measurement, with the amount of work in edges
+ * and a printf formatted description of the input, and start the
+ * next one.
+ */
+extern void cp_bench_result(
+    cp_bench_t *b,
+    size_t work,
+    char const *fmt,
+    ...)
+{
+    char param[80];
+    va_list va;
+    va_start(va, fmt);
+    vsnprintf(param, sizeof(param), fmt, va);
+    va_end(va);
+
+    double ns = (work == 0) ? 0 : (b->t_best * 1e9 / (double)work);
+    printf("BENCH: %-20s %-32s %9"_Pz"u edges %10.3f ms %9.1f ns/edge\n",
+        b->name, param, work, b->t_best * 1e3, ns);
+    fflush(stdout);
+
+    if ((work > 0) && (b->t_best > 0)) {
+        double x = log((double)work);
+        double y = log(b->t_best);
+        b->cnt++;
+        b->sx += x;
+        b->sy += y;
+        b->sxx += x * x;
+        b->sxy += x * y;
+    }
+    b->rep = 0;
+    b->t_best = 0;
+    b->t_sum = 0;
+}
+
+/**
+ * Print the scaling exponent of the series.
+ */
+extern void cp_bench_end(
+    cp_bench_t *b)
+{
+    double n = (double)b->cnt;
+    double d = (n * b->sxx) - (b->sx * b->sx);
+    if ((b->cnt < 2) || (d <= 0)) {
+        return;
+    }
+    double e = ((n * b->sxy) - (b->sx * b->sy)) / d;
+    printf("BENCH: %-20s scaling exponent %.2f\n", b->name, e);
+    fflush(stdout);
+}
@@ -0,0 +1,86 @@
+/* -*- Mode: C -*- */
+
+#ifndef __CP_BENCH_H
+#define __CP_BENCH_H
+
+#include <stdio.h>
+#include <hob3lbase/def.h>
+
+/** Minimum number of repetitions of a measurement */
+#define CP_BENCH_REP_MIN 3
+
+/** Maximum number of repetitions of a measurement */
+#define CP_BENCH_REP_MAX 1000
+
+/** Repeat a measurement until this many seconds have been spent */
+#define CP_BENCH_TIME_MIN 0.2
+
+/**
+ * A series of measurements of one kernel with growing input size.
+ *
+ * For each size, the kernel is repeated and the best time is taken.
+ * At the end of the series, the scaling exponent b of time = a * work^b
+ * is computed by a least squares fit of the logarithms.
+ */
+typedef struct {
+    char const *name;
+
+    /** repetitions of the current measurement */
+    size_t rep;
+    double t_best;
+    double t_sum;
+
+    /** sums for least squares fit of log(time) over log(work) */
+    size_t cnt;
+    double sx, sy, sxx, sxy;
+} cp_bench_t;
+
+/**
+ * If set, kernels use smaller input sizes.
+ */
+extern bool cp_bench_quick;
+
+/**
+ * If non-NULL, only series whose name contains this string are run.
+ */
+extern char const *cp_bench_filter;
+
+/**
+ * Start a series.  Returns false if the series is filtered out.
+ */
+extern bool cp_bench_begin(
+    cp_bench_t *b,
+    char const *name);
+
+/**
+ * Whether the current measurement needs another repetition.
+ */
+extern bool cp_bench_more(
+    cp_bench_t *b);
+
+/**
+ * Record the time of one repetition.
+ */
+extern void cp_bench_add(
+    cp_bench_t *b,
+    double time);
+
+/**
+ * Print the current measurement, with the amount of work in edges
+ * and a printf formatted description of the input, and start the
+ * next one.
+ */
+__attribute__((format(printf,3,4)))
+extern void cp_bench_result(
+    cp_bench_t *b,
+    size_t work,
+    char const *fmt,
+    ...);
+
+/**
+ * Print the scaling exponent of the series.
+ */
+extern void cp_bench_end(
+    cp_bench_t *b);
+
+#endif /* __CP_BENCH_H */
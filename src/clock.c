@@ -0,0 +1,33 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/* for clock_gettime() */
+#define _GNU_SOURCE
+
+#include <time.h>
+#include <hob3lbase/clock.h>
+
+static double clock_sec(
+    clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+/**
+ * Current wall clock time in seconds, from a monotonic clock, for
+ * measuring run time.
+ */
+extern double cp_clock_wall(void)
+{
+    return clock_sec(CLOCK_MONOTONIC);
+}
+
+/**
+ * CPU time used by the process in seconds.
+ */
+extern double cp_clock_cpu(void)
+{
+    return clock_sec(CLOCK_PROCESS_CPUTIME_ID);
+}
@@ -0,0 +1,92 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+#include <hob3lbase/vec.h>
+#include <hob3lbase/alloc.h>
+#include <hob3lbase/dict.h>
+#include <hob3l/csg-prof.h>
+#include "internal.h"
+
+static int loc_cmp(
+    cp_loc_t *a,
+    cp_dict_t *_b,
+    void *user __unused)
+{
+    cp_csg_prof_loc_t const *b = CP_BOX_OF(_b, cp_csg_prof_loc_t, node);
+    return (*a < b->loc) ? -1 : (*a > b->loc) ? +1 : 0;
+}
+
+/**
+ * Get the entry for a location, adding a new one if there is none.
+ */
+extern cp_csg_prof_loc_t *cp_csg_prof_get(
+    cp_csg_prof_t *p,
+    cp_loc_t loc)
+{
+    if ((p->last != NULL) && (p->last->loc == loc)) {
+        return p->last;
+    }
+    cp_dict_ref_t ref;
+    cp_dict_t *n = cp_dict_find_ref(&ref, &loc, p->loc, loc_cmp, NULL, 0);
+    cp_csg_prof_loc_t *e = CP_BOX0_OF(n, cp_csg_prof_loc_t, node);
+    if (e == NULL) {
+        e = CP_NEW(*e);
+        e->loc = loc;
+        cp_dict_insert_ref(&e->node, &ref, &p->loc);
+    }
+    p->last = e;
+    return e;
+}
+
+/**
+ * Count an event of the current boolean sweep.
+ */
+extern void cp_csg_prof_event(
+    cp_csg_prof_t *p,
+    cp_loc_t loc)
+{
+    cp_csg_prof_loc_t *e = cp_csg_prof_get(p, loc);
+    if (e->cur_event_cnt == 0) {
+        cp_v_push(&p->cur, e);
+    }
+    e->cur_event_cnt++;
+    e->event_cnt++;
+}
+
+/**
+ * End the current boolean sweep: split its run time among the
+ * locations of its events.
+ */
+extern void cp_csg_prof_sweep_end(
+    cp_csg_prof_t *p,
+    double time)
+{
+    size_t total = 0;
+    for (cp_v_each(i, &p->cur)) {
+        total += cp_v_nth(&p->cur, i)->cur_event_cnt;
+    }
+    for (cp_v_each(i, &p->cur)) {
+        cp_csg_prof_loc_t *e = cp_v_nth(&p->cur, i);
+        e->time_sweep += time * (double)e->cur_event_cnt / (double)total;
+        e->cur_event_cnt = 0;
+    }
+    cp_v_clear(&p->cur, 0);
+}
+
+/**
+ * Free all entries.
+ */
+extern void cp_csg_prof_fini(
+    cp_csg_prof_t *p)
+{
+    for (;;) {
+        cp_dict_t *n = cp_dict_extract_min(&p->loc);
+        if (n == NULL) {
+            break;
+        }
+        cp_csg_prof_loc_t *e = CP_BOX_OF(n, cp_csg_prof_loc_t, node);
+        CP_FREE(e);
+    }
+    cp_v_fini(&p->cur);
+    CP_ZERO(p);
+}
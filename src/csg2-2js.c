@@ -38,7 +38,7 @@ typedef struct {
     unsigned short i[3];
 } u16_3_t;
 
-typedef struct {
+typedef struct cp_csg2_js {
     vertex_t v[VERTEX_CNT];
     size_t v_cnt;
     u16_3_t tri[VERTEX_CNT];
@@ -536,3 +536,56 @@ extern void cp_csg2_tree_put_js(
 
     CP_FREE(c);
 }
+
+/**
+ * Begin printing a JavaScript file layer by layer.
+ *
+ * After this, cp_csg2_tree_put_js_layer() prints the layers in
+ * order, and cp_csg2_tree_put_js_end() finishes the file.  The
+ * result is the same as with cp_csg2_tree_put_js().
+ *
+ * The vertices of several layers are collected into one scene
+ * object, so the returned context holds data until it is
+ * flushed.  It is freed by cp_csg2_tree_put_js_end().
+ */
+extern cp_csg2_js_t *cp_csg2_tree_put_js_begin(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t)
+{
+    ctxt_t *c = CP_NEW(*c);
+    c->tree = t;
+    scene_flush(c, s);
+    return c;
+}
+
+/**
+ * Print a single layer of a JavaScript file.
+ *
+ * The tree root must be a single stack, as constructed by
+ * cp_csg2_op_tree_init().
+ */
+extern void cp_csg2_tree_put_js_layer(
+    cp_csg2_js_t *c,
+    cp_stream_t *s,
+    size_t zi)
+{
+    cp_csg2_tree_t *t = c->tree;
+    cp_csg2_stack_t *r = cp_csg2_cast(*r, t->root);
+    cp_csg2_layer_t *l = cp_csg2_stack_get_layer(r, zi);
+    if (l != NULL) {
+        layer_put_js(c, s, t, zi, l);
+    }
+}
+
+/**
+ * Finish printing a JavaScript file layer by layer.
+ *
+ * This frees c.
+ */
+extern void cp_csg2_tree_put_js_end(
+    cp_csg2_js_t *c,
+    cp_stream_t *s)
+{
+    scene_flush(c, s);
+    CP_FREE(c);
+}
@@ -249,3 +249,53 @@ extern void cp_csg2_tree_put_scad(
         csg2_put_scad(s, t, 0, 0, t->root);
     }
 }
+
+/**
+ * Begin printing a scad file layer by layer.
+ *
+ * After this, cp_csg2_tree_put_scad_layer() prints the layers in
+ * order, and cp_csg2_tree_put_scad_end() finishes the file.  The
+ * result is the same as with cp_csg2_tree_put_scad().
+ *
+ * The tree root must be a single stack, as constructed by
+ * cp_csg2_op_tree_init().
+ */
+extern void cp_csg2_tree_put_scad_begin(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t)
+{
+    cp_csg2_stack_t *r = cp_csg2_cast(*r, t->root);
+    if (r->layer.size == 0) {
+        return;
+    }
+    cp_printf(s, "group(){\n");
+}
+
+/**
+ * Print a single layer of a scad file.
+ */
+extern void cp_csg2_tree_put_scad_layer(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t,
+    size_t zi)
+{
+    cp_csg2_stack_t *r = cp_csg2_cast(*r, t->root);
+    cp_csg2_layer_t *l = cp_csg2_stack_get_layer(r, zi);
+    if (l != NULL) {
+        layer_put_scad(s, t, IND, zi, l);
+    }
+}
+
+/**
+ * Finish printing a scad file layer by layer.
+ */
+extern void cp_csg2_tree_put_scad_end(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t)
+{
+    cp_csg2_stack_t *r = cp_csg2_cast(*r, t->root);
+    if (r->layer.size == 0) {
+        return;
+    }
+    cp_printf(s, "}\n");
+}
@@ -261,9 +261,51 @@ extern void cp_csg2_tree_put_stl(
     cp_stream_t *s,
     cp_csg2_tree_t *t)
 {
-    cp_printf(s, "solid model\n");
+    cp_csg2_tree_put_stl_begin(s, t);
     if (t->root != NULL) {
         csg2_put_stl(s, t, 0, t->root);
     }
+    cp_csg2_tree_put_stl_end(s, t);
+}
+
+/**
+ * Begin printing an STL file layer by layer.
+ *
+ * After this, cp_csg2_tree_put_stl_layer() prints the layers in
+ * order, and cp_csg2_tree_put_stl_end() finishes the file.  The
+ * result is the same as with cp_csg2_tree_put_stl().
+ */
+extern void cp_csg2_tree_put_stl_begin(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t __unused)
+{
+    cp_printf(s, "solid model\n");
+}
+
+/**
+ * Print a single layer of an STL file.
+ *
+ * The tree root must be a single stack, as constructed by
+ * cp_csg2_op_tree_init().
+ */
+extern void cp_csg2_tree_put_stl_layer(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t,
+    size_t zi)
+{
+    cp_csg2_stack_t *r = cp_csg2_cast(*r, t->root);
+    cp_csg2_layer_t *l = cp_csg2_stack_get_layer(r, zi);
+    if (l != NULL) {
+        layer_put_stl(s, t, zi, l);
+    }
+}
+
+/**
+ * Finish printing an STL file layer by layer.
+ */
+extern void cp_csg2_tree_put_stl_end(
+    cp_stream_t *s,
+    cp_csg2_tree_t *t __unused)
+{
     cp_printf(s, "endsolid model\n");
 }
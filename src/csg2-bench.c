@@ -0,0 +1,634 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/* for fmemopen() */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <hob3lbase/arith.h>
+#include <hob3lbase/vec.h>
+#include <hob3lbase/pool.h>
+#include <hob3lbase/alloc.h>
+#include <hob3lbase/vchar.h>
+#include <hob3lbase/clock.h>
+#include <hob3l/syn.h>
+#include <hob3l/scad.h>
+#include <hob3l/csg.h>
+#include <hob3l/csg3.h>
+#include <hob3l/csg2.h>
+#include "bench.h"
+#include "csg2-bench.h"
+
+/** Maximum number of polygons combined in one sweep benchmark */
+#define POLY_MAX 64
+
+/** Number of layers of the slicing benchmarks */
+#define LAYER_CNT 64
+
+typedef struct {
+    size_t size;
+    cp_csg2_poly_t *data[POLY_MAX];
+} poly_set_t;
+
+/** Generator for polygons with n edges in total and m operands */
+typedef void (*make_t)(poly_set_t *, size_t n, size_t m);
+
+static unsigned long rand_state;
+
+/**
+ * Deterministic pseudo random number in [0,1).
+ */
+static double rand_f(void)
+{
+    rand_state = (rand_state * 6364136223846793005UL) + 1442695040888963407UL;
+    return (double)(rand_state >> 11) / (double)(1UL << 53);
+}
+
+static cp_csg_opt_t opt_default(
+    cp_csg_stat_t *stat)
+{
+    return (cp_csg_opt_t){
+        .max_simultaneous = CP_CSG2_MAX_LAZY,
+        .optimise = CP_CSG2_OPT_DEFAULT,
+        .max_fn = 100,
+        .layer_gap = -1,
+        .stat = stat,
+    };
+}
+
+static cp_csg2_poly_t *poly_push(
+    poly_set_t *s)
+{
+    assert(s->size < cp_countof(s->data));
+    cp_csg2_poly_t *p = cp_csg2_new(*p, NULL);
+    s->data[s->size++] = p;
+    return p;
+}
+
+static void poly_set_fini(
+    poly_set_t *s)
+{
+    for (cp_size_each(i, s->size)) {
+        cp_csg2_delete(cp_csg2_cast(cp_csg2_t, s->data[i]));
+    }
+    CP_ZERO(s);
+}
+
+static void point_add(
+    cp_csg2_poly_t *p,
+    cp_csg2_path_t *q,
+    double x,
+    double y)
+{
+    cp_v_push(&q->point_idx, p->point.size);
+    cp_vec2_loc_t *v = cp_v_push0(&p->point);
+    v->coord.x = x;
+    v->coord.y = y;
+}
+
+/**
+ * Add a path of n points around (x,y).  Even points have radius r0, odd
+ * ones have radius r1, and each radius is reduced by a random amount
+ * of up to 'jitter'.
+ */
+static void path_add_star(
+    cp_csg2_poly_t *p,
+    double x,
+    double y,
+    double r0,
+    double r1,
+    double jitter,
+    size_t n)
+{
+    cp_csg2_path_t *q = cp_v_push0(&p->path);
+    for (cp_size_each(i, n)) {
+        double a = (2 * CP_PI * (double)i) / (double)n;
+        double r = (i & 1) ? r1 : r0;
+        r -= jitter * rand_f();
+        point_add(p, q, x + (r * cos(a)), y + (r * sin(a)));
+    }
+}
+
+static void path_add_rect(
+    cp_csg2_poly_t *p,
+    double x0,
+    double y0,
+    double x1,
+    double y1)
+{
+    cp_csg2_path_t *q = cp_v_push0(&p->path);
+    point_add(p, q, x0, y0);
+    point_add(p, q, x1, y0);
+    point_add(p, q, x1, y1);
+    point_add(p, q, x0, y1);
+}
+
+static void point_add_swap(
+    cp_csg2_poly_t *p,
+    cp_csg2_path_t *q,
+    double x,
+    double y,
+    bool swap)
+{
+    if (swap) {
+        point_add(p, q, y, x);
+    }
+    else {
+        point_add(p, q, x, y);
+    }
+}
+
+/**
+ * A comb at (x,y) with t teeth of width 1 and length h on a base of
+ * height 1.  If swap is set, x and y are swapped to get teeth along
+ * the x axis.
+ */
+static void path_add_comb(
+    cp_csg2_poly_t *p,
+    double x,
+    double y,
+    size_t t,
+    double h,
+    bool swap)
+{
+    cp_csg2_path_t *q = cp_v_push0(&p->path);
+    double l = (double)(2*t - 1);
+    point_add_swap(p, q, x,     y, swap);
+    point_add_swap(p, q, x + l, y, swap);
+    for (size_t i = t; i-- > 0;) {
+        double x_r = x + (double)(2*i + 1);
+        double x_l = x + (double)(2*i);
+        point_add_swap(p, q, x_r, y + h, swap);
+        point_add_swap(p, q, x_l, y + h, swap);
+        if (i > 0) {
+            point_add_swap(p, q, x_l,     y + 1, swap);
+            point_add_swap(p, q, x_l - 1, y + 1, swap);
+        }
+    }
+}
+
+/*
+ * m random star shaped polygons with n/m edges each, overlapping.
+ *
+ * The radius grows with the number of edges so that the edges stay
+ * long compared to cp_pt_epsilon, like in real models.
+ */
+static void make_random(
+    poly_set_t *s,
+    size_t n,
+    size_t m)
+{
+    double r = (double)(n / m);
+    for (cp_size_each(i, m)) {
+        double x = r * 0.2 * rand_f();
+        double y = r * 0.2 * rand_f();
+        path_add_star(poly_push(s), x, y, r, r, 3, n / m);
+    }
+}
+
+/* m circles with n/m edges each, centered on a circle so they all overlap */
+static void make_circles(
+    poly_set_t *s,
+    size_t n,
+    size_t m)
+{
+    double r = (double)(n / m);
+    for (cp_size_each(i, m)) {
+        double a = (2 * CP_PI * (double)i) / (double)m;
+        path_add_star(poly_push(s), r * 0.5 * cos(a), r * 0.5 * sin(a), r, r, 0, n / m);
+    }
+}
+
+/* two crossed combs with about n/8 teeth each: quadratic number of intersections */
+static void make_comb(
+    poly_set_t *s,
+    size_t n,
+    size_t m __unused)
+{
+    size_t t = cp_max(n / 8, 1);
+    double h = (double)(2 * t);
+    path_add_comb(poly_push(s), 0,   0,   t, h, false);
+    path_add_comb(poly_push(s), 0.5, 0.5, t, h, true);
+}
+
+/* a plate and a grid of about n/4 square holes to be subtracted */
+static void make_grid(
+    poly_set_t *s,
+    size_t n,
+    size_t m __unused)
+{
+    double k_f = sqrt((double)n / 4);
+    size_t k = cp_max((size_t)k_f, 1);
+    double l = (double)(2*k + 1);
+    path_add_rect(poly_push(s), 0, 0, l, l);
+    cp_csg2_poly_t *p = poly_push(s);
+    for (cp_size_each(i, k)) {
+        for (cp_size_each(j, k)) {
+            double x = (double)(2*i + 1);
+            double y = (double)(2*j + 1);
+            path_add_rect(p, x, y, x + 1, y + 1);
+        }
+    }
+}
+
+static size_t poly_set_edge_cnt(
+    poly_set_t const *s)
+{
+    size_t e = 0;
+    for (cp_size_each(i, s->size)) {
+        e += s->data[i]->point.size;
+    }
+    return e;
+}
+
+/**
+ * Time the combination of the generated polygons with op, i.e.,
+ * p[0] op p[1] op ... op p[m-1], by cp_csg2_op_lazy() and
+ * cp_csg2_op_reduce().
+ */
+static void bool_run(
+    cp_bench_t *b,
+    make_t make,
+    size_t n,
+    size_t m,
+    cp_bool_op_t op)
+{
+    cp_csg_stat_t stat = {0};
+    size_t edge_cnt = 0;
+    while (cp_bench_more(b)) {
+        rand_state = 1;
+        poly_set_t s = {0};
+        make(&s, n, m);
+        edge_cnt = poly_set_edge_cnt(&s);
+
+        CP_ZERO(&stat);
+        cp_csg_opt_t opt = opt_default(&stat);
+        cp_pool_t tmp;
+        cp_pool_init(&tmp, 0);
+
+        double t0 = cp_clock_wall();
+        cp_csg2_lazy_t r = {0};
+        for (cp_size_each(i, s.size)) {
+            cp_csg2_lazy_t o = {
+                .size = 1,
+                .data = { s.data[i] },
+                .comb.b = { 2 },
+            };
+            if (i == 0) {
+                r = o;
+            }
+            else {
+                cp_csg2_op_lazy(&opt, &tmp, &r, &o, op);
+            }
+        }
+        cp_csg2_op_reduce(&opt, &tmp, &r);
+        cp_bench_add(b, cp_clock_wall() - t0);
+
+        cp_pool_fini(&tmp);
+        poly_set_fini(&s);
+    }
+    cp_bench_result(b, edge_cnt,
+        "n=%"_Pz"u m=%"_Pz"u ev=%"_Pz"u is=%"_Pz"u",
+        n, m, stat.event_cnt, stat.intersection_cnt);
+}
+
+static void bool_series(
+    char const *name,
+    make_t make,
+    size_t m,
+    cp_bool_op_t op,
+    size_t n_max)
+{
+    cp_bench_t b;
+    if (!cp_bench_begin(&b, name)) {
+        return;
+    }
+    if (cp_bench_quick) {
+        n_max = 1024;
+    }
+    for (size_t n = 256; n <= n_max; n *= 4) {
+        bool_run(&b, make, n, m, op);
+    }
+    cp_bench_end(&b);
+}
+
+/**
+ * Micro-benchmarks of the boolean sweep on generated polygons.
+ */
+extern void cp_csg2_bench_bool(void)
+{
+    /* larger random inputs run into the 'Odd number of edges' assertion */
+    bool_series("bool random m=2",  make_random,  2, CP_OP_ADD, 16384);
+    bool_series("bool random m=8",  make_random,  8, CP_OP_ADD, 16384);
+    bool_series("bool circles m=2", make_circles, 2, CP_OP_ADD, 65536);
+    bool_series("bool circles m=8", make_circles, 8, CP_OP_ADD, 65536);
+    bool_series("bool comb",        make_comb,    2, CP_OP_ADD, 4096);
+    bool_series("bool grid",        make_grid,    2, CP_OP_SUB, 65536);
+
+    /* vary the number of operands for a fixed total size */
+    cp_bench_t b;
+    if (cp_bench_begin(&b, "bool circles n=4096")) {
+        size_t m_max = cp_bench_quick ? 8 : POLY_MAX;
+        for (size_t m = 2; m <= m_max; m *= 2) {
+            bool_run(&b, make_circles, 4096, m, CP_OP_ADD);
+        }
+        cp_bench_end(&b);
+    }
+}
+
+/* a regular n-gon */
+static void make_convex(
+    poly_set_t *s,
+    size_t n,
+    size_t m __unused)
+{
+    path_add_star(poly_push(s), 0, 0, (double)n, (double)n, 0, n);
+}
+
+/* a star with n/2 spikes */
+static void make_star(
+    poly_set_t *s,
+    size_t n,
+    size_t m __unused)
+{
+    path_add_star(poly_push(s), 0, 0, (double)n, (double)n * 0.3, 0, n);
+}
+
+/* a plate with a grid of about n/4 square holes */
+static void make_holes(
+    poly_set_t *s,
+    size_t n,
+    size_t m __unused)
+{
+    double k_f = sqrt((double)n / 4);
+    size_t k = cp_max((size_t)k_f, 1);
+    double l = (double)(2*k + 1);
+    cp_csg2_poly_t *p = poly_push(s);
+    path_add_rect(p, 0, 0, l, l);
+    for (cp_size_each(i, k)) {
+        for (cp_size_each(j, k)) {
+            double x = (double)(2*i + 1);
+            double y = (double)(2*j + 1);
+            path_add_rect(p, x, y, x + 1, y + 1);
+        }
+    }
+}
+
+static void tri_series(
+    char const *name,
+    make_t make)
+{
+    cp_bench_t b;
+    if (!cp_bench_begin(&b, name)) {
+        return;
+    }
+    /* larger inputs exceed the maximum allocation of the default pool */
+    size_t n_max = cp_bench_quick ? 1024 : 8192;
+    for (size_t n = 256; n <= n_max; n *= 2) {
+        rand_state = 1;
+        poly_set_t s = {0};
+        make(&s, n, 1);
+        cp_csg2_poly_t *p = s.data[0];
+        while (cp_bench_more(&b)) {
+            cp_v_clear(&p->triangle, 0);
+            cp_err_t err = {0};
+            cp_pool_t tmp;
+            cp_pool_init(&tmp, 0);
+
+            double t0 = cp_clock_wall();
+            bool ok = cp_csg2_tri_poly(NULL, &tmp, &err, p);
+            cp_bench_add(&b, cp_clock_wall() - t0);
+
+            cp_pool_fini(&tmp);
+            if (!ok) {
+                fprintf(stderr, "Error: %s: triangulation failed: %s\n",
+                    name, err.msg.data ? err.msg.data : "");
+                exit(1);
+            }
+        }
+        cp_bench_result(&b, p->point.size,
+            "n=%"_Pz"u tri=%"_Pz"u", n, p->triangle.size);
+        poly_set_fini(&s);
+    }
+    cp_bench_end(&b);
+}
+
+/**
+ * Micro-benchmarks of the triangulation on generated polygons.
+ */
+extern void cp_csg2_bench_tri(void)
+{
+    tri_series("tri convex", make_convex);
+    tri_series("tri star",   make_star);
+    tri_series("tri holes",  make_holes);
+}
+
+static void scad_polyhedron_begin(
+    cp_vchar_t *s)
+{
+    cp_vchar_clear(s);
+    cp_vchar_printf(s, "polyhedron(points=[");
+}
+
+static void scad_point(
+    cp_vchar_t *s,
+    double x,
+    double y,
+    double z)
+{
+    cp_vchar_printf(s, "[%.12g,%.12g,%.12g],", x, y, z);
+}
+
+static void scad_faces(
+    cp_vchar_t *s)
+{
+    /* replace the trailing ',' */
+    s->data[s->size - 1] = ']';
+    cp_vchar_printf(s, ",faces=[");
+}
+
+static void scad_face3(
+    cp_vchar_t *s,
+    size_t a,
+    size_t b,
+    size_t c)
+{
+    cp_vchar_printf(s, "[%"_Pz"u,%"_Pz"u,%"_Pz"u],", a, b, c);
+}
+
+static void scad_face4(
+    cp_vchar_t *s,
+    size_t a,
+    size_t b,
+    size_t c,
+    size_t d)
+{
+    cp_vchar_printf(s, "[%"_Pz"u,%"_Pz"u,%"_Pz"u,%"_Pz"u],", a, b, c, d);
+}
+
+static void scad_polyhedron_end(
+    cp_vchar_t *s)
+{
+    s->data[s->size - 1] = ']';
+    cp_vchar_printf(s, ");\n");
+}
+
+/**
+ * A sphere polyhedron with n segments and n/2 rings, like OpenSCAD
+ * exports it.  Returns the number of edges.
+ */
+static size_t scad_sphere(
+    cp_vchar_t *s,
+    size_t n)
+{
+    size_t m = n / 2;
+    double r = 10;
+    scad_polyhedron_begin(s);
+    scad_point(s, 0, 0, r);
+    for (size_t j = 1; j < m; j++) {
+        double b = (CP_PI * (double)j) / (double)m;
+        for (cp_size_each(i, n)) {
+            double a = (2 * CP_PI * (double)i) / (double)n;
+            scad_point(s, r * sin(b) * cos(a), r * sin(b) * sin(a), r * cos(b));
+        }
+    }
+    scad_point(s, 0, 0, -r);
+    scad_faces(s);
+    size_t bottom = 1 + (n * (m - 1));
+#define RING(j,i) (1 + ((j) * n) + ((i) % n))
+    for (cp_size_each(i, n)) {
+        scad_face3(s, 0, RING(0, i+1), RING(0, i));
+        for (size_t j = 0; (j + 1) < (m - 1); j++) {
+            scad_face4(s, RING(j, i), RING(j, i+1), RING(j+1, i+1), RING(j+1, i));
+        }
+        scad_face3(s, bottom, RING(m-2, i), RING(m-2, i+1));
+    }
+#undef RING
+    scad_polyhedron_end(s);
+    return (n * (m - 1)) + (n * m);
+}
+
+/**
+ * A torus polyhedron with n segments around and n/2 around the tube.
+ * Returns the number of edges.
+ */
+static size_t scad_torus(
+    cp_vchar_t *s,
+    size_t n)
+{
+    size_t m = n / 2;
+    double r0 = 10;
+    double r1 = 3;
+    scad_polyhedron_begin(s);
+    for (cp_size_each(i, n)) {
+        double a = (2 * CP_PI * (double)i) / (double)n;
+        for (cp_size_each(j, m)) {
+            double b = (2 * CP_PI * (double)j) / (double)m;
+            double r = r0 + (r1 * cos(b));
+            scad_point(s, r * cos(a), r * sin(a), r1 * sin(b));
+        }
+    }
+    scad_faces(s);
+#define PT(i,j) ((((i) % n) * m) + ((j) % m))
+    for (cp_size_each(i, n)) {
+        for (cp_size_each(j, m)) {
+            scad_face4(s, PT(i, j), PT(i, j+1), PT(i+1, j+1), PT(i+1, j));
+        }
+    }
+#undef PT
+    scad_polyhedron_end(s);
+    return 2 * n * m;
+}
+
+/**
+ * Time slicing a model into LAYER_CNT layers with
+ * cp_csg2_tree_add_layer().  The work is the number of polyhedron
+ * edges times the number of layers.
+ */
+static void layer_run(
+    cp_bench_t *b,
+    cp_vchar_t *text,
+    size_t edge_cnt,
+    size_t n)
+{
+    cp_csg_opt_t opt = opt_default(NULL);
+    cp_syn_tree_t syn = {0};
+    cp_scad_tree_t scad = {0};
+    cp_csg3_tree_t csg3 = { .opt = &opt };
+    cp_csg2_tree_t csg2 = {0};
+    cp_pool_t pool;
+    cp_pool_init(&pool, 0);
+
+    FILE *f = fmemopen(text->data, text->size, "rb");
+    assert(f != NULL);
+    bool ok =
+        cp_syn_parse(&syn, b->name, f) &&
+        cp_scad_from_syn_tree(&scad, &syn) &&
+        cp_csg3_from_scad_tree(&pool, &syn, &csg3, &syn.err, &scad);
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "Error: %s: %s\n", b->name, syn.err.msg.data);
+        exit(1);
+    }
+
+    cp_vec3_minmax_t bb = CP_VEC3_MINMAX_EMPTY;
+    cp_csg3_tree_bb(&bb, &csg3, false);
+    cp_dim_t step = (bb.max.z - bb.min.z) / LAYER_CNT;
+    cp_range_t range;
+    cp_range_init(&range, bb.min.z + (step / 2), bb.max.z, step);
+    cp_csg2_tree_from_csg3(&csg2, &csg3, &range, &opt);
+
+    while (cp_bench_more(b)) {
+        double t = 0;
+        for (cp_size_each(zi, range.cnt)) {
+            cp_pool_clear(&pool);
+            double t0 = cp_clock_wall();
+            ok = cp_csg2_tree_add_layer(&pool, &csg2, &syn.err, zi);
+            t += cp_clock_wall() - t0;
+            if (!ok) {
+                fprintf(stderr, "Error: %s: %s\n", b->name, syn.err.msg.data);
+                exit(1);
+            }
+            cp_csg2_tree_delete_layer(&csg2, zi);
+        }
+        cp_bench_add(b, t);
+    }
+    cp_bench_result(b, edge_cnt * range.cnt,
+        "n=%"_Pz"u layers=%"_Pz"u", n, range.cnt);
+
+    cp_csg2_tree_fini(&csg2);
+    cp_csg3_tree_fini(&csg3);
+    cp_scad_tree_fini(&scad);
+    cp_syn_tree_fini(&syn);
+    cp_pool_fini(&pool);
+}
+
+static void layer_series(
+    char const *name,
+    size_t (*make)(cp_vchar_t *, size_t))
+{
+    cp_bench_t b;
+    if (!cp_bench_begin(&b, name)) {
+        return;
+    }
+    cp_vchar_t text;
+    cp_vchar_init(&text);
+    size_t n_max = cp_bench_quick ? 64 : 512;
+    for (size_t n = 32; n <= n_max; n *= 2) {
+        size_t edge_cnt = make(&text, n);
+        layer_run(&b, &text, edge_cnt, n);
+    }
+    cp_vchar_fini(&text);
+    cp_bench_end(&b);
+}
+
+/**
+ * Micro-benchmarks of slicing generated polyhedra into layers.
+ */
+extern void cp_csg2_bench_layer(void)
+{
+    layer_series("layer sphere", scad_sphere);
+    layer_series("layer torus",  scad_torus);
+}
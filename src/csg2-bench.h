@@ -0,0 +1,21 @@
+/* -*- Mode: C -*- */
+
+#ifndef __CP_CSG2_BENCH_H
+#define __CP_CSG2_BENCH_H
+
+/**
+ * Micro-benchmarks of the boolean sweep on generated polygons.
+ */
+extern void cp_csg2_bench_bool(void);
+
+/**
+ * Micro-benchmarks of the triangulation on generated polygons.
+ */
+extern void cp_csg2_bench_tri(void);
+
+/**
+ * Micro-benchmarks of slicing generated polyhedra into layers.
+ */
+extern void cp_csg2_bench_layer(void);
+
+#endif /* __CP_CSG2_BENCH_H */
@@ -43,12 +43,16 @@
 #include <hob3lbase/alloc.h>
 #include <hob3lbase/vec.h>
 #include <hob3lbase/panic.h>
+#include <hob3lbase/clock.h>
+#include <hob3lbase/trace.h>
 #include <hob3l/obj.h>
 #include <hob3l/csg.h>
+#include <hob3l/csg-prof.h>
 #include <hob3l/csg2.h>
 #include <hob3l/ps.h>
 #include <hob3l/csg2-bitmap.h>
 #include "internal.h"
+#include "probe.h"
 
 typedef struct event event_t;
 
@@ -218,6 +222,15 @@ typedef struct {
      * FIXME: temporary should be in pool.
      */
     v_event_p_t vert;
+
+    /** Number of intersection points found, for statistics */
+    size_t intersection_cnt;
+
+    /** Number of calls of divide_segment(), for statistics */
+    size_t divide_cnt;
+
+    /** Number of events put back into the queue, for statistics */
+    size_t requeue_cnt;
 } ctxt_t;
 
 /**
@@ -754,6 +767,7 @@ static void __divide_segment(
 {
     assert(p != e->p);
     assert(p != e->other->p);
+    c->divide_cnt++;
 
     assert(e->left);
     event_t *o = e->other;
@@ -1512,6 +1526,7 @@ static void check_intersection(
             if ((el->p == eh->p) || (ol->p == oh->p)) {
                 return;
             }
+            c->intersection_cnt++;
 
             if (ip == el->p) {
                 /* This means that we need to reclassify the upper line again (which
@@ -1520,6 +1535,7 @@ static void check_intersection(
                  * and throw it back into Q to try again later. */
                 s_remove(c, el);
                 q_insert(c, el);
+                c->requeue_cnt++;
             }
             else if (ip != ol->p) {
                 divide_segment(c, el, ip);
@@ -1529,6 +1545,7 @@ static void check_intersection(
                 /* Same corder case as above: we may have classified eh too early. */
                 s_remove(c, eh);
                 q_insert(c, eh);
+                c->requeue_cnt++;
             }
             else if (ip != oh->p) {
                 divide_segment(c, eh, ip);
@@ -1982,11 +1999,16 @@ static bool csg2_op_csg2(
 }
 
 /**
- * This reuses the poly_t structure r->data[0], but does not destruct
- * any of its substructures, but will just overwrite the pointers to
- * them.  Any poly but r->data[0] will be left completely untouched.
+ * If processing is cancelled via opt->progress, the result is empty.
+ *
+ * This reuses the poly_t structure r->data[0].  If o is r->data[0],
+ * its old substructures are freed after the new polygon has been
+ * constructed.  Otherwise, the pointers to the substructures of o are
+ * just overwritten.  Any poly but r->data[0] will be left completely
+ * untouched.
  */
 static void cp_csg2_op_poly(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_csg2_poly_t *o,
     cp_csg2_lazy_t const *r)
@@ -2000,31 +2022,50 @@ static void cp_csg2_op_poly(
     };
     cp_list_init(&c.poly);
 
+    /* the number of edges is only known at sweep_end */
+    CP_PROBE1(sweep_begin, r->size);
+    double t_trace = cp_trace_now(cp_csg_trace(opt));
+    cp_csg_prof_t *prof = (opt == NULL) ? NULL : opt->prof;
+    double t0 = (prof == NULL) ? 0 : cp_clock_wall();
+
     /* initialise queue */
-    for (cp_size_each(m, r->size)) {
+    bool cancelled = cp_csg_cancelled(opt);
+    size_t edge_cnt = 0;
+    for (cp_size_each(m, cancelled ? 0 : r->size)) {
         cp_csg2_poly_t *a = r->data[m];
         LOG("poly %"_Pz"d: #path=%"_Pz"u\n", m, a->path.size);
         for (cp_v_each(i, &a->path)) {
             cp_csg2_path_t *p = &cp_v_nth(&a->path, i);
+            edge_cnt += p->point_idx.size;
             for (cp_v_each(j, &p->point_idx)) {
                 cp_vec2_loc_t *pj = cp_csg2_path_nth(a, p, j);
                 cp_vec2_loc_t *pk = cp_csg2_path_nth(a, p, cp_wrap_add1(j, p->point_idx.size));
                 q_add_orig(&c, pj, pk, m);
+                if (prof != NULL) {
+                    cp_csg_prof_get(prof, pj->loc)->edge_cnt++;
+                }
             }
         }
     }
     LOG("start\n");
 
     /* run algorithm */
-    size_t ev_cnt __unused = 0;
+    size_t ev_cnt = 0;
     for (;;) {
         event_t *e = q_extract_min(&c);
         if (e == NULL) {
             break;
         }
+        if (((++ev_cnt % CP_CANCEL_CHECK_CNT) == 0) && cp_csg_cancelled(opt)) {
+            cancelled = true;
+            break;
+        }
+        if (prof != NULL) {
+            cp_csg_prof_event(prof, e->loc);
+        }
 
         LOG("\nevent %"_Pz"u: %s o=(0x%"_Pz"x 0x%"_Pz"x)\n",
-            ++ev_cnt,
+            ev_cnt,
             ev_str(e),
             e->other->in.owner,
             e->other->in.below);
@@ -2038,11 +2079,43 @@ static void cp_csg2_op_poly(
         }
     }
 
-    chain_combine(&c);
-    poly_make(o, &c, r->data[0]);
+    /* the events point into the old data, so keep it until poly_make is done */
+    cp_csg2_poly_t old = *o;
+
+    if (cancelled) {
+        /* the result is discarded by the caller: make it empty */
+        CP_COPY_N_ZERO(o, obj, r->data[0]->obj);
+    }
+    else {
+        chain_combine(&c);
+        poly_make(o, &c, r->data[0]);
+    }
+
+    if ((opt != NULL) && (opt->stat != NULL)) {
+        opt->stat->edge_cnt += edge_cnt;
+        opt->stat->event_cnt += ev_cnt;
+        opt->stat->intersection_cnt += c.intersection_cnt;
+        opt->stat->divide_cnt += c.divide_cnt;
+        opt->stat->requeue_cnt += c.requeue_cnt;
+    }
+    if (prof != NULL) {
+        cp_csg_prof_sweep_end(prof, cp_clock_wall() - t0);
+    }
+    CP_PROBE3(sweep_end, edge_cnt, ev_cnt, c.intersection_cnt);
+    cp_trace_span_args(cp_csg_trace(opt), "sweep", t_trace,
+        "\"polys\":%"_Pz"u,\"edges\":%"_Pz"u,\"events\":%"_Pz"u,\"intersections\":%"_Pz"u",
+        r->size, edge_cnt, ev_cnt, c.intersection_cnt);
 
     /* sweep */
     cp_v_fini(&c.vert);
+    if (o == r->data[0]) {
+        for (cp_v_each(i, &old.path)) {
+            cp_v_fini(&cp_v_nth(&old.path, i).point_idx);
+        }
+        cp_v_fini(&old.path);
+        cp_v_fini(&old.point);
+        cp_v_fini(&old.triangle);
+    }
 }
 
 static cp_csg2_poly_t *poly_sub(
@@ -2066,7 +2139,7 @@ static cp_csg2_poly_t *poly_sub(
     assert(o0.size == 2);
 
     cp_csg2_poly_t *o = CP_CLONE(a1);
-    cp_csg2_op_poly(tmp, o, &o0);
+    cp_csg2_op_poly(opt, tmp, o, &o0);
 
     /* check that the originals really haven't changed */
     assert(a0->point.size == a0_point_sz);
@@ -2183,6 +2256,7 @@ static void csg2_op_diff_csg2(
  * space from the polygons for storing the result.
  */
 extern void cp_csg2_op_reduce(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_csg2_lazy_t *r)
 {
@@ -2190,7 +2264,13 @@ extern void cp_csg2_op_reduce(
     if (r->size <= 1) {
         return;
     }
-    cp_csg2_op_poly(tmp, r->data[0], r);
+    if ((opt != NULL) && (opt->stat != NULL)) {
+        opt->stat->reduce_cnt++;
+    }
+    double t_trace = cp_trace_now(cp_csg_trace(opt));
+    cp_csg2_op_poly(opt, tmp, r->data[0], r);
+    cp_trace_span_args(cp_csg_trace(opt), "reduce", t_trace,
+        "\"polys\":%"_Pz"u,\"paths\":%"_Pz"u", r->size, r->data[0]->path.size);
     if (r->data[0]->point.size == 0) {
         CP_ZERO(r);
         return;
@@ -2284,11 +2364,11 @@ extern void cp_csg2_op_lazy(
 
         /* otherwise reduce the larger one */
         if (r->size > b->size) {
-            cp_csg2_op_reduce(tmp, r);
+            cp_csg2_op_reduce(opt, tmp, r);
             assert(r->size <= 1);
         }
         else {
-            cp_csg2_op_reduce(tmp, b);
+            cp_csg2_op_reduce(opt, tmp, b);
             assert(b->size <= 1);
         }
     }
@@ -2323,6 +2403,8 @@ extern void cp_csg2_op_lazy(
  * and the layer ID must be in range.
  *
  * r is filled from a.  In the process, a is cleared/reused, if necessary.
+ * The new layer in r shares no objects with a, so layer zi of a can be
+ * deleted afterwards.
  *
  * Runtime: O(j * k log k)
  * Space O(k)
@@ -2349,7 +2431,7 @@ extern void cp_csg2_op_add_layer(
     CP_ZERO(&ol);
     bool ok __unused = csg2_op_csg2(&c, zi, &ol, a->root);
     assert(ok && "Unexpected object in tree.");
-    cp_csg2_op_reduce(tmp, &ol);
+    cp_csg2_op_reduce(opt, tmp, &ol);
 
     cp_csg2_poly_t *o = ol.data[0];
     if (o != NULL) {
@@ -2364,8 +2446,17 @@ extern void cp_csg2_op_add_layer(
 
         cp_v_nth(&r->flag, zi) |= CP_CSG2_FLAG_NON_EMPTY;
 
+        if (opt->stat != NULL) {
+            opt->stat->poly_cnt += o->path.size;
+        }
+
+        /* The result reuses a polygon from a: move it into a new
+         * object so that the layers of a can be deleted independently. */
+        cp_csg2_poly_t *n = CP_CLONE(o);
+        CP_COPY_N_ZERO(o, obj, n->obj);
+
         /* single polygon per layer */
-        cp_v_push(&layer->root->add, cp_obj(o));
+        cp_v_push(&layer->root->add, cp_obj(n));
     }
 }
 
@@ -2401,11 +2492,77 @@ extern cp_csg2_poly_t *cp_csg2_flatten(
     CP_ZERO(&ol);
     bool ok __unused = csg2_op_v_csg2(&c, 0, &ol, root);
     assert(ok && "Unexpected object in tree.");
-    cp_csg2_op_reduce(tmp, &ol);
+    cp_csg2_op_reduce(opt, tmp, &ol);
 
     return ol.data[0];
 }
 
+/**
+ * Clip a polygon to an axis parallel rectangle, i.e., intersect it
+ * with the rectangle.
+ *
+ * The result is stored in a.  If a is completely inside the
+ * rectangle, it is left unchanged.  If the result is empty, a has no
+ * paths afterwards.
+ *
+ * Triangles are not clipped, so this must be done before
+ * triangulation.
+ *
+ * Runtime and space: see cp_csg2_op_add_layer.
+ */
+extern void cp_csg2_op_clip(
+    cp_csg_opt_t const *opt,
+    cp_pool_t *tmp,
+    cp_csg2_poly_t *a,
+    cp_vec2_minmax_t const *w)
+{
+    TRACE();
+    assert(a->triangle.size == 0);
+    if (a->point.size == 0) {
+        return;
+    }
+
+    cp_vec2_minmax_t bb = CP_VEC2_MINMAX_EMPTY;
+    cp_csg2_poly_minmax(&bb, a);
+    if (cp_ge(bb.min.x, w->min.x) && cp_ge(bb.min.y, w->min.y) &&
+        cp_le(bb.max.x, w->max.x) && cp_le(bb.max.y, w->max.y))
+    {
+        return;
+    }
+
+    /* the rectangle, in the same orientation as circles */
+    cp_csg2_poly_t b;
+    CP_ZERO(&b);
+    cp_v_init0(&b.point, 4);
+    cp_v_init0(&b.path, 1);
+    cp_csg2_path_t *p = &cp_v_nth(&b.path, 0);
+    cp_v_init0(&p->point_idx, 4);
+    for (cp_size_each(i, 4)) {
+        cp_vec2_loc_t *v = &cp_v_nth(&b.point, i);
+        v->coord.x = ((i == 0) || (i == 1)) ? w->min.x : w->max.x;
+        v->coord.y = ((i == 0) || (i == 3)) ? w->min.y : w->max.y;
+        v->loc = cp_v_nth(&a->point, 0).loc;
+        v->color = cp_v_nth(&a->point, 0).color;
+        cp_v_nth(&p->point_idx, i) = i;
+    }
+
+    cp_csg2_lazy_t o0;
+    CP_ZERO(&o0);
+    csg2_op_poly(&o0, a);
+
+    cp_csg2_lazy_t o1;
+    CP_ZERO(&o1);
+    csg2_op_poly(&o1, &b);
+
+    cp_csg2_op_lazy(opt, tmp, &o0, &o1, CP_OP_CUT);
+    cp_csg2_op_reduce(opt, tmp, &o0);
+
+    /* b is left untouched by the operation */
+    cp_v_fini(&p->point_idx);
+    cp_v_fini(&b.path);
+    cp_v_fini(&b.point);
+}
+
 /**
  * Diff a layer with the next and store the result in diff_above/diff_below.
  *
@@ -0,0 +1,781 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/* for getpid() */
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <hob3lbase/arith.h>
+#include <hob3lbase/vec.h>
+#include <hob3lbase/mat.h>
+#include <hob3lbase/panic.h>
+#include <hob3lbase/vchar.h>
+#include <hob3lbase/alloc.h>
+#include <hob3lbase/dict.h>
+#include <hob3l/csg.h>
+#include <hob3l/csg2.h>
+#include <hob3l/csg3.h>
+#include <hob3l/csg3-cache.h>
+#include <hob3l/csg2-cache.h>
+#include "internal.h"
+
+/**
+ * Layer file format version.  Increment whenever the layout changes
+ * or whenever the computation of layers changes.
+ */
+#define CACHE_VERSION 1
+
+/** File magic */
+#define CACHE_MAGIC "HOB3LL\0\0"
+
+/** To detect files written on a machine with a different byte order */
+#define CACHE_BYTE_ORDER 0x0102030405060708ULL
+
+/** File name suffix of layer files */
+#define CACHE_SUFFIX ".hob3ll"
+
+/**
+ * Header of a layer file.  Like in CSG3 cache files, every entry is a
+ * 64-bit word.  The header is followed by the polygon.
+ */
+enum {
+    H_MAGIC,
+    H_VERSION,
+    H_BYTE_ORDER,
+    H_KEY,
+    H_COUNT
+};
+
+static uint64_t f_bits(
+    cp_f_t x)
+{
+    uint64_t u;
+    cp_static_assert(sizeof(u) == sizeof(x));
+    memcpy(&u, &x, sizeof(u));
+    return u;
+}
+
+/**
+ * FNV-1a hash: add a 64-bit word to h.
+ */
+static void hash_u64(
+    uint64_t *h,
+    uint64_t x)
+{
+    for (cp_size_each(i, 8)) {
+        *h ^= (x >> (8 * i)) & 0xff;
+        *h *= 0x100000001b3ULL;
+    }
+}
+
+static void hash_f(
+    uint64_t *h,
+    cp_f_t x)
+{
+    hash_u64(h, f_bits(x));
+}
+
+/* ********************************************************************** */
+/* key computation */
+
+typedef struct {
+    cp_csg2_cache_t *c;
+    /** whether to collect the leaves into c->leaf */
+    bool collect;
+    /** next leaf index */
+    size_t leaf_i;
+    /** z coordinate of the layer */
+    cp_dim_t z;
+    uint64_t h;
+} key_ctxt_t;
+
+static void key_csg3(
+    key_ctxt_t *k,
+    cp_obj_t const *o);
+
+static void key_add(
+    key_ctxt_t *k,
+    cp_csg_add_t const *r)
+{
+    hash_u64(&k->h, CP_CSG_ADD);
+    hash_u64(&k->h, r->add.size);
+    for (cp_v_each(i, &r->add)) {
+        key_csg3(k, cp_v_nth(&r->add, i));
+    }
+}
+
+static void key_v_add(
+    key_ctxt_t *k,
+    unsigned type,
+    cp_v_csg_add_p_t const *r)
+{
+    hash_u64(&k->h, type);
+    hash_u64(&k->h, r->size);
+    for (cp_v_each(i, r)) {
+        key_add(k, cp_v_nth(r, i));
+    }
+}
+
+static void key_leaf(
+    key_ctxt_t *k,
+    cp_obj_t const *o)
+{
+    if (k->collect) {
+        cp_vec3_minmax_t bb = CP_VEC3_MINMAX_EMPTY;
+        cp_csg3_bb(&bb, cp_csg3_cast(cp_csg3_t, o), true);
+        cp_v_push(&k->c->leaf, ((cp_csg2_cache_leaf_t){
+            .hash = cp_csg3_cache_hash(o),
+            .z_min = bb.min.z,
+            .z_max = bb.max.z,
+        }));
+        return;
+    }
+
+    /* Leaves that do not touch the layer contribute nothing but their
+     * position in the tree. */
+    cp_csg2_cache_leaf_t const *l = &cp_v_nth(&k->c->leaf, k->leaf_i++);
+    bool in = cp_le(l->z_min, k->z) && cp_le(k->z, l->z_max);
+    hash_u64(&k->h, in ? l->hash : 0);
+}
+
+static void key_csg3(
+    key_ctxt_t *k,
+    cp_obj_t const *o)
+{
+    switch (o->type) {
+    case CP_CSG_ADD:
+        key_add(k, cp_csg_cast(cp_csg_add_t, o));
+        return;
+
+    case CP_CSG_SUB: {
+        cp_csg_sub_t const *s = cp_csg_cast(*s, o);
+        hash_u64(&k->h, CP_CSG_SUB);
+        key_add(k, s->add);
+        key_add(k, s->sub);
+        return;
+    }
+
+    case CP_CSG_CUT:
+        key_v_add(k, CP_CSG_CUT, &cp_csg_cast(cp_csg_cut_t, o)->cut);
+        return;
+
+    case CP_CSG_XOR:
+        key_v_add(k, CP_CSG_XOR, &cp_csg_cast(cp_csg_xor_t, o)->xor);
+        return;
+
+    case CP_CSG3_SPHERE:
+    case CP_CSG3_POLY:
+    case CP_CSG2_POLY:
+        key_leaf(k, o);
+        return;
+    }
+    CP_DIE("CSG3 object type");
+}
+
+static uint64_t layer_key(
+    cp_csg2_cache_t *c,
+    cp_csg2_tree_t const *r,
+    size_t zi)
+{
+    key_ctxt_t k = {
+        .c = c,
+        .z = cp_v_nth(&r->z, zi),
+        .h = c->base,
+    };
+    hash_f(&k.h, k.z);
+    if (c->csg3->root != NULL) {
+        key_add(&k, c->csg3->root);
+    }
+    assert(k.leaf_i == c->leaf.size);
+    return k.h;
+}
+
+static void layer_file_name(
+    cp_vchar_t *fn,
+    cp_csg2_cache_t const *c,
+    uint64_t key)
+{
+    cp_vchar_printf(fn, "%s/%016"PRIx64 CACHE_SUFFIX, c->dir, key);
+}
+
+/* ********************************************************************** */
+/* memory */
+
+static int entry_cmp(
+    uint64_t *a,
+    cp_dict_t *_b,
+    void *user __unused)
+{
+    cp_csg2_cache_entry_t const *b = CP_BOX_OF(_b, cp_csg2_cache_entry_t, node);
+    return (*a < b->key) ? -1 : (*a > b->key) ? +1 : 0;
+}
+
+static cp_csg2_cache_entry_t *entry_find(
+    cp_csg2_cache_t *c,
+    uint64_t key)
+{
+    cp_dict_t *n = cp_dict_find(&key, c->entry, entry_cmp, NULL);
+    return CP_BOX0_OF(n, cp_csg2_cache_entry_t, node);
+}
+
+/**
+ * Store a layer in memory, replacing the data of an existing entry.
+ * This takes over the data from b and leaves b empty.
+ */
+static void entry_put(
+    cp_csg2_cache_t *c,
+    uint64_t key,
+    cp_vchar_t *b)
+{
+    cp_csg2_cache_entry_t *e = entry_find(c, key);
+    if (e == NULL) {
+        e = CP_NEW(*e);
+        e->key = key;
+        cp_dict_t *o __unused =
+            cp_dict_insert_by(&e->node, &key, &c->entry, entry_cmp, NULL, 0);
+        assert(o == NULL);
+    }
+    cp_vchar_fini(&e->data);
+    e->data = *b;
+    CP_ZERO(b);
+    e->gen = c->gen;
+}
+
+static void entry_delete(
+    cp_csg2_cache_t *c,
+    cp_csg2_cache_entry_t *e)
+{
+    cp_dict_remove(&e->node, &c->entry);
+    cp_vchar_fini(&e->data);
+    CP_FREE(e);
+}
+
+/* ********************************************************************** */
+/* log */
+
+/**
+ * Log entry: the key, the size of the layer data, then the data.
+ * A size of 0 means that the layer was found in the cache.
+ */
+static void log_put(
+    cp_csg2_cache_t *c,
+    uint64_t key,
+    cp_vchar_t const *b)
+{
+    if (c->log == NULL) {
+        return;
+    }
+    uint64_t h[2] = { key, (b == NULL) ? 0 : b->size };
+    (void)fwrite(h, sizeof(h[0]), 2, c->log);
+    if (b != NULL) {
+        (void)fwrite(b->data, 1, b->size, c->log);
+    }
+}
+
+/* ********************************************************************** */
+/* writing */
+
+static void put_u64(
+    cp_vchar_t *b,
+    uint64_t x)
+{
+    cp_vchar_append_arr(b, (char const *)&x, sizeof(x));
+}
+
+static void put_poly(
+    cp_vchar_t *b,
+    cp_csg2_poly_t const *p)
+{
+    put_u64(b, p->point.size);
+    for (cp_v_each(i, &p->point)) {
+        cp_vec2_loc_t const *v = &cp_v_nth(&p->point, i);
+        put_u64(b, f_bits(v->coord.x));
+        put_u64(b, f_bits(v->coord.y));
+        put_u64(b,
+            ((uint64_t)v->color.r)       |
+            ((uint64_t)v->color.g << 8)  |
+            ((uint64_t)v->color.b << 16) |
+            ((uint64_t)v->color.a << 24));
+    }
+    put_u64(b, p->path.size);
+    for (cp_v_each(i, &p->path)) {
+        cp_csg2_path_t const *q = &cp_v_nth(&p->path, i);
+        put_u64(b, q->point_idx.size);
+        for (cp_v_each(j, &q->point_idx)) {
+            put_u64(b, cp_v_nth(&q->point_idx, j));
+        }
+    }
+    put_u64(b, p->triangle.size);
+    for (cp_v_each(i, &p->triangle)) {
+        for (cp_size_each(j, 3)) {
+            put_u64(b, cp_v_nth(&p->triangle, i).p[j]);
+        }
+    }
+}
+
+/**
+ * Write layer data b with the given key into the cache directory.
+ *
+ * The file is written under a temporary name and then renamed, so
+ * that concurrent readers never see a partial file.
+ */
+static bool layer_write(
+    cp_csg2_cache_t const *c,
+    cp_err_t *err,
+    uint64_t key,
+    cp_vchar_t const *b)
+{
+    cp_vchar_t fn;
+    cp_vchar_init(&fn);
+    layer_file_name(&fn, c, key);
+    cp_vchar_t tmp;
+    cp_vchar_init(&tmp);
+    cp_vchar_printf(&tmp, "%s.%ld.new", fn.data, (long)getpid());
+
+    bool ok = true;
+    FILE *f = fopen(tmp.data, "wb");
+    if (f == NULL) {
+        cp_vchar_printf(&err->msg, "Unable to open '%s' for writing: %s\n",
+            tmp.data, strerror(errno));
+        ok = false;
+    }
+    else {
+        ok = (fwrite(b->data, 1, b->size, f) == b->size);
+        ok = (fclose(f) == 0) && ok;
+        if (ok) {
+            ok = (rename(tmp.data, fn.data) == 0);
+        }
+        if (!ok) {
+            cp_vchar_printf(&err->msg, "Unable to write '%s': %s\n",
+                fn.data, strerror(errno));
+            (void)remove(tmp.data);
+        }
+    }
+
+    cp_vchar_fini(&tmp);
+    cp_vchar_fini(&fn);
+    return ok;
+}
+
+/* ********************************************************************** */
+/* reading */
+
+typedef struct {
+    unsigned char const *data;
+    size_t size;
+    size_t pos;
+    bool ok;
+} rd_t;
+
+static uint64_t get_u64(
+    rd_t *rd)
+{
+    if (!rd->ok || ((rd->size - rd->pos) < 8)) {
+        rd->ok = false;
+        return 0;
+    }
+    uint64_t x;
+    memcpy(&x, rd->data + rd->pos, sizeof(x));
+    rd->pos += 8;
+    return x;
+}
+
+/**
+ * Read a count of items of a given size, checking that they fit
+ * into the rest of the file.
+ */
+static size_t get_cnt(
+    rd_t *rd,
+    size_t item_size)
+{
+    uint64_t n = get_u64(rd);
+    if (n > ((rd->size - rd->pos) / item_size)) {
+        rd->ok = false;
+        return 0;
+    }
+    return (size_t)n;
+}
+
+static size_t get_idx(
+    rd_t *rd,
+    size_t n)
+{
+    uint64_t i = get_u64(rd);
+    if (i >= n) {
+        rd->ok = false;
+        return 0;
+    }
+    return (size_t)i;
+}
+
+static void get_poly(
+    rd_t *rd,
+    cp_csg2_poly_t *p,
+    size_t point_cnt)
+{
+    cp_v_init0(&p->point, point_cnt);
+    for (cp_v_each(i, &p->point)) {
+        cp_vec2_loc_t *v = &cp_v_nth(&p->point, i);
+        uint64_t x = get_u64(rd);
+        uint64_t y = get_u64(rd);
+        memcpy(&v->coord.x, &x, sizeof(x));
+        memcpy(&v->coord.y, &y, sizeof(y));
+        if (!isfinite(v->coord.x) || !isfinite(v->coord.y)) {
+            rd->ok = false;
+        }
+        uint64_t c = get_u64(rd);
+        v->color.r = (c & 0xff);
+        v->color.g = ((c >> 8) & 0xff);
+        v->color.b = ((c >> 16) & 0xff);
+        v->color.a = ((c >> 24) & 0xff);
+    }
+
+    cp_v_init0(&p->path, get_cnt(rd, 8));
+    for (cp_v_each(i, &p->path)) {
+        cp_csg2_path_t *q = &cp_v_nth(&p->path, i);
+        cp_v_init0(&q->point_idx, get_cnt(rd, 8));
+        for (cp_v_each(j, &q->point_idx)) {
+            cp_v_nth(&q->point_idx, j) = get_idx(rd, point_cnt);
+        }
+    }
+
+    cp_v_init0(&p->triangle, get_cnt(rd, 3 * 8));
+    for (cp_v_each(i, &p->triangle)) {
+        for (cp_size_each(j, 3)) {
+            cp_v_nth(&p->triangle, i).p[j] = get_idx(rd, point_cnt);
+        }
+    }
+}
+
+static bool read_file(
+    cp_vchar_t *b,
+    char const *filename)
+{
+    FILE *f = fopen(filename, "rb");
+    if (f == NULL) {
+        return false;
+    }
+    for (;;) {
+        char buff[4096];
+        size_t cnt = fread(buff, 1, sizeof(buff), f);
+        if (cnt == 0) {
+            break;
+        }
+        cp_vchar_append_arr(b, buff, cnt);
+    }
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+/* ********************************************************************** */
+/* extern */
+
+/**
+ * Initialise a layer cache.
+ *
+ * dir may be NULL to use no cache directory.  Otherwise, the
+ * directory is created if it does not exist.
+ *
+ * If mem is true, layers are also kept in memory.
+ *
+ * Before the cache can be used, cp_csg2_cache_set_tree() must be
+ * called.
+ *
+ * On error, returns false and fills in err.
+ */
+extern bool cp_csg2_cache_init(
+    cp_csg2_cache_t *c,
+    cp_err_t *err,
+    char const *dir,
+    bool mem)
+{
+    CP_ZERO(c);
+    if ((dir != NULL) && (mkdir(dir, 0777) != 0) && (errno != EEXIST)) {
+        cp_vchar_printf(&err->msg, "Unable to create directory '%s': %s\n",
+            dir, strerror(errno));
+        return false;
+    }
+    c->dir = dir;
+    c->mem = mem;
+    return true;
+}
+
+/**
+ * Set the CSG3 tree the layers are computed from.
+ *
+ * tri must be true iff the layers are triangulated.
+ *
+ * This can be called again for a new tree, e.g., after the input
+ * file changed.  The layers already in the cache stay valid, and
+ * the hit and miss counts are reset.
+ */
+extern void cp_csg2_cache_set_tree(
+    cp_csg2_cache_t *c,
+    cp_csg3_tree_t const *csg3,
+    bool tri)
+{
+    c->csg3 = csg3;
+    c->hit_cnt = 0;
+    c->miss_cnt = 0;
+    cp_v_clear(&c->leaf, 0);
+
+    cp_csg_opt_t const *opt = csg3->opt;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    hash_u64(&h, CACHE_VERSION);
+    hash_f(&h, cp_pt_epsilon);
+    hash_f(&h, cp_eq_epsilon);
+    hash_f(&h, cp_sqr_epsilon);
+    hash_u64(&h, opt->max_simultaneous);
+    hash_u64(&h, opt->optimise);
+    hash_u64(&h, opt->color_rand);
+    hash_u64(&h, opt->max_fn);
+    hash_u64(&h, opt->err_empty);
+    hash_u64(&h, opt->err_collapse);
+    hash_u64(&h, opt->err_outside_3d);
+    hash_u64(&h, opt->err_outside_2d);
+    hash_u64(&h, opt->xy_window != NULL);
+    if (opt->xy_window != NULL) {
+        hash_f(&h, opt->xy_window->min.x);
+        hash_f(&h, opt->xy_window->min.y);
+        hash_f(&h, opt->xy_window->max.x);
+        hash_f(&h, opt->xy_window->max.y);
+    }
+    hash_u64(&h, tri);
+    c->base = h;
+
+    if (csg3->root != NULL) {
+        key_ctxt_t k = { .c = c, .collect = true };
+        key_add(&k, csg3->root);
+    }
+}
+
+/**
+ * Free the data of a layer cache, including the layers in memory.
+ */
+extern void cp_csg2_cache_fini(
+    cp_csg2_cache_t *c)
+{
+    while (c->entry != NULL) {
+        entry_delete(c, CP_BOX_OF(c->entry, cp_csg2_cache_entry_t, node));
+    }
+    cp_v_fini(&c->leaf);
+}
+
+/**
+ * Decode layer data b with the given key into layer zi of r.
+ *
+ * Returns false if the data is corrupt.
+ */
+static bool layer_decode(
+    cp_csg2_tree_t *r,
+    size_t zi,
+    uint64_t key,
+    cp_vchar_t const *b)
+{
+    rd_t rd = {
+        .data = (unsigned char const *)b->data,
+        .size = b->size,
+        .ok = (b->size >= (H_COUNT * 8)),
+    };
+    if (rd.ok) {
+        rd.ok = (memcmp(b->data, CACHE_MAGIC, 8) == 0);
+        rd.pos = 8;
+    }
+    if ((get_u64(&rd) != CACHE_VERSION) ||
+        (get_u64(&rd) != CACHE_BYTE_ORDER) ||
+        (get_u64(&rd) != key))
+    {
+        rd.ok = false;
+    }
+
+    cp_csg2_poly_t *p = NULL;
+    size_t point_cnt = get_cnt(&rd, 3 * 8);
+    if (rd.ok && (point_cnt > 0)) {
+        p = cp_csg2_new(*p, NULL);
+        get_poly(&rd, p, point_cnt);
+    }
+    if (rd.pos != rd.size) {
+        rd.ok = false;
+    }
+
+    if (!rd.ok) {
+        if (p != NULL) {
+            cp_csg2_delete(cp_csg2_cast(cp_csg2_t, p));
+        }
+        return false;
+    }
+
+    if (p != NULL) {
+        cp_csg2_stack_t *s = cp_csg2_cast(*s, r->root);
+        cp_csg2_layer_t *layer = cp_csg2_stack_get_layer(s, zi);
+        assert(layer != NULL);
+        cp_csg_add_init_perhaps(&layer->root, NULL);
+        layer->zi = zi;
+        cp_v_nth(&r->flag, zi) |= CP_CSG2_FLAG_NON_EMPTY;
+        cp_v_push(&layer->root->add, cp_obj(p));
+    }
+    return true;
+}
+
+/**
+ * Load layer zi of r from the cache.
+ *
+ * r must have been initialised by cp_csg2_op_tree_init().
+ *
+ * Layers in memory are tried first, then the cache directory.
+ *
+ * Returns whether the layer was found.  Unreadable or corrupt
+ * entries are treated as not found.
+ */
+extern bool cp_csg2_cache_get(
+    cp_csg2_cache_t *c,
+    cp_csg2_tree_t *r,
+    size_t zi)
+{
+    uint64_t key = layer_key(c, r, zi);
+
+    cp_csg2_cache_entry_t *e = entry_find(c, key);
+    if ((e != NULL) && layer_decode(r, zi, key, &e->data)) {
+        e->gen = c->gen;
+        c->hit_cnt++;
+        log_put(c, key, NULL);
+        return true;
+    }
+
+    bool ok = false;
+    if (c->dir != NULL) {
+        cp_vchar_t fn;
+        cp_vchar_init(&fn);
+        layer_file_name(&fn, c, key);
+        cp_vchar_t b;
+        cp_vchar_init(&b);
+        ok = read_file(&b, fn.data) && layer_decode(r, zi, key, &b);
+        cp_vchar_fini(&fn);
+        if (ok && c->mem) {
+            entry_put(c, key, &b);
+        }
+        cp_vchar_fini(&b);
+    }
+
+    if (!ok) {
+        c->miss_cnt++;
+        return false;
+    }
+    c->hit_cnt++;
+    log_put(c, key, NULL);
+    return true;
+}
+
+/**
+ * Store layer zi of r in the cache.
+ *
+ * The file is written under a temporary name and then renamed, so
+ * that concurrent readers never see a partial file.
+ *
+ * On error, returns false and fills in err.
+ */
+extern bool cp_csg2_cache_put(
+    cp_csg2_cache_t *c,
+    cp_err_t *err,
+    cp_csg2_tree_t *r,
+    size_t zi)
+{
+    uint64_t key = layer_key(c, r, zi);
+
+    cp_vchar_t b;
+    cp_vchar_init(&b);
+    cp_vchar_append_arr(&b, CACHE_MAGIC, 8);
+    put_u64(&b, CACHE_VERSION);
+    put_u64(&b, CACHE_BYTE_ORDER);
+    put_u64(&b, key);
+    assert(b.size == (H_COUNT * 8));
+
+    cp_csg2_stack_t *s = cp_csg2_cast(*s, r->root);
+    cp_csg2_layer_t *layer = cp_csg2_stack_get_layer(s, zi);
+    assert(layer != NULL);
+    assert(cp_csg_add_size(layer->root) <= 1);
+    if (cp_csg_add_size(layer->root) == 0) {
+        put_u64(&b, 0);
+    }
+    else {
+        put_poly(&b, cp_csg2_cast(cp_csg2_poly_t, cp_v_nth(&layer->root->add, 0)));
+    }
+
+    log_put(c, key, &b);
+
+    bool ok = true;
+    if (c->dir != NULL) {
+        ok = layer_write(c, err, key, &b);
+    }
+    if (c->mem) {
+        entry_put(c, key, &b);
+    }
+    cp_vchar_fini(&b);
+    return ok;
+}
+
+/**
+ * Read a file written via the log member of a cache.
+ *
+ * Each layer in the file is stored in memory, and each layer that is
+ * mentioned in the file is marked as used for cp_csg2_cache_sweep().
+ *
+ * Returns false if the file ends in the middle of an entry.  The
+ * entries before that are still stored.
+ */
+extern bool cp_csg2_cache_read_log(
+    cp_csg2_cache_t *c,
+    FILE *f)
+{
+    for (;;) {
+        uint64_t h[2];
+        size_t cnt = fread(h, sizeof(h[0]), 2, f);
+        if (cnt == 0) {
+            return !ferror(f);
+        }
+        if (cnt != 2) {
+            return false;
+        }
+        if (h[1] == 0) {
+            cp_csg2_cache_entry_t *e = entry_find(c, h[0]);
+            if (e != NULL) {
+                e->gen = c->gen;
+            }
+            continue;
+        }
+        cp_vchar_t b;
+        cp_vchar_init(&b);
+        while (b.size < h[1]) {
+            char buff[4096];
+            size_t want = cp_min(sizeof(buff), (size_t)(h[1] - b.size));
+            if (fread(buff, 1, want, f) != want) {
+                cp_vchar_fini(&b);
+                return false;
+            }
+            cp_vchar_append_arr(&b, buff, want);
+        }
+        entry_put(c, h[0], &b);
+    }
+}
+
+/**
+ * Remove all layers from memory that were not used since the previous
+ * call of this function.
+ */
+extern void cp_csg2_cache_sweep(
+    cp_csg2_cache_t *c)
+{
+    for (cp_dict_t *n = cp_dict_start(c->entry, 0); n != NULL;) {
+        cp_csg2_cache_entry_t *e = CP_BOX_OF(n, cp_csg2_cache_entry_t, node);
+        n = cp_dict_next(n);
+        if (e->gen != c->gen) {
+            entry_delete(c, e);
+        }
+    }
+    c->gen++;
+}
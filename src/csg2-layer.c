@@ -8,9 +8,11 @@
 #include <hob3lbase/mat.h>
 #include <hob3lbase/alloc.h>
 #include <hob3lbase/pool.h>
+#include <hob3lbase/clock.h>
 #include <hob3l/gc.h>
 #include <hob3l/obj.h>
 #include <hob3l/csg.h>
+#include <hob3l/csg-prof.h>
 #include <hob3l/csg2.h>
 #include <hob3l/csg3.h>
 #include "internal.h"
@@ -718,6 +720,29 @@ static bool csg2_add_layer_xor(
     return true;
 }
 
+/**
+ * Clip the polygons in c to w, and delete those that become empty.
+ */
+static void v_clip(
+    cp_csg_opt_t const *opt,
+    cp_pool_t *pool,
+    cp_v_obj_p_t *c,
+    cp_vec2_minmax_t const *w)
+{
+    size_t k = 0;
+    for (cp_v_each(i, c)) {
+        cp_csg2_poly_t *p = cp_csg2_cast(*p, cp_v_nth(c, i));
+        cp_csg2_op_clip(opt, pool, p, w);
+        if (p->path.size == 0) {
+            cp_csg2_delete(cp_csg2_cast(cp_csg2_t, p));
+        }
+        else {
+            cp_v_nth(c, k++) = cp_v_nth(c, i);
+        }
+    }
+    cp_v_set_size(c, k);
+}
+
 static bool csg2_add_layer_stack(
     bool *no,
     cp_pool_t *pool,
@@ -737,6 +762,9 @@ static bool csg2_add_layer_stack(
     cp_csg_add_init_perhaps(&l->root, d->loc);
     l->zi = zi;
 
+    cp_csg_prof_t *prof = r->opt->prof;
+    double t0 = (prof == NULL) ? 0 : cp_clock_wall();
+
     switch (d->type) {
     case CP_CSG3_SPHERE:
         csg2_add_layer_sphere(r->opt, z, &l->root->add, cp_csg3_cast(cp_csg3_sphere_t, d));
@@ -754,6 +782,14 @@ static bool csg2_add_layer_stack(
         CP_DIE("3D object");
     }
 
+    if (r->opt->xy_window != NULL) {
+        v_clip(r->opt, pool, &l->root->add, r->opt->xy_window);
+    }
+
+    if (prof != NULL) {
+        cp_csg_prof_get(prof, d->loc)->time_slice += cp_clock_wall() - t0;
+    }
+
     if (cp_csg_add_size(l->root) > 0) {
         *no = true;
     }
@@ -28,113 +28,252 @@
 
 static cp_csg2_t *csg2_tree_from_csg3(
     cp_csg2_tree_t *r,
-    cp_range_t const *s,
     cp_csg3_t const *d);
 
 static void csg2_tree_from_v_csg3(
     cp_csg2_tree_t *r,
-    cp_range_t const *s,
     cp_v_obj_p_t *c,
     cp_v_obj_p_t const *d)
 {
     cp_v_ensure_size(c, d->size);
     for (cp_v_each(i, d)) {
-        cp_v_nth(c,i) = cp_obj(csg2_tree_from_csg3(r, s, cp_csg3_cast(cp_csg3_t, cp_v_nth(d,i))));
+        cp_v_nth(c,i) = cp_obj(csg2_tree_from_csg3(r, cp_csg3_cast(cp_csg3_t, cp_v_nth(d,i))));
     }
 }
 
 static cp_csg_add_t *csg2_tree_from_csg3_add(
     cp_csg2_tree_t *r,
-    cp_range_t const *s,
     cp_csg_add_t const *d)
 {
     cp_csg_add_t *c = cp_csg_new(*c, d->loc);
-    csg2_tree_from_v_csg3(r, s, &c->add, &d->add);
+    csg2_tree_from_v_csg3(r, &c->add, &d->add);
     return c;
 }
 
 static cp_csg_sub_t *csg2_tree_from_csg3_sub(
     cp_csg2_tree_t *r,
-    cp_range_t const *s,
     cp_csg_sub_t const *d)
 {
     cp_csg_sub_t *c = cp_csg_new(*c, d->loc);
-    c->add = csg2_tree_from_csg3_add(r, s, d->add);
-    c->sub = csg2_tree_from_csg3_add(r, s, d->sub);
+    c->add = csg2_tree_from_csg3_add(r, d->add);
+    c->sub = csg2_tree_from_csg3_add(r, d->sub);
     return c;
 }
 
 static cp_csg_cut_t *csg2_tree_from_csg3_cut(
     cp_csg2_tree_t *r,
-    cp_range_t const *s,
     cp_csg_cut_t const *d)
 {
     cp_csg_cut_t *c = cp_csg_new(*c, d->loc);
     cp_v_init0(&c->cut, d->cut.size);
     for (cp_v_each(i, &c->cut)) {
-        cp_v_nth(&c->cut, i) = csg2_tree_from_csg3_add(r, s, cp_v_nth(&d->cut, i));
+        cp_v_nth(&c->cut, i) = csg2_tree_from_csg3_add(r, cp_v_nth(&d->cut, i));
     }
     return c;
 }
 
 static cp_csg_xor_t *csg2_tree_from_csg3_xor(
     cp_csg2_tree_t *r,
-    cp_range_t const *s,
     cp_csg_xor_t const *d)
 {
     cp_csg_xor_t *c = cp_csg_new(*c, d->loc);
     cp_v_init0(&c->xor, d->xor.size);
     for (cp_v_each(i, &c->xor)) {
-        cp_v_nth(&c->xor, i) = csg2_tree_from_csg3_add(r, s, cp_v_nth(&d->xor, i));
+        cp_v_nth(&c->xor, i) = csg2_tree_from_csg3_add(r, cp_v_nth(&d->xor, i));
     }
     return c;
 }
 
 static cp_csg2_t *csg2_tree_from_csg3_obj(
-    cp_range_t const *s,
+    cp_csg2_tree_t *r,
     cp_csg3_t const *d)
 {
     cp_csg2_stack_t *c = cp_csg2_new(*c, d->loc);
-
     c->csg3 = d;
-    c->idx0 = 0;
-    cp_v_init0(&c->layer, s->cnt);
-    assert(c->layer.size == s->cnt);
+
+    /* Reserve only the layers that intersect the bounding box: the
+     * others are empty anyway.  The z values are sorted. */
+    cp_vec3_minmax_t bb = CP_VEC3_MINMAX_EMPTY;
+    cp_csg3_bb(&bb, d, true);
+
+    /* Same for objects outside the xy window */
+    cp_vec2_minmax_t const *w = r->opt->xy_window;
+    if ((w != NULL) &&
+        (cp_lt(bb.max.x, w->min.x) || cp_lt(bb.max.y, w->min.y) ||
+         cp_gt(bb.min.x, w->max.x) || cp_gt(bb.min.y, w->max.y)))
+    {
+        return cp_csg2_cast(cp_csg2_t, c);
+    }
+
+    size_t i0 = 0;
+    while ((i0 < r->z.size) && cp_lt(cp_v_nth(&r->z, i0), bb.min.z)) {
+        i0++;
+    }
+    size_t i1 = i0;
+    while ((i1 < r->z.size) && cp_le(cp_v_nth(&r->z, i1), bb.max.z)) {
+        i1++;
+    }
+
+    c->idx0 = i0;
+    cp_v_init0(&c->layer, i1 - i0);
 
     return cp_csg2_cast(cp_csg2_t, c);
 }
 
 static cp_csg2_t *csg2_tree_from_csg3(
     cp_csg2_tree_t *r,
-    cp_range_t const *s,
     cp_csg3_t const *d)
 {
     switch (d->type) {
     case CP_CSG3_SPHERE:
     case CP_CSG3_POLY:
     case CP_CSG2_POLY:
-        return csg2_tree_from_csg3_obj(s, d);
+        return csg2_tree_from_csg3_obj(r, d);
 
     case CP_CSG_ADD:
         return cp_csg2_cast(cp_csg2_t,
-            csg2_tree_from_csg3_add(r, s, cp_csg_cast(cp_csg_add_t, d)));
+            csg2_tree_from_csg3_add(r, cp_csg_cast(cp_csg_add_t, d)));
 
     case CP_CSG_XOR:
         return cp_csg2_cast(cp_csg2_t,
-            csg2_tree_from_csg3_xor(r, s, cp_csg_cast(cp_csg_xor_t, d)));
+            csg2_tree_from_csg3_xor(r, cp_csg_cast(cp_csg_xor_t, d)));
 
     case CP_CSG_SUB:
         return cp_csg2_cast(cp_csg2_t,
-            csg2_tree_from_csg3_sub(r, s, cp_csg_cast(cp_csg_sub_t, d)));
+            csg2_tree_from_csg3_sub(r, cp_csg_cast(cp_csg_sub_t, d)));
 
     case CP_CSG_CUT:
         return cp_csg2_cast(cp_csg2_t,
-            csg2_tree_from_csg3_cut(r, s, cp_csg_cast(cp_csg_cut_t, d)));
+            csg2_tree_from_csg3_cut(r, cp_csg_cast(cp_csg_cut_t, d)));
     }
 
     CP_DIE("3D object type");
 }
 
+static void v_csg2_delete(
+    cp_v_obj_p_t *r)
+{
+    for (cp_v_each(i, r)) {
+        cp_csg2_delete(cp_csg2_cast(cp_csg2_t, cp_v_nth(r, i)));
+    }
+    cp_v_fini(r);
+}
+
+static void add_delete(
+    cp_csg_add_t *r)
+{
+    if (r == NULL) {
+        return;
+    }
+    v_csg2_delete(&r->add);
+    CP_FREE(r);
+}
+
+static void v_add_delete(
+    cp_v_csg_add_p_t *r)
+{
+    for (cp_v_each(i, r)) {
+        add_delete(cp_v_nth(r, i));
+    }
+    cp_v_fini(r);
+}
+
+static void poly_delete(
+    cp_csg2_poly_t *r)
+{
+    if (r == NULL) {
+        return;
+    }
+    for (cp_v_each(i, &r->path)) {
+        cp_v_fini(&cp_v_nth(&r->path, i).point_idx);
+    }
+    cp_v_fini(&r->path);
+    cp_v_fini(&r->point);
+    cp_v_fini(&r->triangle);
+    poly_delete(r->diff_below);
+    poly_delete(r->diff_above);
+    CP_FREE(r);
+}
+
+static void layer_delete(
+    cp_csg2_layer_t *l)
+{
+    add_delete(l->root);
+    l->root = NULL;
+}
+
+static void stack_delete(
+    cp_csg2_stack_t *r)
+{
+    for (cp_v_each(i, &r->layer)) {
+        layer_delete(&cp_v_nth(&r->layer, i));
+    }
+    cp_v_fini(&r->layer);
+    CP_FREE(r);
+}
+
+static void csg2_delete_layer(
+    cp_csg2_t *r,
+    size_t zi);
+
+static void v_csg2_delete_layer(
+    cp_v_obj_p_t *r,
+    size_t zi)
+{
+    for (cp_v_each(i, r)) {
+        csg2_delete_layer(cp_csg2_cast(cp_csg2_t, cp_v_nth(r, i)), zi);
+    }
+}
+
+static void v_add_delete_layer(
+    cp_v_csg_add_p_t *r,
+    size_t zi)
+{
+    for (cp_v_each(i, r)) {
+        v_csg2_delete_layer(&cp_v_nth(r, i)->add, zi);
+    }
+}
+
+static void csg2_delete_layer(
+    cp_csg2_t *r,
+    size_t zi)
+{
+    switch (r->type) {
+    case CP_CSG_ADD:
+        v_csg2_delete_layer(&cp_csg_cast(cp_csg_add_t, r)->add, zi);
+        return;
+
+    case CP_CSG_XOR:
+        v_add_delete_layer(&cp_csg_cast(cp_csg_xor_t, r)->xor, zi);
+        return;
+
+    case CP_CSG_SUB: {
+        cp_csg_sub_t *s = cp_csg_cast(*s, r);
+        v_csg2_delete_layer(&s->add->add, zi);
+        v_csg2_delete_layer(&s->sub->add, zi);
+        return;
+    }
+
+    case CP_CSG_CUT:
+        v_add_delete_layer(&cp_csg_cast(cp_csg_cut_t, r)->cut, zi);
+        return;
+
+    case CP_CSG2_POLY:
+        /* not part of a layer */
+        return;
+
+    case CP_CSG2_STACK: {
+        cp_csg2_layer_t *l = cp_csg2_stack_get_layer(cp_csg2_cast(cp_csg2_stack_t, r), zi);
+        if (l != NULL) {
+            layer_delete(l);
+        }
+        return;
+    }
+    }
+
+    CP_DIE("2D object type %#x", r->type);
+}
+
 /* ********************************************************************** */
 /* extern */
 
@@ -159,8 +298,10 @@ extern void cp_csg_add_init_perhaps(
 
 /**
  * Initialises a CSG2 structure with a tree derived from a CSG3
- * structure, and reserves, for each simple object in the tree, an
- * array of layers of size layer_cnt.
+ * structure, with layers at the z coordinates of range s.
+ *
+ * Each simple object in the tree reserves only the layers that
+ * intersect its bounding box.
  *
  * This assumes a freshly zeroed r to be initialised.
  */
@@ -169,23 +310,133 @@ extern void cp_csg2_tree_from_csg3(
     cp_csg3_tree_t const *d,
     cp_range_t const *s,
     cp_csg_opt_t const *o)
+{
+    cp_a_double_t z;
+    z.size = s->cnt;
+    z.data = CP_NEW_ARR(*z.data, z.size);
+    for (cp_size_each(zi, s->cnt)) {
+        cp_v_nth(&z, zi) = s->min + (s->step * cp_f(zi));
+    }
+    cp_csg2_tree_from_csg3_z(r, d, z.data, z.size, s->step, o);
+    CP_FREE(z.data);
+}
+
+/**
+ * Initialises a CSG2 structure with a tree derived from a CSG3
+ * structure, with layers at the given z coordinates, which must be
+ * sorted in ascending order, e.g., to slice only a few layers on
+ * demand.
+ *
+ * thick is the thickness of each layer in the output.
+ *
+ * Each simple object in the tree reserves only the layers that
+ * intersect its bounding box.
+ *
+ * This assumes a freshly zeroed r to be initialised.
+ */
+extern void cp_csg2_tree_from_csg3_z(
+    cp_csg2_tree_t *r,
+    cp_csg3_tree_t const *d,
+    double const *z,
+    size_t z_cnt,
+    cp_dim_t thick,
+    cp_csg_opt_t const *o)
 {
     assert(d != NULL);
     cp_csg_add_t *root = cp_csg_new(*root, d->root ? d->root->loc : NULL);
     r->root = cp_csg2_cast(*r->root, root);
-    r->thick = s->step;
+    r->thick = thick;
     r->opt = o;
 
-    cp_v_init0(&r->flag, s->cnt);
+    cp_v_init0(&r->flag, z_cnt);
 
-    cp_v_init0(&r->z, s->cnt);
-    for (cp_size_each(zi, s->cnt)) {
-        cp_v_nth(&r->z, zi) = s->min + (s->step * cp_f(zi));
+    cp_v_init0(&r->z, z_cnt);
+    for (cp_size_each(zi, z_cnt)) {
+        assert((zi == 0) || (z[zi-1] < z[zi]));
+        cp_v_nth(&r->z, zi) = z[zi];
     }
 
     if (d->root == NULL) {
         return;
     }
 
-    csg2_tree_from_v_csg3(r, s, &cp_csg_cast(cp_csg_add_t, r->root)->add, &d->root->add);
+    csg2_tree_from_v_csg3(r, &cp_csg_cast(cp_csg_add_t, r->root)->add, &d->root->add);
+}
+
+/**
+ * Delete a CSG2 object and all its children, including the
+ * layers of stacks and the diff polygons.
+ */
+extern void cp_csg2_delete(
+    cp_csg2_t *r)
+{
+    switch (r->type) {
+    case CP_CSG_ADD:
+        add_delete(cp_csg_cast(cp_csg_add_t, r));
+        return;
+
+    case CP_CSG_XOR: {
+        cp_csg_xor_t *x = cp_csg_cast(*x, r);
+        v_add_delete(&x->xor);
+        CP_FREE(x);
+        return;
+    }
+
+    case CP_CSG_SUB: {
+        cp_csg_sub_t *s = cp_csg_cast(*s, r);
+        add_delete(s->add);
+        add_delete(s->sub);
+        CP_FREE(s);
+        return;
+    }
+
+    case CP_CSG_CUT: {
+        cp_csg_cut_t *c = cp_csg_cast(*c, r);
+        v_add_delete(&c->cut);
+        CP_FREE(c);
+        return;
+    }
+
+    case CP_CSG2_POLY:
+        poly_delete(cp_csg2_cast(cp_csg2_poly_t, r));
+        return;
+
+    case CP_CSG2_STACK:
+        stack_delete(cp_csg2_cast(cp_csg2_stack_t, r));
+        return;
+    }
+
+    CP_DIE("2D object type %#x", r->type);
+}
+
+/**
+ * Delete the contents of layer zi in all stacks of the tree.
+ *
+ * The layer slots themselves are kept, but are empty afterwards.
+ * This is used to release layers that are no longer needed,
+ * e.g., after they have been written.
+ */
+extern void cp_csg2_tree_delete_layer(
+    cp_csg2_tree_t *t,
+    size_t zi)
+{
+    if (t->root == NULL) {
+        return;
+    }
+    csg2_delete_layer(t->root, zi);
+}
+
+/**
+ * Delete all objects and layers of a CSG2 tree.  The tree itself is
+ * not freed.
+ */
+extern void cp_csg2_tree_fini(
+    cp_csg2_tree_t *t)
+{
+    if (t->root != NULL) {
+        cp_csg2_delete(t->root);
+    }
+    CP_FREE(t->z.data);
+    CP_FREE(t->flag.data);
+    CP_ZERO(t);
 }
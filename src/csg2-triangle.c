@@ -9,10 +9,12 @@
 #include <hob3lbase/list.h>
 #include <hob3lbase/panic.h>
 #include <hob3lbase/pool.h>
+#include <hob3lbase/trace.h>
 #include <hob3l/csg.h>
 #include <hob3l/csg2.h>
 #include <hob3l/ps.h>
 #include "internal.h"
+#include "probe.h"
 
 typedef enum {
     INACTIVE,
@@ -1083,12 +1085,14 @@ static bool transition(
 }
 
 static bool csg2_tri_v_csg2(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_v_obj_p_t *r,
     size_t zi);
 
 static bool csg2_tri_layer(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg2_layer_t *r)
@@ -1096,10 +1100,11 @@ static bool csg2_tri_layer(
     if (r->root == NULL) {
         return true;
     }
-    return csg2_tri_v_csg2(tmp, t, &r->root->add, r->zi);
+    return csg2_tri_v_csg2(opt, tmp, t, &r->root->add, r->zi);
 }
 
 static bool csg2_tri_stack(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg2_stack_t *r,
@@ -1109,37 +1114,40 @@ static bool csg2_tri_stack(
     if ((l == NULL) || (l->root == NULL)) {
         return true;
     }
-    return csg2_tri_layer(tmp, t, l);
+    return csg2_tri_layer(opt, tmp, t, l);
 }
 
 static bool csg2_tri_sub(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg_sub_t *r,
     size_t zi)
 {
     return
-        csg2_tri_v_csg2(tmp, t, &r->add->add, zi) &&
-        csg2_tri_v_csg2(tmp, t, &r->sub->add, zi);
+        csg2_tri_v_csg2(opt, tmp, t, &r->add->add, zi) &&
+        csg2_tri_v_csg2(opt, tmp, t, &r->sub->add, zi);
 }
 
 static bool csg2_tri_add(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg_add_t *r,
     size_t zi)
 {
-    return csg2_tri_v_csg2(tmp, t, &r->add, zi);
+    return csg2_tri_v_csg2(opt, tmp, t, &r->add, zi);
 }
 
 static bool csg2_tri_cut(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg_cut_t *r,
     size_t zi)
 {
     for (cp_v_each(i, &r->cut)) {
-        if (!csg2_tri_v_csg2(tmp, t, &r->cut.data[i]->add, zi)) {
+        if (!csg2_tri_v_csg2(opt, tmp, t, &r->cut.data[i]->add, zi)) {
             return false;
         }
     }
@@ -1147,13 +1155,14 @@ static bool csg2_tri_cut(
 }
 
 static bool csg2_tri_xor(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg_xor_t *r,
     size_t zi)
 {
     for (cp_v_each(i, &r->xor)) {
-        if (!csg2_tri_v_csg2(tmp, t, &r->xor.data[i]->add, zi)) {
+        if (!csg2_tri_v_csg2(opt, tmp, t, &r->xor.data[i]->add, zi)) {
             return false;
         }
     }
@@ -1161,6 +1170,7 @@ static bool csg2_tri_xor(
 }
 
 static bool csg2_tri_csg2(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg2_t *r,
@@ -1168,35 +1178,36 @@ static bool csg2_tri_csg2(
 {
     switch (r->type) {
     case CP_CSG2_POLY:
-        return cp_csg2_tri_poly(tmp, t, cp_csg2_cast(cp_csg2_poly_t, r));
+        return cp_csg2_tri_poly(opt, tmp, t, cp_csg2_cast(cp_csg2_poly_t, r));
 
     case CP_CSG2_STACK:
-        return csg2_tri_stack(tmp, t, cp_csg2_cast(cp_csg2_stack_t, r), zi);
+        return csg2_tri_stack(opt, tmp, t, cp_csg2_cast(cp_csg2_stack_t, r), zi);
 
     case CP_CSG_ADD:
-        return csg2_tri_add(tmp, t, cp_csg_cast(cp_csg_add_t, r), zi);
+        return csg2_tri_add(opt, tmp, t, cp_csg_cast(cp_csg_add_t, r), zi);
 
     case CP_CSG_XOR:
-        return csg2_tri_xor(tmp, t, cp_csg_cast(cp_csg_xor_t, r), zi);
+        return csg2_tri_xor(opt, tmp, t, cp_csg_cast(cp_csg_xor_t, r), zi);
 
     case CP_CSG_SUB:
-        return csg2_tri_sub(tmp, t, cp_csg_cast(cp_csg_sub_t, r), zi);
+        return csg2_tri_sub(opt, tmp, t, cp_csg_cast(cp_csg_sub_t, r), zi);
 
     case CP_CSG_CUT:
-        return csg2_tri_cut(tmp, t, cp_csg_cast(cp_csg_cut_t, r), zi);
+        return csg2_tri_cut(opt, tmp, t, cp_csg_cast(cp_csg_cut_t, r), zi);
     }
 
     CP_DIE("2D object type: %#x", r->type);
 }
 
 static bool csg2_tri_v_csg2(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_v_obj_p_t *r,
     size_t zi)
 {
     for (cp_v_each(i, r)) {
-        if (!csg2_tri_csg2(tmp, t, cp_csg2_cast(cp_csg2_t, cp_v_nth(r,i)), zi)) {
+        if (!csg2_tri_csg2(opt, tmp, t, cp_csg2_cast(cp_csg2_t, cp_v_nth(r,i)), zi)) {
             return false;
         }
     }
@@ -1204,12 +1215,14 @@ static bool csg2_tri_v_csg2(
 }
 
 static bool csg2_tri_diff_v_csg2(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_v_obj_p_t *r,
     size_t zi);
 
 static bool csg2_tri_diff_layer(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg2_layer_t *r)
@@ -1217,10 +1230,11 @@ static bool csg2_tri_diff_layer(
     if (r->root == NULL) {
         return true;
     }
-    return csg2_tri_diff_v_csg2(tmp, t, &r->root->add, r->zi);
+    return csg2_tri_diff_v_csg2(opt, tmp, t, &r->root->add, r->zi);
 }
 
 static bool csg2_tri_diff_stack(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg2_stack_t *r,
@@ -1230,21 +1244,22 @@ static bool csg2_tri_diff_stack(
     if (l == NULL) {
         return true;
     }
-    return csg2_tri_diff_layer(tmp, t, l);
+    return csg2_tri_diff_layer(opt, tmp, t, l);
 }
 
 static bool csg2_tri_diff_poly(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg2_poly_t *g)
 {
     if (g->diff_above != NULL) {
-        if (!cp_csg2_tri_poly(tmp, t, g->diff_above)) {
+        if (!cp_csg2_tri_poly(opt, tmp, t, g->diff_above)) {
             return false;
         }
     }
     if (g->diff_below != NULL) {
-        if (!cp_csg2_tri_poly(tmp, t, g->diff_below)) {
+        if (!cp_csg2_tri_poly(opt, tmp, t, g->diff_below)) {
             return false;
         }
     }
@@ -1252,6 +1267,7 @@ static bool csg2_tri_diff_poly(
 }
 
 static bool csg2_tri_diff_csg2(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg2_t *r,
@@ -1259,28 +1275,107 @@ static bool csg2_tri_diff_csg2(
 {
     switch (r->type) {
     case CP_CSG2_POLY:
-        return csg2_tri_diff_poly(tmp, t, cp_csg2_cast(cp_csg2_poly_t, r));
+        return csg2_tri_diff_poly(opt, tmp, t, cp_csg2_cast(cp_csg2_poly_t, r));
     case CP_CSG2_STACK:
-        return csg2_tri_diff_stack(tmp, t, cp_csg2_cast(cp_csg2_stack_t, r), zi);
+        return csg2_tri_diff_stack(opt, tmp, t, cp_csg2_cast(cp_csg2_stack_t, r), zi);
     default:
         return true;
     }
 }
 
 static bool csg2_tri_diff_v_csg2(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_v_obj_p_t *r,
     size_t zi)
 {
     for (cp_v_each(i, r)) {
-        if (!csg2_tri_diff_csg2(tmp, t, cp_csg2_cast(cp_csg2_t, cp_v_nth(r,i)), zi)) {
+        if (!csg2_tri_diff_csg2(opt, tmp, t, cp_csg2_cast(cp_csg2_t, cp_v_nth(r,i)), zi)) {
             return false;
         }
     }
     return true;
 }
 
+/**
+ * The work of cp_csg2_tri_set(), without statistics, probes, and
+ * tracing, which are also done on failure.
+ */
+static bool tri_set(
+    cp_csg_opt_t const *opt,
+    cp_pool_t *tmp,
+    cp_err_t *t,
+    cp_vec2_arr_ref_t *point_arr,
+    cp_v_size3_t *tri,
+    cp_a_csg2_3node_t *node)
+{
+    /*
+     * What they fail to mention in the paper is that some nodes need
+     * to be in two lists at the same time, which requires dirty
+     * tricks.  It is solved here by the list_t structure.
+     *
+     * A simplification used here neglects co_p special cases, which
+     * is achieved by an imaginary minimal rotation around z by using
+     * lexicographic order on (x,y) coordinates.  This also means that
+     * the algorith handles subsequent colinear edges correctly without
+     * needing to take special care.
+     */
+
+    /* allocate list cells */
+    size_t list_size = node->size * 2;
+    list_t *list_data = CP_POOL_NEW_ARR(tmp, *list_data, list_size);
+    assert(cp_mem_is0(list_data, sizeof(*list_data) * list_size));
+
+    /* init context */
+    ctxt_t c = {
+        .node = node,
+        .point_arr = point_arr,
+        .tri = tri,
+        .t = t,
+        .nx = NULL,
+        .ey = NULL,
+        .list_data = list_data,
+        .list_size = list_size,
+        .list_end = 0,
+    };
+    cp_list_init(&c.list_free);
+
+    /* connect nodes */
+    for (cp_v_each(i, node)) {
+        node_t *p = &cp_v_nth(node, i);
+        p->out->src = p->in->dst = p;
+    }
+
+    /* insert nodes into set, ordered by coord_cmp() */
+    for (cp_v_each(i, node)) {
+        node_t *p = &cp_v_nth(node, i);
+        cp_list_init(&p->out->list);
+        cp_dict_t *dup __unused =
+            cp_dict_insert(&p->node_nx, &c.nx, cmp_nx, NULL, 0);
+        if (dup != NULL) {
+            cp_vchar_printf(&t->msg, "Duplicate point in polygon path.\n");
+            t->loc = p->loc;
+            return false;
+        }
+    }
+
+    /* traverse in lexicographic order, maintaining the Y structure 'c.ey'. */
+    size_t i = 0;
+    for (cp_dict_each(_p, c.nx)) {
+        LOG("\nPOINT %"_Pz"u %"_Pz"u: %s\n", i, n, node_str(get_nx(_p)));
+        if ((((i + 1) % CP_CANCEL_CHECK_CNT) == 0) && cp_csg_cancelled(opt)) {
+            cp_vchar_printf(&t->msg, "Cancelled.\n");
+            return false;
+        }
+        if (!transition(&c, get_nx(_p))) {
+            return false;
+        }
+        i++;
+    }
+    return true;
+}
+
 /* ********************************************************************** */
 /* extern */
 
@@ -1335,81 +1430,39 @@ static bool csg2_tri_diff_v_csg2(
  * Uses \p tmp for all temporary allocations (but not for constructing
  * point_arr or tri).
  *
+ * If processing is cancelled via opt->progress, this fails with a
+ * 'Cancelled' error.  opt may be NULL.
+ *
  * Runtime: O(n log n)
  * Space: O(n)
  * Where n = number of points.
  */
 extern bool cp_csg2_tri_set(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_vec2_arr_ref_t *point_arr,
     cp_v_size3_t *tri,
     cp_a_csg2_3node_t *node)
 {
-    /*
-     * What they fail to mention in the paper is that some nodes need
-     * to be in two lists at the same time, which requires dirty
-     * tricks.  It is solved here by the list_t structure.
-     *
-     * A simplification used here neglects co_p special cases, which
-     * is achieved by an imaginary minimal rotation around z by using
-     * lexicographic order on (x,y) coordinates.  This also means that
-     * the algorith handles subsequent colinear edges correctly without
-     * needing to take special care.
-     */
     if (node->size == 0) {
         return true;
     }
+    /* tri_end and the trace span are emitted also on failure */
+    CP_PROBE1(tri_begin, node->size);
+    double t_trace = cp_trace_now(cp_csg_trace(opt));
+    size_t tri_size = tri->size;
 
-    /* allocate list cells */
-    size_t list_size = node->size * 2;
-    list_t *list_data = CP_POOL_NEW_ARR(tmp, *list_data, list_size);
-    assert(cp_mem_is0(list_data, sizeof(*list_data) * list_size));
+    bool ok = tri_set(opt, tmp, t, point_arr, tri, node);
 
-    /* init context */
-    ctxt_t c = {
-        .node = node,
-        .point_arr = point_arr,
-        .tri = tri,
-        .t = t,
-        .nx = NULL,
-        .ey = NULL,
-        .list_data = list_data,
-        .list_size = list_size,
-        .list_end = 0,
-    };
-    cp_list_init(&c.list_free);
-
-    /* connect nodes */
-    for (cp_v_each(i, node)) {
-        node_t *p = &cp_v_nth(node, i);
-        p->out->src = p->in->dst = p;
-    }
-
-    /* insert nodes into set, ordered by coord_cmp() */
-    for (cp_v_each(i, node)) {
-        node_t *p = &cp_v_nth(node, i);
-        cp_list_init(&p->out->list);
-        cp_dict_t *dup __unused =
-            cp_dict_insert(&p->node_nx, &c.nx, cmp_nx, NULL, 0);
-        if (dup != NULL) {
-            cp_vchar_printf(&t->msg, "Duplicate point in polygon path.\n");
-            t->loc = p->loc;
-            return false;
-        }
-    }
-
-    /* traverse in lexicographic order, maintaining the Y structure 'c.ey'. */
-    size_t i = 0;
-    for (cp_dict_each(_p, c.nx)) {
-        LOG("\nPOINT %"_Pz"u %"_Pz"u: %s\n", i, n, node_str(get_nx(_p)));
-        if (!transition(&c, get_nx(_p))) {
-            return false;
-        }
-        i++;
+    if (ok && (opt != NULL) && (opt->stat != NULL)) {
+        opt->stat->triangle_cnt += tri->size - tri_size;
+        opt->stat->tri_node_cnt += node->size;
     }
-
-    return true;
+    CP_PROBE3(tri_end, node->size, tri->size - tri_size, ok);
+    cp_trace_span_args(cp_csg_trace(opt), "tri", t_trace,
+        "\"points\":%"_Pz"u,\"triangles\":%"_Pz"u", node->size, tri->size - tri_size);
+    return ok;
 }
 
 /**
@@ -1428,6 +1481,7 @@ extern bool cp_csg2_tri_set(
  * Where n = number of points.
  */
 extern bool cp_csg2_tri_path(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg2_poly_t *g,
@@ -1457,7 +1511,7 @@ extern bool cp_csg2_tri_path(
 
     cp_vec2_arr_ref_t a2;
     cp_vec2_arr_ref_from_v_vec2_loc(&a2, &g->point);
-    return cp_csg2_tri_set(tmp, t, &a2, &g->triangle, &a);
+    return cp_csg2_tri_set(opt, tmp, t, &a2, &g->triangle, &a);
 }
 
 /**
@@ -1476,6 +1530,7 @@ extern bool cp_csg2_tri_path(
  * Where n = number of points.
  */
 extern bool cp_csg2_tri_poly(
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_csg2_poly_t *g)
@@ -1527,7 +1582,7 @@ extern bool cp_csg2_tri_poly(
     /* run the triangulation algorithm */
     cp_vec2_arr_ref_t a2;
     cp_vec2_arr_ref_from_v_vec2_loc(&a2, &g->point);
-    if (!cp_csg2_tri_set(tmp, t, &a2, &g->triangle, &a)) {
+    if (!cp_csg2_tri_set(opt, tmp, t, &a2, &g->triangle, &a)) {
         return false;
     }
     assert(g->triangle.size  <= tri_cnt);
@@ -1539,6 +1594,7 @@ extern bool cp_csg2_tri_poly(
  */
 extern bool cp_csg2_tri_vec2_arr_ref(
     cp_v_size3_t *tri,
+    cp_csg_opt_t const *opt,
     cp_pool_t *tmp,
     cp_err_t *t,
     cp_loc_t loc,
@@ -1570,7 +1626,7 @@ extern bool cp_csg2_tri_vec2_arr_ref(
     cp_a_csg2_3node_t a = CP_A_INIT_WITH(node, n);
 
     /* run the triangulation algorithm */
-    if (!cp_csg2_tri_set(tmp, t, a2, tri, &a)) {
+    if (!cp_csg2_tri_set(opt, tmp, t, a2, tri, &a)) {
         return false;
     }
     assert(tri->size  <= n);
@@ -1609,7 +1665,7 @@ extern bool cp_csg2_tri_layer(
     if (r->root == NULL) {
         return true;
     }
-    return csg2_tri_csg2(tmp, t, r->root, zi);
+    return csg2_tri_csg2(r->opt, tmp, t, r->root, zi);
 }
 
 /**
@@ -1629,5 +1685,5 @@ extern bool cp_csg2_tri_layer_diff(
     if (r->root == NULL) {
         return true;
     }
-    return csg2_tri_diff_csg2(tmp, t, r->root, zi);
+    return csg2_tri_diff_csg2(r->opt, tmp, t, r->root, zi);
 }
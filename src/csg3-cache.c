@@ -0,0 +1,977 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/* for realpath() and fileno() */
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <math.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <hob3lbase/mat.h>
+#include <hob3lbase/panic.h>
+#include <hob3lbase/vchar.h>
+#include <hob3lbase/alloc.h>
+#include <hob3l/csg.h>
+#include <hob3l/csg2.h>
+#include <hob3l/csg3.h>
+#include <hob3l/csg3-cache.h>
+#include "internal.h"
+
+/**
+ * Cache file format version.  Increment whenever the layout changes.
+ */
+#define CACHE_VERSION 1
+
+/** File magic */
+#define CACHE_MAGIC "HOB3LC\0\0"
+
+/** To detect files written on a machine with a different byte order */
+#define CACHE_BYTE_ORDER 0x0102030405060708ULL
+
+/**
+ * Header.  Every entry in the file is a 64-bit word, so there are no
+ * alignment issues.  References are offsets from the file start.
+ */
+enum {
+    H_MAGIC,
+    H_VERSION,
+    H_BYTE_ORDER,
+    H_SIZE_F,
+    H_SIZE_MAT,
+    H_PT_EPSILON,
+    H_EQ_EPSILON,
+    H_MAX_FN,
+    H_ERR_EMPTY,
+    H_ERR_COLLAPSE,
+    H_ERR_OUTSIDE_3D,
+    H_ERR_OUTSIDE_2D,
+    H_FILE_SIZE,
+    H_SRC_OFF,
+    H_ROOT_OFF,
+    H_COUNT
+};
+
+/** Size of a matrix in 64-bit words */
+#define MAT_WORDS ((sizeof(cp_mat3wi_t) + 7) / 8)
+
+/* ********************************************************************** */
+/* writing */
+
+static size_t put_u64(
+    cp_vchar_t *b,
+    uint64_t x)
+{
+    size_t o = b->size;
+    cp_vchar_append_arr(b, (char const *)&x, sizeof(x));
+    return o;
+}
+
+static void put_f(
+    cp_vchar_t *b,
+    cp_f_t x)
+{
+    cp_static_assert(sizeof(x) == 8);
+    cp_vchar_append_arr(b, (char const *)&x, sizeof(x));
+}
+
+static uint64_t f_bits(
+    cp_f_t x)
+{
+    uint64_t u;
+    memcpy(&u, &x, sizeof(u));
+    return u;
+}
+
+static void set_u64(
+    cp_vchar_t *b,
+    size_t off,
+    uint64_t x)
+{
+    assert((off + sizeof(x)) <= b->size);
+    memcpy(b->data + off, &x, sizeof(x));
+}
+
+static void put_gc(
+    cp_vchar_t *b,
+    cp_gc_t const *gc)
+{
+    put_u64(b,
+        ((uint64_t)gc->color.r)       |
+        ((uint64_t)gc->color.g << 8)  |
+        ((uint64_t)gc->color.b << 16) |
+        ((uint64_t)gc->color.a << 24));
+    put_u64(b, gc->modifier);
+}
+
+static void put_mat(
+    cp_vchar_t *b,
+    cp_mat3wi_t const *m)
+{
+    uint64_t w[MAT_WORDS] = {0};
+    memcpy(w, m, sizeof(*m));
+    for (cp_arr_each(i, w)) {
+        put_u64(b, w[i]);
+    }
+}
+
+static uint64_t put_csg3(
+    cp_vchar_t *b,
+    cp_obj_t const *o);
+
+static uint64_t put_add(
+    cp_vchar_t *b,
+    cp_csg_add_t const *r)
+{
+    /* children first, so that all references point backwards */
+    uint64_t *off = CP_NEW_ARR(*off, r->add.size);
+    for (cp_v_each(i, &r->add)) {
+        off[i] = put_csg3(b, cp_v_nth(&r->add, i));
+    }
+
+    size_t o = put_u64(b, CP_CSG_ADD);
+    put_u64(b, r->add.size);
+    for (cp_v_each(i, &r->add)) {
+        put_u64(b, off[i]);
+    }
+    CP_FREE(off);
+    return o;
+}
+
+static uint64_t put_v_add(
+    cp_vchar_t *b,
+    unsigned type,
+    cp_v_csg_add_p_t const *r)
+{
+    uint64_t *off = CP_NEW_ARR(*off, r->size);
+    for (cp_v_each(i, r)) {
+        off[i] = put_add(b, cp_v_nth(r, i));
+    }
+
+    size_t o = put_u64(b, type);
+    put_u64(b, r->size);
+    for (cp_v_each(i, r)) {
+        put_u64(b, off[i]);
+    }
+    CP_FREE(off);
+    return o;
+}
+
+static uint64_t put_sub(
+    cp_vchar_t *b,
+    cp_csg_sub_t const *r)
+{
+    uint64_t add = put_add(b, r->add);
+    uint64_t sub = put_add(b, r->sub);
+    size_t o = put_u64(b, CP_CSG_SUB);
+    put_u64(b, add);
+    put_u64(b, sub);
+    return o;
+}
+
+static uint64_t put_sphere(
+    cp_vchar_t *b,
+    cp_csg3_sphere_t const *r)
+{
+    size_t o = put_u64(b, CP_CSG3_SPHERE);
+    put_gc(b, &r->gc);
+    put_f(b, r->_fa);
+    put_f(b, r->_fs);
+    put_u64(b, r->_fn);
+    put_mat(b, r->mat);
+    return o;
+}
+
+static uint64_t put_poly(
+    cp_vchar_t *b,
+    cp_csg3_poly_t const *r)
+{
+    size_t o = put_u64(b, CP_CSG3_POLY);
+    put_gc(b, &r->gc);
+    put_u64(b, r->is_cube);
+    put_u64(b, r->point.size);
+    put_u64(b, r->edge.size);
+    put_u64(b, r->face.size);
+
+    for (cp_v_each(i, &r->point)) {
+        cp_vec3_t const *v = &cp_v_nth(&r->point, i).coord;
+        put_f(b, v->x);
+        put_f(b, v->y);
+        put_f(b, v->z);
+    }
+
+    for (cp_v_each(i, &r->face)) {
+        cp_csg3_face_t const *f = &cp_v_nth(&r->face, i);
+        put_u64(b, f->point.size);
+        for (cp_v_each(j, &f->point)) {
+            put_u64(b, cp_v_idx(&r->point, cp_v_nth(&f->point, j).ref));
+        }
+        for (cp_v_each(j, &f->edge)) {
+            put_u64(b, cp_v_idx(&r->edge, cp_v_nth(&f->edge, j)));
+        }
+    }
+
+    for (cp_v_each(i, &r->edge)) {
+        cp_csg3_edge_t const *e = &cp_v_nth(&r->edge, i);
+        put_u64(b, cp_v_idx(&r->face, e->fore));
+        put_u64(b, cp_v_idx(&e->fore->point, e->src));
+        put_u64(b, cp_v_idx(&r->face, e->back));
+        put_u64(b, cp_v_idx(&e->back->point, e->dst));
+    }
+    return o;
+}
+
+static uint64_t put_poly2(
+    cp_vchar_t *b,
+    cp_csg2_poly_t const *r)
+{
+    size_t o = put_u64(b, CP_CSG2_POLY);
+    put_u64(b, r->point.size);
+    for (cp_v_each(i, &r->point)) {
+        cp_vec2_loc_t const *v = &cp_v_nth(&r->point, i);
+        put_f(b, v->coord.x);
+        put_f(b, v->coord.y);
+        put_gc(b, &(cp_gc_t){ .color = v->color });
+    }
+    put_u64(b, r->path.size);
+    for (cp_v_each(i, &r->path)) {
+        cp_csg2_path_t const *p = &cp_v_nth(&r->path, i);
+        put_u64(b, p->point_idx.size);
+        for (cp_v_each(j, &p->point_idx)) {
+            put_u64(b, cp_v_nth(&p->point_idx, j));
+        }
+    }
+    put_u64(b, r->triangle.size);
+    for (cp_v_each(i, &r->triangle)) {
+        for (cp_size_each(j, 3)) {
+            put_u64(b, cp_v_nth(&r->triangle, i).p[j]);
+        }
+    }
+    return o;
+}
+
+static uint64_t put_csg3(
+    cp_vchar_t *b,
+    cp_obj_t const *o)
+{
+    switch (o->type) {
+    case CP_CSG_ADD:
+        return put_add(b, cp_csg_cast(cp_csg_add_t, o));
+
+    case CP_CSG_SUB:
+        return put_sub(b, cp_csg_cast(cp_csg_sub_t, o));
+
+    case CP_CSG_CUT:
+        return put_v_add(b, CP_CSG_CUT, &cp_csg_cast(cp_csg_cut_t, o)->cut);
+
+    case CP_CSG_XOR:
+        return put_v_add(b, CP_CSG_XOR, &cp_csg_cast(cp_csg_xor_t, o)->xor);
+
+    case CP_CSG3_SPHERE:
+        return put_sphere(b, cp_csg3_cast(cp_csg3_sphere_t, o));
+
+    case CP_CSG3_POLY:
+        return put_poly(b, cp_csg3_cast(cp_csg3_poly_t, o));
+
+    case CP_CSG2_POLY:
+        return put_poly2(b, cp_csg2_cast(cp_csg2_poly_t, o));
+    }
+    CP_DIE("CSG3 object type");
+}
+
+/**
+ * FNV-1a hash: add bytes to h.
+ */
+static void hash_bytes(
+    uint64_t *h,
+    unsigned char const *data,
+    size_t size)
+{
+    for (cp_size_each(i, size)) {
+        *h ^= data[i];
+        *h *= 0x100000001b3ULL;
+    }
+}
+
+/**
+ * FNV-1a hash of the content of a file.
+ */
+static bool hash_file(
+    uint64_t *h,
+    char const *filename)
+{
+    FILE *f = fopen(filename, "rb");
+    if (f == NULL) {
+        return false;
+    }
+    *h = 0xcbf29ce484222325ULL;
+    for (;;) {
+        unsigned char buff[4096];
+        size_t cnt = fread(buff, 1, sizeof(buff), f);
+        if (cnt == 0) {
+            break;
+        }
+        hash_bytes(h, buff, cnt);
+    }
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+static void put_header(
+    cp_vchar_t *b,
+    cp_csg_opt_t const *opt)
+{
+    cp_vchar_append_arr(b, CACHE_MAGIC, 8);
+    put_u64(b, CACHE_VERSION);
+    put_u64(b, CACHE_BYTE_ORDER);
+    put_u64(b, sizeof(cp_f_t));
+    put_u64(b, sizeof(cp_mat3wi_t));
+    put_f  (b, cp_pt_epsilon);
+    put_f  (b, cp_eq_epsilon);
+    put_u64(b, opt->max_fn);
+    put_u64(b, opt->err_empty);
+    put_u64(b, opt->err_collapse);
+    put_u64(b, opt->err_outside_3d);
+    put_u64(b, opt->err_outside_2d);
+    put_u64(b, 0); /* file size */
+    put_u64(b, 0); /* src */
+    put_u64(b, 0); /* root */
+    assert(b->size == (H_COUNT * 8));
+}
+
+static bool put_sources(
+    cp_vchar_t *b,
+    cp_err_t *err,
+    cp_syn_tree_t const *syn)
+{
+    put_u64(b, syn->file.size);
+    for (cp_v_each(i, &syn->file)) {
+        char const *fn = cp_v_nth(&syn->file, i)->filename.data;
+        uint64_t h;
+        if (!hash_file(&h, fn)) {
+            cp_vchar_printf(&err->msg, "Unable to read '%s' for hashing: %s\n",
+                fn, strerror(errno));
+            return false;
+        }
+
+        /* store absolute names so that the cache can be used from any directory */
+        char *abs = realpath(fn, NULL);
+        if (abs != NULL) {
+            fn = abs;
+        }
+        size_t len = strlen(fn);
+        put_u64(b, h);
+        put_u64(b, len);
+        cp_vchar_append_arr(b, fn, len);
+        while ((b->size % 8) != 0) {
+            cp_vchar_push(b, '\0');
+        }
+        free(abs);
+    }
+    return true;
+}
+
+/* ********************************************************************** */
+/* reading */
+
+typedef struct {
+    unsigned char const *data;
+    size_t size;
+    bool ok;
+} rd_t;
+
+static uint64_t get_u64(
+    rd_t *r,
+    uint64_t off)
+{
+    if ((off > r->size) || ((r->size - off) < 8)) {
+        r->ok = false;
+        return 0;
+    }
+    uint64_t x;
+    memcpy(&x, r->data + off, sizeof(x));
+    return x;
+}
+
+/**
+ * Read a count of n entries of w words each following offset 'off',
+ * making sure that they fit into the file.
+ */
+static size_t get_cnt(
+    rd_t *r,
+    uint64_t off,
+    size_t w)
+{
+    uint64_t n = get_u64(r, off);
+    if (n > ((r->size / 8) / w)) {
+        r->ok = false;
+        return 0;
+    }
+    return (size_t)n;
+}
+
+static cp_f_t get_f(
+    rd_t *r,
+    uint64_t off)
+{
+    uint64_t x = get_u64(r, off);
+    cp_f_t f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+static size_t get_idx(
+    rd_t *r,
+    uint64_t off,
+    size_t n)
+{
+    uint64_t x = get_u64(r, off);
+    if (x >= n) {
+        r->ok = false;
+        return 0;
+    }
+    return (size_t)x;
+}
+
+static void get_gc(
+    rd_t *r,
+    cp_gc_t *gc,
+    uint64_t off)
+{
+    uint64_t c = get_u64(r, off);
+    gc->color.r = (unsigned char)(c & 0xff);
+    gc->color.g = (unsigned char)((c >> 8) & 0xff);
+    gc->color.b = (unsigned char)((c >> 16) & 0xff);
+    gc->color.a = (unsigned char)((c >> 24) & 0xff);
+    gc->modifier = (unsigned)get_u64(r, off + 8);
+}
+
+static cp_obj_t *get_csg3(
+    rd_t *r,
+    cp_csg3_tree_t *t,
+    uint64_t off,
+    uint64_t limit);
+
+static cp_csg_add_t *get_add(
+    rd_t *r,
+    cp_csg3_tree_t *t,
+    uint64_t off,
+    uint64_t limit)
+{
+    cp_obj_t *o = get_csg3(r, t, off, limit);
+    if ((o == NULL) || (o->type != CP_CSG_ADD)) {
+        r->ok = false;
+        return NULL;
+    }
+    return cp_csg_cast(cp_csg_add_t, o);
+}
+
+static void get_v_add(
+    rd_t *r,
+    cp_csg3_tree_t *t,
+    cp_v_csg_add_p_t *v,
+    uint64_t off)
+{
+    size_t n = get_cnt(r, off + 8, 1);
+    cp_v_init0(v, n);
+    for (cp_v_each(i, v)) {
+        cp_v_nth(v, i) = get_add(r, t, get_u64(r, off + 16 + (8 * i)), off);
+        if (!r->ok) {
+            return;
+        }
+    }
+}
+
+static void get_sphere(
+    rd_t *r,
+    cp_csg3_tree_t *t,
+    cp_csg3_sphere_t *o,
+    uint64_t off)
+{
+    get_gc(r, &o->gc, off + 8);
+    o->_fa = get_f(r, off + 24);
+    o->_fs = get_f(r, off + 32);
+    o->_fn = (size_t)get_u64(r, off + 40);
+
+    uint64_t w[MAT_WORDS];
+    for (cp_arr_each(i, w)) {
+        w[i] = get_u64(r, off + 48 + (8 * i));
+    }
+    cp_mat3wi_t *m = CP_NEW(*m);
+    memcpy(m, w, sizeof(*m));
+    cp_v_push(&t->mat, m);
+    o->mat = m;
+}
+
+static void get_poly(
+    rd_t *r,
+    cp_csg3_poly_t *o,
+    uint64_t off)
+{
+    get_gc(r, &o->gc, off + 8);
+    o->is_cube = get_u64(r, off + 24) != 0;
+    size_t np = get_cnt(r, off + 32, 3);
+    size_t ne = get_cnt(r, off + 40, 4);
+    size_t nf = get_cnt(r, off + 48, 1);
+    if (!r->ok) {
+        return;
+    }
+    off += 56;
+
+    cp_v_init0(&o->point, np);
+    for (cp_v_each(i, &o->point)) {
+        cp_vec3_t *v = &cp_v_nth(&o->point, i).coord;
+        v->x = get_f(r, off);
+        v->y = get_f(r, off + 8);
+        v->z = get_f(r, off + 16);
+        off += 24;
+        if (!isfinite(v->x) || !isfinite(v->y) || !isfinite(v->z)) {
+            r->ok = false;
+        }
+    }
+
+    cp_v_init0(&o->edge, ne);
+    cp_v_init0(&o->face, nf);
+    for (cp_v_each(i, &o->face)) {
+        cp_csg3_face_t *f = &cp_v_nth(&o->face, i);
+        size_t n = get_cnt(r, off, 2);
+        off += 8;
+        if (!r->ok) {
+            return;
+        }
+        cp_v_init0(&f->point, n);
+        cp_v_init0(&f->edge, n);
+        /* indices must be checked before use: the arrays may be empty */
+        for (cp_v_each(j, &f->point)) {
+            size_t k = get_idx(r, off, np);
+            off += 8;
+            if (!r->ok) {
+                return;
+            }
+            cp_v_nth(&f->point, j).ref = &cp_v_nth(&o->point, k);
+        }
+        for (cp_v_each(j, &f->edge)) {
+            size_t k = get_idx(r, off, ne);
+            off += 8;
+            if (!r->ok) {
+                return;
+            }
+            cp_v_nth(&f->edge, j) = &cp_v_nth(&o->edge, k);
+        }
+    }
+
+    for (cp_v_each(i, &o->edge)) {
+        cp_csg3_edge_t *e = &cp_v_nth(&o->edge, i);
+        size_t fore = get_idx(r, off, nf);
+        size_t back = get_idx(r, off + 16, nf);
+        if (!r->ok) {
+            return;
+        }
+        e->fore = &cp_v_nth(&o->face, fore);
+        e->back = &cp_v_nth(&o->face, back);
+        size_t src = get_idx(r, off + 8,  e->fore->point.size);
+        size_t dst = get_idx(r, off + 24, e->back->point.size);
+        if (!r->ok) {
+            return;
+        }
+        e->src = &cp_v_nth(&e->fore->point, src);
+        e->dst = &cp_v_nth(&e->back->point, dst);
+        off += 32;
+    }
+
+    /* check adjacency so that a corrupt file cannot break slicing */
+    for (cp_v_each(i, &o->face)) {
+        cp_csg3_face_t *f = &cp_v_nth(&o->face, i);
+        size_t n = f->point.size;
+        for (cp_v_each(j, &f->edge)) {
+            cp_csg3_edge_t *e = cp_v_nth(&f->edge, j);
+            size_t k = (j + 1) % n;
+            if (e->fore == f) {
+                if ((cp_v_idx(&f->point, e->src) != j) ||
+                    (cp_v_nth(&f->point, k).ref != e->dst->ref))
+                {
+                    r->ok = false;
+                }
+            }
+            else if (e->back == f) {
+                if ((cp_v_idx(&f->point, e->dst) != j) ||
+                    (cp_v_nth(&f->point, k).ref != e->src->ref))
+                {
+                    r->ok = false;
+                }
+            }
+            else {
+                r->ok = false;
+            }
+        }
+    }
+}
+
+static void get_poly2(
+    rd_t *r,
+    cp_csg2_poly_t *o,
+    uint64_t off)
+{
+    size_t np = get_cnt(r, off + 8, 4);
+    off += 16;
+    cp_v_init0(&o->point, np);
+    for (cp_v_each(i, &o->point)) {
+        cp_vec2_loc_t *v = &cp_v_nth(&o->point, i);
+        v->coord.x = get_f(r, off);
+        v->coord.y = get_f(r, off + 8);
+        cp_gc_t gc;
+        get_gc(r, &gc, off + 16);
+        v->color = gc.color;
+        off += 32;
+    }
+
+    size_t npath = get_cnt(r, off, 1);
+    off += 8;
+    cp_v_init0(&o->path, npath);
+    for (cp_v_each(i, &o->path)) {
+        cp_csg2_path_t *p = &cp_v_nth(&o->path, i);
+        size_t n = get_cnt(r, off, 1);
+        off += 8;
+        cp_v_init0(&p->point_idx, n);
+        for (cp_v_each(j, &p->point_idx)) {
+            cp_v_nth(&p->point_idx, j) = get_idx(r, off, np);
+            off += 8;
+        }
+        if (!r->ok) {
+            return;
+        }
+    }
+
+    size_t ntri = get_cnt(r, off, 3);
+    off += 8;
+    cp_v_init0(&o->triangle, ntri);
+    for (cp_v_each(i, &o->triangle)) {
+        for (cp_size_each(j, 3)) {
+            cp_v_nth(&o->triangle, i).p[j] = get_idx(r, off, np);
+            off += 8;
+        }
+    }
+}
+
+/**
+ * Read a node.  All references point backwards, i.e., 'off' must
+ * be below 'limit'; this guarantees termination for corrupt files.
+ */
+static cp_obj_t *get_csg3(
+    rd_t *r,
+    cp_csg3_tree_t *t,
+    uint64_t off,
+    uint64_t limit)
+{
+    if (!r->ok || (off < (H_COUNT * 8)) || (off >= limit)) {
+        r->ok = false;
+        return NULL;
+    }
+
+    switch (get_u64(r, off)) {
+    case CP_CSG_ADD:{
+        cp_csg_add_t *o = cp_csg_new(*o, NULL);
+        size_t n = get_cnt(r, off + 8, 1);
+        cp_v_init0(&o->add, n);
+        for (cp_v_each(i, &o->add)) {
+            cp_v_nth(&o->add, i) = get_csg3(r, t, get_u64(r, off + 16 + (8 * i)), off);
+            if (!r->ok) {
+                break;
+            }
+        }
+        return cp_obj(o);}
+
+    case CP_CSG_SUB:{
+        cp_csg_sub_t *o = cp_csg_new(*o, NULL);
+        o->add = get_add(r, t, get_u64(r, off + 8), off);
+        o->sub = get_add(r, t, get_u64(r, off + 16), off);
+        return cp_obj(o);}
+
+    case CP_CSG_CUT:{
+        cp_csg_cut_t *o = cp_csg_new(*o, NULL);
+        get_v_add(r, t, &o->cut, off);
+        return cp_obj(o);}
+
+    case CP_CSG_XOR:{
+        cp_csg_xor_t *o = cp_csg_new(*o, NULL);
+        get_v_add(r, t, &o->xor, off);
+        return cp_obj(o);}
+
+    case CP_CSG3_SPHERE:{
+        cp_csg3_sphere_t *o = cp_csg3_new(*o, NULL);
+        get_sphere(r, t, o, off);
+        return cp_obj(o);}
+
+    case CP_CSG3_POLY:{
+        cp_csg3_poly_t *o = cp_csg3_new(*o, NULL);
+        get_poly(r, o, off);
+        return cp_obj(o);}
+
+    case CP_CSG2_POLY:{
+        cp_csg2_poly_t *o = cp_csg2_new(*o, NULL);
+        get_poly2(r, o, off);
+        return cp_obj(o);}
+    }
+
+    r->ok = false;
+    return NULL;
+}
+
+/**
+ * Check the source files.  Returns whether they are unchanged.
+ */
+static bool check_sources(
+    rd_t *r,
+    cp_vchar_t *src,
+    uint64_t off)
+{
+    size_t n = get_cnt(r, off, 2);
+    off += 8;
+    bool fresh = true;
+    for (cp_size_each(i, n)) {
+        uint64_t h = get_u64(r, off);
+        size_t len = get_cnt(r, off + 8, 1);
+        off += 16;
+        if (!r->ok || (len > (r->size - off))) {
+            r->ok = false;
+            return false;
+        }
+
+        cp_vchar_t fn;
+        cp_vchar_init(&fn);
+        cp_vchar_append_arr(&fn, (char const *)r->data + off, len);
+        off += (len + 7) & ~(uint64_t)7;
+
+        uint64_t h2;
+        if (!hash_file(&h2, fn.data)) {
+            fprintf(stderr, "Warning: Unable to read source '%s' of cache: %s.  "
+                "Using cache.\n", fn.data, strerror(errno));
+        }
+        else if (h != h2) {
+            fresh = false;
+        }
+
+        if (i == 0) {
+            cp_vchar_clear(src);
+            cp_vchar_append(src, &fn);
+        }
+        cp_vchar_fini(&fn);
+    }
+    return fresh;
+}
+
+static bool check_header(
+    rd_t *r,
+    cp_csg_opt_t const *opt)
+{
+    return
+        (get_u64(r, H_SIZE_F * 8)   == sizeof(cp_f_t)) &&
+        (get_u64(r, H_SIZE_MAT * 8) == sizeof(cp_mat3wi_t)) &&
+        (get_u64(r, H_PT_EPSILON * 8) == f_bits(cp_pt_epsilon)) &&
+        (get_u64(r, H_EQ_EPSILON * 8) == f_bits(cp_eq_epsilon)) &&
+        (get_u64(r, H_MAX_FN * 8)         == opt->max_fn) &&
+        (get_u64(r, H_ERR_EMPTY * 8)      == opt->err_empty) &&
+        (get_u64(r, H_ERR_COLLAPSE * 8)   == opt->err_collapse) &&
+        (get_u64(r, H_ERR_OUTSIDE_3D * 8) == opt->err_outside_3d) &&
+        (get_u64(r, H_ERR_OUTSIDE_2D * 8) == opt->err_outside_2d);
+}
+
+/* ********************************************************************** */
+/* extern */
+
+/**
+ * Write a CSG3 tree into a cache file.
+ *
+ * The source files are taken from syn: their content is hashed by
+ * reading them again.  The file is written under a temporary name
+ * and then renamed, so that readers never see a partial file.
+ *
+ * On error, returns false and fills in err.
+ */
+extern bool cp_csg3_cache_save(
+    cp_err_t *err,
+    char const *filename,
+    cp_csg3_tree_t const *t,
+    cp_syn_tree_t const *syn)
+{
+    cp_vchar_t b;
+    cp_vchar_init(&b);
+    put_header(&b, t->opt);
+
+    size_t src = b.size;
+    bool ok = put_sources(&b, err, syn);
+    if (ok) {
+        set_u64(&b, H_SRC_OFF * 8, src);
+        if (t->root != NULL) {
+            set_u64(&b, H_ROOT_OFF * 8, put_add(&b, t->root));
+        }
+        set_u64(&b, H_FILE_SIZE * 8, b.size);
+
+        cp_vchar_t tmp;
+        cp_vchar_init(&tmp);
+        cp_vchar_printf(&tmp, "%s.new", filename);
+        FILE *f = fopen(tmp.data, "wb");
+        if (f == NULL) {
+            cp_vchar_printf(&err->msg, "Unable to open '%s' for writing: %s\n",
+                tmp.data, strerror(errno));
+            ok = false;
+        }
+        else {
+            ok = (fwrite(b.data, 1, b.size, f) == b.size);
+            ok = (fclose(f) == 0) && ok;
+            if (ok) {
+                ok = (rename(tmp.data, filename) == 0);
+            }
+            if (!ok) {
+                cp_vchar_printf(&err->msg, "Unable to write '%s': %s\n",
+                    filename, strerror(errno));
+                (void)remove(tmp.data);
+            }
+        }
+        cp_vchar_fini(&tmp);
+    }
+
+    cp_vchar_fini(&b);
+    return ok;
+}
+
+/**
+ * Load a CSG3 tree from a cache file written by cp_csg3_cache_save().
+ *
+ * r->opt must be set: it is compared with the options stored in the
+ * file.
+ *
+ * If the cache is stale, i.e., if any of the source files it was
+ * generated from has changed, or if it was generated with different
+ * options, r is left empty, *stale is set to true, and the name of
+ * the top-level source file is stored in src.  If a source file
+ * cannot be read, a warning is printed and the cache is used.  If the
+ * file is corrupt or truncated, but the top-level source file is
+ * known, a warning is printed and the cache is treated as stale, too.
+ *
+ * On error, returns false and fills in err.
+ */
+extern bool cp_csg3_cache_load(
+    cp_csg3_tree_t *r,
+    bool *stale,
+    cp_vchar_t *src,
+    cp_err_t *err,
+    char const *filename)
+{
+    assert(r->opt != NULL);
+    *stale = false;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        cp_vchar_printf(&err->msg, "Unable to open '%s' for reading: %s\n",
+            filename, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        cp_vchar_printf(&err->msg, "Unable to stat '%s': %s\n",
+            filename, strerror(errno));
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size < (H_COUNT * 8)) {
+        close(fd);
+        cp_vchar_printf(&err->msg, "'%s': Not a Hob3l cache file.\n", filename);
+        return false;
+    }
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        cp_vchar_printf(&err->msg, "Unable to map '%s': %s\n",
+            filename, strerror(errno));
+        return false;
+    }
+
+    rd_t rd = { .data = data, .size = size, .ok = true };
+    bool ok = true;
+    if (memcmp(data, CACHE_MAGIC, 8) != 0) {
+        cp_vchar_printf(&err->msg, "'%s': Not a Hob3l cache file.\n", filename);
+        ok = false;
+    }
+    else
+    if ((get_u64(&rd, H_VERSION * 8) != CACHE_VERSION) ||
+        (get_u64(&rd, H_BYTE_ORDER * 8) != CACHE_BYTE_ORDER))
+    {
+        cp_vchar_printf(&err->msg,
+            "'%s': Incompatible cache file.  Please regenerate.\n",
+            filename);
+        ok = false;
+    }
+    else
+    if (get_u64(&rd, H_FILE_SIZE * 8) != size) {
+        /* The source list comes right after the header, so it is usually
+         * still there: if so, read the source instead. */
+        (void)check_sources(&rd, src, get_u64(&rd, H_SRC_OFF * 8));
+        if (rd.ok && (src->size > 0)) {
+            fprintf(stderr, "Warning: '%s': Truncated cache file.  Re-reading '%s'.\n",
+                filename, src->data);
+            *stale = true;
+        }
+        else {
+            cp_vchar_printf(&err->msg,
+                "'%s': Truncated cache file.  Please regenerate.\n",
+                filename);
+            ok = false;
+        }
+    }
+    else
+    if (!check_sources(&rd, src, get_u64(&rd, H_SRC_OFF * 8)) ||
+        !check_header(&rd, r->opt))
+    {
+        *stale = rd.ok;
+    }
+    else {
+        uint64_t root = get_u64(&rd, H_ROOT_OFF * 8);
+        if (root != 0) {
+            r->root = get_add(&rd, r, root, size);
+        }
+    }
+
+    if (ok && !rd.ok) {
+        if (src->size > 0) {
+            /* The source is known: read that instead.  The partially
+             * read tree is dropped. */
+            fprintf(stderr, "Warning: '%s': Corrupt cache file.  Re-reading '%s'.\n",
+                filename, src->data);
+            r->root = NULL;
+            *stale = true;
+        }
+        else {
+            cp_vchar_printf(&err->msg, "'%s': Corrupt cache file.\n", filename);
+            ok = false;
+        }
+    }
+
+    munmap(data, size);
+    return ok;
+}
+
+/**
+ * Hash a CSG3 object and all its children.
+ *
+ * The hash is computed from the same data that cp_csg3_cache_save()
+ * stores, i.e., from the geometry, the transformation, and the
+ * graphics context, but not from the source location.
+ */
+extern uint64_t cp_csg3_cache_hash(
+    cp_obj_t const *o)
+{
+    cp_vchar_t b;
+    cp_vchar_init(&b);
+    put_csg3(&b, o);
+    uint64_t h = 0xcbf29ce484222325ULL;
+    hash_bytes(&h, (unsigned char const *)b.data, b.size);
+    cp_vchar_fini(&b);
+    return h;
+}
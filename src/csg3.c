@@ -877,7 +877,7 @@ static bool faces_n_edges_from_tower(
     if (need_tri) {
         cp_vec2_arr_ref_t a2;
         cp_vec2_arr_ref_from_a_vec3_loc_xy(&a2, &o->point);
-        if (!cp_csg2_tri_vec2_arr_ref(&tri, c->tmp, c->err, loc, &a2, fn)) {
+        if (!cp_csg2_tri_vec2_arr_ref(&tri, c->opt, c->tmp, c->err, loc, &a2, fn)) {
             return false;
         }
     }
@@ -1112,7 +1112,7 @@ static bool csg3_make_polyhedron_face(
         cp_v_size3_t tri = {0}; /* FIXME: temporary should be in pool */
         cp_vec2_arr_ref_t a2;
         cp_vec2_arr_ref_from_a_vec3_loc_ref(&a2, &s->points, &sf->points, (need_tri == 2));
-        if (!cp_csg2_tri_vec2_arr_ref(&tri, c->tmp, c->err, s->loc, &a2, sf->points.size)) {
+        if (!cp_csg2_tri_vec2_arr_ref(&tri, c->opt, c->tmp, c->err, s->loc, &a2, sf->points.size)) {
             return false;
         }
 
@@ -1205,7 +1205,8 @@ static bool csg3_from_polyhedron(
         }
     }
 
-    /* copy points (same data type, just copy the array) */
+    /* copy points again in original order (same data type, just copy the array) */
+    cp_v_fini(&o->point);
     cp_v_init_with(&o->point, s->points.data, s->points.size);
 
     /* copy faces */
@@ -1275,7 +1276,8 @@ static bool csg3_from_polygon(
         }
     }
 
-    /* copy points (same data type, just copy the array) */
+    /* copy points again in original order (same data type, just copy the array) */
+    cp_v_fini(&o->point);
     cp_v_init_with(&o->point, s->points.data, s->points.size);
 
     /* in-place xform + color */
@@ -1606,6 +1608,104 @@ static bool csg3_from_cylinder(
     return csg3_poly_cylinder(r, c, m, s, mo, r2, fn);
 }
 
+static void v_csg2_delete(
+    cp_v_obj_p_t *r)
+{
+    for (cp_v_each(i, r)) {
+        cp_csg2_delete(cp_csg2_cast(cp_csg2_t, cp_v_nth(r, i)));
+    }
+    cp_v_fini(r);
+}
+
+static bool csg3_linext_poly(
+    cp_v_obj_p_t *r,
+    ctxt_t *c,
+    mat_ctxt_t const *mo,
+    cp_mat3wi_t const *m,
+    cp_scad_linext_t const *s,
+    cp_vec2_t scale,
+    cp_csg2_poly_t const *p)
+{
+    /* empty? */
+    if ((p == NULL) || (p->path.size == 0)) {
+        return true;
+    }
+
+    bool is_cone = cp_eq(scale.x, 0);
+    assert(cp_eq(scale.y, 0) == is_cone);
+
+    size_t zcnt = is_cone ? s->slices : s->slices+1;
+    unsigned tri = TRI_NONE;
+    double twist = s->twist;
+    if (cp_eq(twist, 0)) {
+        twist = 0;
+    }
+    else if (twist > 0) {
+        tri = TRI_RIGHT;
+    }
+    else {
+        tri = TRI_LEFT;
+    }
+
+    /* Use 3D XOR to handle 2D XOR semantics of polygon paths */
+    cp_v_csg_add_p_t *xo = NULL;
+    if (p->path.size >= 2) {
+        cp_csg_xor_t *xor = cp_csg_new(*xor, s->loc);
+        cp_v_push(r, cp_obj(xor));
+        xo = &xor->xor;
+    }
+
+    for (cp_v_each(i, &p->path)) {
+        cp_csg2_path_t const *q = &cp_v_nth(&p->path, i);
+
+        size_t pcnt = q->point_idx.size;
+        size_t tcnt = (zcnt * pcnt) + is_cone;
+
+        /* possibly concave faces: handled by faces_n_edge_from_tower. */
+        cp_csg3_poly_t *o = cp_csg3_new_obj(*o, s->loc, mo->gc);
+        if (xo != NULL) {
+            cp_csg_add_t *o2 = cp_csg_new(*o2, s->loc);
+            cp_v_push(&o2->add, cp_obj(o));
+            cp_v_push(xo, o2);
+        }
+        else {
+            cp_v_push(r, cp_obj(o));
+        }
+
+        cp_v_init0(&o->point, tcnt);
+        for (cp_size_each(k, zcnt)) {
+            double z = cp_dim(k) / cp_dim(s->slices);
+            cp_mat2w_t mk = {0};
+            cp_mat2w_rot(&mk, CP_SINCOS_DEG(z * -twist));
+            cp_mat2w_t mks = {0};
+            cp_mat2w_scale(&mks, cp_lerp(1, s->scale.x, z), cp_lerp(1, s->scale.y, z));
+            cp_mat2w_mul(&mk, &mks, &mk);
+            for (cp_v_each(j, &q->point_idx)) {
+                 cp_vec2_loc_t const *v = &cp_v_nth(&p->point, cp_v_nth(&q->point_idx, j));
+                 cp_vec3_loc_t *w = &cp_v_nth(&o->point, (k * pcnt) + j);
+                 w->coord.z = z;
+                 cp_vec2w_xform(&w->coord.b, &mk, &v->coord);
+                 w->loc = v->loc;
+            }
+        }
+
+        if (is_cone) {
+            cp_vec3_loc_t *w = &cp_v_last(&o->point);
+            w->coord.z = 1;
+            w->coord.x = 0;
+            w->coord.y = 0;
+            w->loc = s->loc;
+        }
+
+        if (!faces_n_edges_from_tower(o, c, m, s->loc, pcnt, s->slices + 1, true, tri, true)) {
+            return msg(c, CP_ERR_FAIL, NULL, NULL,
+                " Internal Error: 'linear_extrude' polyhedron construction algorithm is broken.\n");
+        }
+    }
+
+    return true;
+}
+
 static bool csg3_from_linext(
     bool *no,
     cp_v_obj_p_t *r,
@@ -1681,6 +1781,7 @@ static bool csg3_from_linext(
     mat_ctxt_t mn = *mo;
     mn.mat = the_unit(c->tree);
     if (!csg3_from_v_scad(no, &rc, &c2, &mn, &s->child)) {
+        v_csg2_delete(&rc);
         return false;
     }
 
@@ -1689,86 +1790,11 @@ static bool csg3_from_linext(
 
     /* sweep */
     cp_pool_clear(c->tmp);
-    cp_v_fini(&rc);
-
-    /* empty? */
-    if ((p == NULL) || (p->path.size == 0)) {
-        return true;
-    }
-
-    bool is_cone = cp_eq(scale.x, 0);
-    assert(cp_eq(scale.y, 0) == is_cone);
-
-    size_t zcnt = is_cone ? s->slices : s->slices+1;
-    unsigned tri = TRI_NONE;
-    double twist = s->twist;
-    if (cp_eq(twist, 0)) {
-        twist = 0;
-    }
-    else if (twist > 0) {
-        tri = TRI_RIGHT;
-    }
-    else {
-        tri = TRI_LEFT;
-    }
-
-    /* Use 3D XOR to handle 2D XOR semantics of polygon paths */
-    cp_v_csg_add_p_t *xo = NULL;
-    if (p->path.size >= 2) {
-        cp_csg_xor_t *xor = cp_csg_new(*xor, s->loc);
-        cp_v_push(r, cp_obj(xor));
-        xo = &xor->xor;
-    }
-
-    for (cp_v_each(i, &p->path)) {
-        cp_csg2_path_t const *q = &cp_v_nth(&p->path, i);
-
-        size_t pcnt = q->point_idx.size;
-        size_t tcnt = (zcnt * pcnt) + is_cone;
-
-        /* possibly concave faces: handled by faces_n_edge_from_tower. */
-        cp_csg3_poly_t *o = cp_csg3_new_obj(*o, s->loc, mo->gc);
-        if (xo != NULL) {
-            cp_csg_add_t *o2 = cp_csg_new(*o2, s->loc);
-            cp_v_push(&o2->add, cp_obj(o));
-            cp_v_push(xo, o2);
-        }
-        else {
-            cp_v_push(r, cp_obj(o));
-        }
-
-        cp_v_init0(&o->point, tcnt);
-        for (cp_size_each(k, zcnt)) {
-            double z = cp_dim(k) / cp_dim(s->slices);
-            cp_mat2w_t mk = {0};
-            cp_mat2w_rot(&mk, CP_SINCOS_DEG(z * -twist));
-            cp_mat2w_t mks = {0};
-            cp_mat2w_scale(&mks, cp_lerp(1, s->scale.x, z), cp_lerp(1, s->scale.y, z));
-            cp_mat2w_mul(&mk, &mks, &mk);
-            for (cp_v_each(j, &q->point_idx)) {
-                 cp_vec2_loc_t *v = &cp_v_nth(&p->point, cp_v_nth(&q->point_idx, j));
-                 cp_vec3_loc_t *w = &cp_v_nth(&o->point, (k * pcnt) + j);
-                 w->coord.z = z;
-                 cp_vec2w_xform(&w->coord.b, &mk, &v->coord);
-                 w->loc = v->loc;
-            }
-        }
-
-        if (is_cone) {
-            cp_vec3_loc_t *w = &cp_v_last(&o->point);
-            w->coord.z = 1;
-            w->coord.x = 0;
-            w->coord.y = 0;
-            w->loc = s->loc;
-        }
 
-        if (!faces_n_edges_from_tower(o, c, m, s->loc, pcnt, s->slices + 1, true, tri, true)) {
-            return msg(c, CP_ERR_FAIL, NULL, NULL,
-                " Internal Error: 'linear_extrude' polyhedron construction algorithm is broken.\n");
-        }
-    }
-
-    return true;
+    /* p reuses the polygons of rc, so delete rc only after extruding p */
+    bool ok = csg3_linext_poly(r, c, mo, m, s, scale, p);
+    v_csg2_delete(&rc);
+    return ok;
 }
 
 static bool csg3_from_scad(
@@ -2083,6 +2109,449 @@ extern void cp_csg3_tree_bb(
     get_bb_add(bb, r->root, max);
 }
 
+/**
+ * Get bounding box of a single CSG3 object.
+ *
+ * If max is non-false, the bb will include structures that are
+ * subtracted.
+ *
+ * bb will not be cleared, but only updated.
+ */
+extern void cp_csg3_bb(
+    cp_vec3_minmax_t *bb,
+    cp_csg3_t const *r,
+    bool max)
+{
+    get_bb_csg3(bb, r, max);
+}
+
+static void csg3_delete(
+    cp_obj_t *o);
+
+static void add_delete(
+    cp_csg_add_t *r)
+{
+    for (cp_v_each(i, &r->add)) {
+        csg3_delete(cp_v_nth(&r->add, i));
+    }
+    cp_v_fini(&r->add);
+    CP_FREE(r);
+}
+
+static void v_add_delete(
+    cp_v_csg_add_p_t *r)
+{
+    for (cp_v_each(i, r)) {
+        add_delete(cp_v_nth(r, i));
+    }
+    cp_v_fini(r);
+}
+
+static void poly_delete(
+    cp_csg3_poly_t *r)
+{
+    for (cp_v_each(i, &r->face)) {
+        cp_csg3_face_t *f = &cp_v_nth(&r->face, i);
+        CP_FREE(f->point.data);
+        CP_FREE(f->edge.data);
+    }
+    cp_v_fini(&r->face);
+    CP_FREE(r->point.data);
+    CP_FREE(r->edge.data);
+    CP_FREE(r);
+}
+
+static void csg3_delete(
+    cp_obj_t *o)
+{
+    switch (o->type) {
+    case CP_CSG_ADD:
+        add_delete(cp_csg_cast(cp_csg_add_t, o));
+        return;
+
+    case CP_CSG_SUB: {
+        cp_csg_sub_t *s = cp_csg_cast(*s, o);
+        add_delete(s->add);
+        add_delete(s->sub);
+        CP_FREE(s);
+        return;
+    }
+
+    case CP_CSG_CUT: {
+        cp_csg_cut_t *c = cp_csg_cast(*c, o);
+        v_add_delete(&c->cut);
+        CP_FREE(c);
+        return;
+    }
+
+    case CP_CSG_XOR: {
+        cp_csg_xor_t *x = cp_csg_cast(*x, o);
+        v_add_delete(&x->xor);
+        CP_FREE(x);
+        return;
+    }
+
+    case CP_CSG3_SPHERE: {
+        cp_csg3_sphere_t *s = cp_csg3_cast(*s, o);
+        CP_FREE(s);
+        return;
+    }
+
+    case CP_CSG3_POLY:
+        poly_delete(cp_csg3_cast(cp_csg3_poly_t, o));
+        return;
+
+    case CP_CSG2_POLY:
+        cp_csg2_delete(cp_csg2_cast(cp_csg2_t, o));
+        return;
+    }
+    CP_DIE("CSG3 object type %#x", o->type);
+}
+
+/**
+ * Delete all objects and matrices of a CSG3 tree.  The tree itself is
+ * not freed.
+ */
+extern void cp_csg3_tree_fini(
+    cp_csg3_tree_t *r)
+{
+    if (r->root != NULL) {
+        add_delete(r->root);
+        r->root = NULL;
+    }
+    for (cp_v_each(i, &r->mat)) {
+        CP_FREE(cp_v_nth(&r->mat, i));
+    }
+    cp_v_fini(&r->mat);
+}
+
+/* ********************************************************************** */
+
+static void opt_csg3(
+    cp_v_obj_p_t *o,
+    cp_obj_t *a);
+
+static bool opt_gc_eq(
+    cp_gc_t const *a,
+    cp_gc_t const *b)
+{
+    return
+        (a->modifier == b->modifier) &&
+        (memcmp(a->color.c, b->color.c, sizeof(a->color.c)) == 0);
+}
+
+static bool opt_sphere_eq(
+    cp_csg3_sphere_t const *a,
+    cp_csg3_sphere_t const *b)
+{
+    return
+        opt_gc_eq(&a->gc, &b->gc) &&
+        ((a->mat == b->mat) || cp_mat3wi_eq(a->mat, b->mat)) &&
+        cp_eq(a->_fa, b->_fa) &&
+        cp_eq(a->_fs, b->_fs) &&
+        (a->_fn == b->_fn);
+}
+
+static bool opt_poly_eq(
+    cp_csg3_poly_t const *a,
+    cp_csg3_poly_t const *b)
+{
+    if (!opt_gc_eq(&a->gc, &b->gc) ||
+        (a->point.size != b->point.size) ||
+        (a->face.size != b->face.size))
+    {
+        return false;
+    }
+    for (cp_v_each(i, &a->point)) {
+        if (!cp_vec3_eq(&cp_v_nth(&a->point, i).coord, &cp_v_nth(&b->point, i).coord)) {
+            return false;
+        }
+    }
+    for (cp_v_each(i, &a->face)) {
+        cp_csg3_face_t const *fa = &cp_v_nth(&a->face, i);
+        cp_csg3_face_t const *fb = &cp_v_nth(&b->face, i);
+        if (fa->point.size != fb->point.size) {
+            return false;
+        }
+        for (cp_v_each(j, &fa->point)) {
+            if (cp_v_idx(&a->point, cp_v_nth(&fa->point, j).ref) !=
+                cp_v_idx(&b->point, cp_v_nth(&fb->point, j).ref))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Whether two leaves are identical, i.e., whether in a union, one of
+ * them can be dropped.  Only spheres and polyhedra are compared.
+ */
+static bool opt_leaf_eq(
+    cp_obj_t const *a,
+    cp_obj_t const *b)
+{
+    if (a->type != b->type) {
+        return false;
+    }
+    switch (a->type) {
+    case CP_CSG3_SPHERE:
+        return opt_sphere_eq(
+            cp_csg3_cast(cp_csg3_sphere_t const, a),
+            cp_csg3_cast(cp_csg3_sphere_t const, b));
+
+    case CP_CSG3_POLY:
+        return opt_poly_eq(
+            cp_csg3_cast(cp_csg3_poly_t const, a),
+            cp_csg3_cast(cp_csg3_poly_t const, b));
+    }
+    return false;
+}
+
+/**
+ * Bounding box of the visible part of an object.  Returns false if
+ * the object has no valid 3D bounding box, e.g., for 2D objects.
+ */
+static bool opt_bb(
+    cp_vec3_minmax_t *bb,
+    cp_obj_t const *a)
+{
+    *bb = (cp_vec3_minmax_t)CP_VEC3_MINMAX_EMPTY;
+    get_bb_csg3(bb, cp_csg3_cast(cp_csg3_t const, a), false);
+    return cp_vec3_minmax_valid(bb);
+}
+
+static bool opt_bb_add(
+    cp_vec3_minmax_t *bb,
+    cp_csg_add_t const *a)
+{
+    *bb = (cp_vec3_minmax_t)CP_VEC3_MINMAX_EMPTY;
+    get_bb_add(bb, a, false);
+    return cp_vec3_minmax_valid(bb);
+}
+
+static cp_f_t opt_bb_volume(
+    cp_vec3_minmax_t const *bb)
+{
+    return
+        (bb->max.x - bb->min.x) *
+        (bb->max.y - bb->min.y) *
+        (bb->max.z - bb->min.z);
+}
+
+/**
+ * Move the children of a into o and free a.
+ */
+static void opt_splice(
+    cp_v_obj_p_t *o,
+    cp_csg_add_t *a)
+{
+    cp_v_append(o, &a->add);
+    cp_v_fini(&a->add);
+    CP_FREE(a);
+}
+
+/**
+ * Optimise a union: flatten nested unions and drop duplicate leaves.
+ */
+static void opt_add(
+    cp_csg_add_t *r)
+{
+    cp_v_obj_p_t o = CP_V_INIT;
+    for (cp_v_each(i, &r->add)) {
+        opt_csg3(&o, cp_v_nth(&r->add, i));
+    }
+    cp_v_fini(&r->add);
+
+    /* Drop duplicate leaves.  The first one is kept, so the order of
+     * the remaining objects does not change. */
+    size_t k = 0;
+    for (cp_v_each(i, &o)) {
+        cp_obj_t *a = cp_v_nth(&o, i);
+        bool dup = false;
+        for (cp_size_each(j, k)) {
+            if (opt_leaf_eq(cp_v_nth(&o, j), a)) {
+                dup = true;
+                break;
+            }
+        }
+        if (dup) {
+            csg3_delete(a);
+        }
+        else {
+            cp_v_nth(&o, k++) = a;
+        }
+    }
+    o.size = k;
+
+    r->add = o;
+}
+
+static void opt_sub(
+    cp_v_obj_p_t *o,
+    cp_csg_sub_t *r)
+{
+    opt_add(r->add);
+    if (r->add->add.size == 0) {
+        /* nothing to subtract from */
+        csg3_delete(cp_obj(r));
+        return;
+    }
+
+    /* drop subtrahends that cannot touch the minuend */
+    opt_add(r->sub);
+    cp_vec3_minmax_t bb;
+    if (opt_bb_add(&bb, r->add)) {
+        size_t k = 0;
+        for (cp_v_each(i, &r->sub->add)) {
+            cp_obj_t *a = cp_v_nth(&r->sub->add, i);
+            cp_vec3_minmax_t bb2;
+            if (opt_bb(&bb2, a)) {
+                cp_vec3_minmax_and(&bb2, &bb2, &bb);
+                if (!cp_vec3_minmax_valid(&bb2)) {
+                    csg3_delete(a);
+                    continue;
+                }
+            }
+            cp_v_nth(&r->sub->add, k++) = a;
+        }
+        r->sub->add.size = k;
+    }
+
+    if (r->sub->add.size == 0) {
+        /* nothing left to subtract */
+        opt_splice(o, r->add);
+        add_delete(r->sub);
+        CP_FREE(r);
+        return;
+    }
+
+    cp_v_push(o, cp_obj(r));
+}
+
+static void opt_cut(
+    cp_v_obj_p_t *o,
+    cp_csg_cut_t *r)
+{
+    bool empty = false;
+    for (cp_v_each(i, &r->cut)) {
+        cp_csg_add_t *a = cp_v_nth(&r->cut, i);
+        opt_add(a);
+        empty |= (a->add.size == 0);
+    }
+
+    /* Sort by bounding box volume, smallest first, so that the
+     * intersection shrinks as early as possible.  Insertion sort:
+     * there are usually very few children, and it is stable. */
+    if (!empty && (r->cut.size > 1)) {
+        cp_f_t *vol = CP_NEW_ARR(*vol, r->cut.size);
+        cp_vec3_minmax_t bb = CP_VEC3_MINMAX_FULL;
+        bool valid = true;
+        for (cp_v_each(i, &r->cut)) {
+            cp_csg_add_t *a = cp_v_nth(&r->cut, i);
+            cp_vec3_minmax_t bb2;
+            if (!opt_bb_add(&bb2, a)) {
+                valid = false;
+                break;
+            }
+            cp_vec3_minmax_and(&bb, &bb, &bb2);
+            vol[i] = opt_bb_volume(&bb2);
+            for (size_t j = i; (j > 0) && (vol[j-1] > vol[j]); j--) {
+                CP_SWAP(&vol[j-1], &vol[j]);
+                CP_SWAP(&cp_v_nth(&r->cut, j-1), &cp_v_nth(&r->cut, j));
+            }
+        }
+        CP_FREE(vol);
+        if (valid && !cp_vec3_minmax_valid(&bb)) {
+            /* disjoint boxes: the intersection is empty */
+            empty = true;
+        }
+    }
+
+    if (empty) {
+        csg3_delete(cp_obj(r));
+        return;
+    }
+
+    if (r->cut.size == 1) {
+        opt_splice(o, cp_v_nth(&r->cut, 0));
+        cp_v_fini(&r->cut);
+        CP_FREE(r);
+        return;
+    }
+
+    cp_v_push(o, cp_obj(r));
+}
+
+/**
+ * Optimise a, then push the result to o.  This may push nothing if a
+ * is empty, or multiple objects if a is flattened.
+ */
+static void opt_csg3(
+    cp_v_obj_p_t *o,
+    cp_obj_t *a)
+{
+    switch (a->type) {
+    case CP_CSG_ADD: {
+        cp_csg_add_t *r = cp_csg_cast(*r, a);
+        for (cp_v_each(i, &r->add)) {
+            opt_csg3(o, cp_v_nth(&r->add, i));
+        }
+        cp_v_fini(&r->add);
+        CP_FREE(r);
+        return;
+    }
+
+    case CP_CSG_SUB:
+        opt_sub(o, cp_csg_cast(cp_csg_sub_t, a));
+        return;
+
+    case CP_CSG_CUT:
+        opt_cut(o, cp_csg_cast(cp_csg_cut_t, a));
+        return;
+
+    case CP_CSG_XOR: {
+        cp_csg_xor_t *r = cp_csg_cast(*r, a);
+        for (cp_v_each(i, &r->xor)) {
+            opt_add(cp_v_nth(&r->xor, i));
+        }
+        cp_v_push(o, a);
+        return;
+    }
+
+    case CP_CSG3_SPHERE:
+    case CP_CSG3_POLY:
+    case CP_CSG2_POLY:
+        cp_v_push(o, a);
+        return;
+    }
+    CP_DIE("CSG3 object type %#x", a->type);
+}
+
+/**
+ * Simplify a CSG3 tree before it is sliced, so that each layer has
+ * less to process.  This flattens nested unions, drops subtrahends
+ * whose bounding box does not intersect the minuend, sorts the
+ * operands of intersections by bounding box volume, smallest first,
+ * removes empty operations, and drops identical duplicate leaves in
+ * unions.
+ *
+ * The resulting solid is the same.  Objects that are removed are
+ * freed, so cp_csg3_tree_fini() still works.
+ *
+ * Does nothing unless r->opt->optimise has CP_CSG2_OPT_SIMPLIFY_TREE.
+ */
+extern void cp_csg3_tree_optimise(
+    cp_csg3_tree_t *r)
+{
+    assert(r->opt != NULL);
+    if ((r->root == NULL) || !(r->opt->optimise & CP_CSG2_OPT_SIMPLIFY_TREE)) {
+        return;
+    }
+    opt_add(r->root);
+}
+
 /**
  * Convert a SCAD AST into a CSG3 tree.
  */
@@ -1,30 +1,161 @@
 /* -*- Mode: C -*- */
 /* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
 
+/* for fork(), pipe(), getline(), inotify, accept4() */
+#define _GNU_SOURCE
+
 #include <stdio.h>
+#include <unistd.h>
+#include <poll.h>
+#include <libgen.h>
+#include <stdint.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <hob3lbase/mat.h>
 #include <hob3lbase/pool.h>
 #include <hob3lbase/alloc.h>
+#include <hob3lbase/clock.h>
+#include <hob3lbase/trace.h>
 #include <hob3l/syn.h>
 #include <hob3l/scad.h>
+#include <hob3l/csg.h>
+#include <hob3l/csg-prof.h>
 #include <hob3l/csg3.h>
+#include <hob3l/csg3-cache.h>
 #include <hob3l/csg2.h>
+#include <hob3l/csg2-cache.h>
 #include <hob3l/ps.h>
+#include <hob3l/stl.h>
 #include "internal.h"
+#include "probe.h"
 
 #ifndef CP_PROG_NAME
 #define CP_PROG_NAME "hob3l"
 #endif
 
+/** Output formats selected by file name suffix */
+typedef enum {
+    OUT_NONE,
+    OUT_CSG2,
+    OUT_STL,
+    OUT_JS,
+    OUT_PS,
+    OUT_CACHE,
+} cp_out_format_t;
+
+typedef struct {
+    /** NULL for stdout */
+    char const *file_name;
+    cp_out_format_t format;
+    FILE *file;
+    cp_stream_t stream;
+    /** JS writer context while writing layer by layer */
+    cp_csg2_js_t *js;
+} cp_out_t;
+
+typedef CP_VEC_T(cp_out_t) cp_v_out_t;
+
+/**
+ * Stages timed by --stats.  The values are also passed to the
+ * stage_begin/stage_end probes, so keep the order (see README).
+ */
+typedef enum {
+    STAGE_PARSE,
+    STAGE_SCAD,
+    STAGE_CSG3,
+    STAGE_SLICE,
+    STAGE_BOOL,
+    STAGE_TRI,
+    STAGE_DIFF,
+    STAGE_CACHE,
+    STAGE_OUTPUT,
+    STAGE_CNT
+} stage_t;
+
+static char const *stage_name[STAGE_CNT] = {
+    [STAGE_PARSE]  = "parse",
+    [STAGE_SCAD]   = "scad",
+    [STAGE_CSG3]   = "csg3",
+    [STAGE_SLICE]  = "slice",
+    [STAGE_BOOL]   = "bool",
+    [STAGE_TRI]    = "tri",
+    [STAGE_DIFF]   = "diff",
+    [STAGE_CACHE]  = "cache",
+    [STAGE_OUTPUT] = "output",
+};
+
+/** Values of --stats */
+#define STATS_NONE 0
+#define STATS_TEXT 1
+#define STATS_JSON 2
+
+/** Wall clock and CPU time [s] */
+typedef struct {
+    double wall;
+    double cpu;
+} stat_time_t;
+
+/** Work counters of cp_csg_stat_t with their names */
+static struct {
+    char const *name;
+    size_t offset;
+} const csg_stat_field[] = {
+    { "polygons",      offsetof(cp_csg_stat_t, poly_cnt) },
+    { "edges",         offsetof(cp_csg_stat_t, edge_cnt) },
+    { "events",        offsetof(cp_csg_stat_t, event_cnt) },
+    { "intersections", offsetof(cp_csg_stat_t, intersection_cnt) },
+    { "divides",       offsetof(cp_csg_stat_t, divide_cnt) },
+    { "requeues",      offsetof(cp_csg_stat_t, requeue_cnt) },
+    { "reduces",       offsetof(cp_csg_stat_t, reduce_cnt) },
+    { "tri_nodes",     offsetof(cp_csg_stat_t, tri_node_cnt) },
+    { "triangles",     offsetof(cp_csg_stat_t, triangle_cnt) },
+};
+
+/** Counter i of csg_stat_field[] in s */
+#define CSG_STAT(s, i) (*(size_t*)(size_t)((char const *)(s) + csg_stat_field[i].offset))
+
+/** Cost of a layer for --layer-stats */
+typedef struct {
+    /** wall clock time [s] of slicing, boolean operations, and triangulation */
+    double time_csg;
+    /** wall clock time [s] of the diff with the next layer */
+    double time_diff;
+    /** work done for the layer */
+    cp_csg_stat_t csg;
+} layer_stat_t;
+
+typedef CP_VEC_T(layer_stat_t) v_layer_stat_t;
+
+/** Statistics of one input file for --stats */
+typedef struct {
+    stat_time_t time[STAGE_CNT];
+    size_t layer_cnt;
+    size_t pool_used_max;
+    size_t pool_elem_max;
+    size_t pool_block_total;
+    cp_csg_stat_t csg;
+} stats_t;
+
 typedef struct {
     cp_dim_t z_min;
     cp_dim_t z_max;
     cp_dim_t z_step;
     bool have_z_min;
     bool have_z_max;
+    /** z coordinates from --z-list, sorted, or empty to use a range */
+    cp_v_double_t z_list;
+    /** rectangle from --xy-window, used via csg.xy_window */
+    cp_vec2_minmax_t xy_window;
     bool dump_syn;
     bool dump_scad;
     bool dump_csg3;
+    bool dump_csg3_opt;
     bool dump_csg2;
     bool dump_ps;
     bool dump_stl;
@@ -33,488 +164,2592 @@ typedef struct {
     bool no_tri;
     bool no_csg;
     bool no_diff;
+    bool stream;
     unsigned verbose;
     unsigned ps_scale_step; /* 0 = no change, 1 = normal bb, 2 = max bb */
     cp_ps_opt_t ps;
     cp_scale_t ps_persp;
-    char const *out_file_name;
+    cp_v_out_t out;
+    char const *cache_dir;
+    bool watch;
+    char const *serve;
+    size_t jobs;
+    /** layer cache, NULL if not used */
+    cp_csg2_cache_t *cache;
+    /** --progress: used via csg.progress */
+    cp_progress_t progress;
+    /** --stats: one of STATS_* */
+    unsigned stats;
+    /** statistics of the current input file, counters used via csg.stat */
+    stats_t stat;
+    /** --layer-stats: output file name pattern, or NULL */
+    char const *layer_stats;
+    /** --layer-stats-top: number of layers in the summary */
+    size_t layer_stats_top;
+    /** cost of each layer of the current input file for --layer-stats */
+    v_layer_stat_t layer_stat;
+    /** --profile-source-top: number of statements in the report */
+    size_t profile_source_top;
+    /** work by source location for --profile-source, used via csg.prof */
+    cp_csg_prof_t prof;
+    /** --trace: file name pattern, or NULL */
+    char const *trace_name;
+    /** trace file of the current input file, used via csg.trace */
+    cp_trace_t trace;
     cp_csg_opt_t csg;
 } cp_opt_t;
 
-static bool next_i(
-    size_t *ip,
-    size_t *i_alloc,
-    size_t i_count)
+/** The progress structure cancelled by SIGINT and SIGTERM */
+static cp_progress_t *sig_progress = NULL;
+
+/* only lock-free atomics may be used in a signal handler */
+cp_static_assert(ATOMIC_BOOL_LOCK_FREE == 2);
+
+static void sig_cancel(int sig __unused)
 {
-    size_t i = (*i_alloc)++;
-    if (i < i_count) {
-        *ip = i;
-        return true;
-    }
-    return false;
+    atomic_store_explicit(&sig_progress->cancel, true, memory_order_relaxed);
 }
 
+static char const *progress_stage_name[] = {
+    [CP_PROGRESS_READ]  = "read",
+    [CP_PROGRESS_SLICE] = "slice",
+    [CP_PROGRESS_DIFF]  = "diff",
+    [CP_PROGRESS_WRITE] = "write",
+    [CP_PROGRESS_DONE]  = "done",
+};
+
 /**
- * Process for each layer the CSG and then its triangulation
- *
- * This can theoretically be run in multiple threads: each thread
- * needs its own pool, and next_i needs to be made atomic.
+ * Progress callback of --progress: one line per call on stderr.
  */
-static bool process_stack_csg(
-    cp_opt_t *opt,
-    cp_pool_t *pool,
-    cp_err_t *err,
-    cp_csg2_tree_t *csg2,
-    cp_csg2_tree_t *csg2b,
-    cp_csg2_tree_t *csg2_out,
-    size_t *zi_p,
-    size_t  zi_count)
+static void progress_print(
+    void *user,
+    cp_progress_stage_t stage,
+    size_t zi,
+    size_t zi_cnt,
+    size_t written)
 {
-    size_t i;
-    while (next_i(&i, zi_p, zi_count)) {
-        cp_pool_clear(pool);
-        if (!cp_csg2_tree_add_layer(pool, csg2, err, i)) {
-            return false;
-        }
-        if (!opt->no_csg) {
-            cp_csg2_op_add_layer(&opt->csg, pool, csg2b, csg2, i);
-        }
-        if (!opt->no_tri) {
-            if (!cp_csg2_tri_layer(pool, err, csg2_out, i)) {
-                return false;
+    char const *fn = user;
+    fprintf(stderr, "Progress: %s: %s %"_Pz"u/%"_Pz"u, %"_Pz"u bytes written\n",
+        fn, progress_stage_name[stage], zi, zi_cnt, written);
+}
+
+/**
+ * Number of bytes written to the output files so far, as far as known.
+ */
+static size_t out_written(
+    cp_opt_t *opt)
+{
+    size_t n = 0;
+    for (cp_v_each(i, &opt->out)) {
+        cp_out_t *o = &cp_v_nth(&opt->out, i);
+        if (o->file != NULL) {
+            long k = ftell(o->file);
+            if (k > 0) {
+                n += (size_t)k;
             }
         }
     }
-    return true;
+    return n;
 }
 
 /**
- * Second run through the layer stack: XOR between two layers plus its triangulation
- *
- * This can theoretically be run in multiple threads: each thread
- * needs its own pool, and next_i needs to be made atomic.
+ * Report progress, if enabled, and check whether processing was
+ * cancelled.  zi layers of zi_cnt are done.
  */
-static bool process_stack_diff(
+static bool progress(
     cp_opt_t *opt,
-    cp_pool_t *pool,
     cp_err_t *err,
-    cp_csg2_tree_t *csg2_out,
-    size_t *zi_p,
-    size_t  zi_count)
+    cp_progress_stage_t stage,
+    size_t zi,
+    size_t zi_cnt)
 {
-    size_t i;
-    while (next_i(&i, zi_p, zi_count)) {
-        cp_pool_clear(pool);
-        cp_csg2_op_diff_layer(&opt->csg, pool, csg2_out, i);
-        if (!opt->no_tri) {
-            if (!cp_csg2_tri_layer_diff(pool, err, csg2_out, i)) {
-                return false;
-            }
-        }
+    cp_progress_t *p = opt->csg.progress;
+    if (p == NULL) {
+        return true;
+    }
+    if (p->func != NULL) {
+        p->func(p->user, stage, zi, zi_cnt, out_written(opt));
+    }
+    if (cp_csg_cancelled(&opt->csg)) {
+        cp_vchar_printf(&err->msg, "Cancelled.\n");
+        return false;
     }
     return true;
 }
 
-static bool do_file(
-    cp_stream_t *sout,
-    cp_opt_t *opt,
-    cp_syn_tree_t *r,
-    const char *fn,
-    FILE *f)
+static void stat_now(
+    stat_time_t *t)
 {
-    /* stage 1: syntax tree */
-    if (!cp_syn_parse(r, fn, f)) {
-        return false;
-    }
-    if (opt->dump_syn) {
-        cp_syn_tree_put_scad(sout, r);
-        return true;
+    t->wall = cp_clock_wall();
+    t->cpu = cp_clock_cpu();
+}
+
+/**
+ * Start timing a stage for --stats and --trace.
+ */
+static void stat_begin(
+    cp_opt_t const *opt,
+    stage_t stage __unused,
+    stat_time_t *t0)
+{
+    CP_PROBE1(stage_begin, stage);
+    if ((opt->stats != STATS_NONE) || (opt->csg.trace != NULL)) {
+        stat_now(t0);
     }
+}
 
-    /* stage 2: SCAD */
-    cp_scad_tree_t *scad = CP_NEW(*scad);
-    if (!cp_scad_from_syn_tree(scad, r)) {
-        return false;
+/**
+ * Add the time since stat_begin() to a stage, and write its span
+ * to the trace.
+ */
+static void stat_end(
+    cp_opt_t *opt,
+    stage_t stage,
+    stat_time_t const *t0)
+{
+    CP_PROBE1(stage_end, stage);
+    cp_alloc_stage(stage, stage_name[stage]);
+    if (stage == STAGE_OUTPUT) {
+        cp_trace_span_args(opt->csg.trace, stage_name[stage], t0->wall,
+            "\"written\":%"_Pz"u", out_written(opt));
     }
-    if (opt->dump_scad) {
-        cp_scad_tree_put_scad(sout, scad);
-        return true;
+    else {
+        cp_trace_span(opt->csg.trace, stage_name[stage], t0->wall);
     }
-
-    /* pool for tmp objects */
-    cp_pool_t pool;
-    cp_pool_init(&pool, 0);
-
-    /* stage 3: 3D CSG */
-    cp_csg3_tree_t *csg3 = CP_NEW(*csg3);
-    csg3->opt = &opt->csg;
-    if (!cp_csg3_from_scad_tree(&pool, r, csg3, &r->err, scad)) {
-        return false;
+    if (opt->stats == STATS_NONE) {
+        return;
     }
+    stat_time_t t;
+    stat_now(&t);
+    opt->stat.time[stage].wall += t.wall - t0->wall;
+    opt->stat.time[stage].cpu  += t.cpu  - t0->cpu;
+}
 
-    cp_vec3_minmax_t full_bb = CP_VEC3_MINMAX_EMPTY;
-    if (csg3->root != NULL) {
-        cp_csg3_tree_bb(&full_bb, csg3, true);
-#ifdef PSTRACE
-        cp_ps_xform_from_bb(&cp_debug_ps_xform,
-            full_bb.min.x, full_bb.min.y,
-            full_bb.max.x, full_bb.max.y);
-        cp_debug_ps_xform.add_x -= CP_PS_PAPER_X/2;
-        cp_debug_ps_xform.add_y -= CP_PS_PAPER_Y/2;
-        cp_debug_ps_xform.add_x *= cp_debug_ps_scale_x;
-        cp_debug_ps_xform.add_y *= cp_debug_ps_scale_y;
-        cp_debug_ps_xform.mul_x *= cp_debug_ps_scale_x;
-        cp_debug_ps_xform.mul_y *= cp_debug_ps_scale_y;
-        cp_debug_ps_xform.add_x += CP_PS_PAPER_X/2;
-        cp_debug_ps_xform.add_y += CP_PS_PAPER_Y/2;
-        cp_debug_ps_xform.add_x += (cp_debug_ps_xlat_x * cp_debug_ps_xform.mul_x);
-        cp_debug_ps_xform.add_y += (cp_debug_ps_xlat_y * cp_debug_ps_xform.mul_y);
-#endif
+static void json_str(
+    FILE *f,
+    char const *s)
+{
+    fputc('"', f);
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char)*s;
+        if ((c == '"') || (c == '\\')) {
+            fprintf(f, "\\%c", c);
+        }
+        else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        }
+        else {
+            fputc(c, f);
+        }
     }
+    fputc('"', f);
+}
 
-    if (opt->dump_csg3) {
-        cp_csg3_tree_put_scad(sout, csg3);
-        return true;
+/**
+ * Print the statistics of --stats to stderr.
+ */
+static void stats_print(
+    cp_opt_t *opt,
+    char const *fn)
+{
+    stats_t const *st = &opt->stat;
+    struct rusage ru;
+    CP_ZERO(&ru);
+    (void)getrusage(RUSAGE_SELF, &ru);
+    stat_time_t total = {0};
+    for (cp_arr_each(i, st->time)) {
+        total.wall += st->time[i].wall;
+        total.cpu  += st->time[i].cpu;
     }
 
-    /* Get bounding box (normal one, i.e., ignoring stuff that is subtracted) */
-    cp_vec3_minmax_t bb = CP_VEC3_MINMAX_EMPTY;
-    cp_csg3_tree_bb(&bb, csg3, false);
+    if (opt->stats == STATS_JSON) {
+        fprintf(stderr, "{\"file\":");
+        json_str(stderr, fn);
+        fprintf(stderr, ",\"time\":{");
+        for (cp_arr_each(i, st->time)) {
+            fprintf(stderr, "\"%s\":{\"wall\":%.6f,\"cpu\":%.6f},",
+                stage_name[i], st->time[i].wall, st->time[i].cpu);
+        }
+        fprintf(stderr, "\"total\":{\"wall\":%.6f,\"cpu\":%.6f}}", total.wall, total.cpu);
+        fprintf(stderr, ",\"peak_rss_kb\":%ld", ru.ru_maxrss);
+        fprintf(stderr,
+            ",\"pool\":{\"used_max\":%"_Pz"u,\"elem_max\":%"_Pz"u,\"block_total\":%"_Pz"u}",
+            st->pool_used_max, st->pool_elem_max, st->pool_block_total);
+        fprintf(stderr, ",\"count\":{\"layers\":%"_Pz"u", st->layer_cnt);
+        for (cp_arr_each(i, csg_stat_field)) {
+            fprintf(stderr, ",\"%s\":%"_Pz"u", csg_stat_field[i].name, CSG_STAT(&st->csg, i));
+        }
+        fprintf(stderr, "}}\n");
+        return;
+    }
 
-    /* stage 4: 2D CSG */
-    cp_dim_t z_min = bb.min.z + opt->z_step/2;
-    cp_dim_t z_max = bb.max.z;
-    if (opt->have_z_min) {
-        z_min = opt->z_min;
+    fprintf(stderr, "Stats: %s\n", fn);
+    fprintf(stderr, "Stats:   %-8s %10s %10s\n", "stage", "wall [s]", "cpu [s]");
+    for (cp_arr_each(i, st->time)) {
+        fprintf(stderr, "Stats:   %-8s %10.4f %10.4f\n",
+            stage_name[i], st->time[i].wall, st->time[i].cpu);
     }
-    if (opt->have_z_max) {
-        z_max = opt->z_max;
+    fprintf(stderr, "Stats:   %-8s %10.4f %10.4f\n", "total", total.wall, total.cpu);
+    fprintf(stderr, "Stats:   peak RSS: %ld kB\n", ru.ru_maxrss);
+    fprintf(stderr, "Stats:   pool: %"_Pz"u bytes used max (%"_Pz"u elements), "
+        "%"_Pz"u bytes in blocks\n",
+        st->pool_used_max, st->pool_elem_max, st->pool_block_total);
+    fprintf(stderr, "Stats:   layers %"_Pz"u", st->layer_cnt);
+    for (cp_arr_each(i, csg_stat_field)) {
+        fprintf(stderr, ", %s %"_Pz"u", csg_stat_field[i].name, CSG_STAT(&st->csg, i));
     }
+    fprintf(stderr, "\n");
+}
 
-    cp_range_t range;
-    cp_range_init(&range, z_min, z_max, opt->z_step);
-    if (range.cnt == 0) {
-        range.cnt = 1;
+/**
+ * Start recording the cost of a layer for --layer-stats.
+ */
+static void layer_stat_begin(
+    cp_opt_t const *opt,
+    stat_time_t *t0,
+    cp_csg_stat_t *c0)
+{
+    if (opt->layer_stats != NULL) {
+        stat_now(t0);
+        *c0 = opt->stat.csg;
     }
+}
 
-    if (opt->verbose >= 1) {
-        fprintf(stderr, "Info: Z: min=%g, step=%g, layer_cnt=%"_Pz"u, max=%g\n",
-            range.min, range.step, range.cnt,
-            range.min + (range.step * cp_f(range.cnt - 1)));
+/**
+ * Add the cost since layer_stat_begin() to layer zi.
+ */
+static void layer_stat_end(
+    cp_opt_t *opt,
+    size_t zi,
+    bool diff,
+    stat_time_t const *t0,
+    cp_csg_stat_t const *c0)
+{
+    if (opt->layer_stats == NULL) {
+        return;
+    }
+    stat_time_t t;
+    stat_now(&t);
+    layer_stat_t *l = &cp_v_nth(&opt->layer_stat, zi);
+    if (diff) {
+        l->time_diff += t.wall - t0->wall;
     }
+    else {
+        l->time_csg += t.wall - t0->wall;
+    }
+    for (cp_arr_each(i, csg_stat_field)) {
+        CSG_STAT(&l->csg, i) += CSG_STAT(&opt->stat.csg, i) - CSG_STAT(c0, i);
+    }
+}
 
-    /* process layer by layer: extract layer, slice, triangulate */
-    cp_csg2_tree_t *csg2 = CP_NEW(*csg2);
-    cp_csg2_tree_from_csg3(csg2, csg3, &range, &opt->csg);
+static int cmp_layer_stat(
+    size_t const *a,
+    size_t const *b,
+    v_layer_stat_t const *v)
+{
+    layer_stat_t const *la = &cp_v_nth(v, *a);
+    layer_stat_t const *lb = &cp_v_nth(v, *b);
+    double ta = la->time_csg + la->time_diff;
+    double tb = lb->time_csg + lb->time_diff;
+    return (ta < tb) ? +1 : (ta > tb) ? -1 : (*a > *b) - (*a < *b);
+}
 
-    cp_csg2_tree_t *csg2b = CP_NEW(*csg2b);
-    cp_csg2_op_tree_init(csg2b, csg2);
+static void out_name_expand(
+    cp_vchar_t *fn,
+    char const *pattern,
+    char const *in_file_name);
 
-    cp_csg2_tree_t *csg2_out = opt->no_csg ? csg2 : csg2b;
-    size_t zi = 0;
-    if (!process_stack_csg(opt, &pool, &r->err, csg2, csg2b, csg2_out, &zi, range.cnt)) {
-        return false;
+/**
+ * Write the cost of each layer for --layer-stats, and print the most
+ * expensive layers to stderr.
+ */
+static void layer_stats_write(
+    cp_opt_t *opt,
+    cp_csg2_tree_t const *t,
+    char const *in_file_name)
+{
+    v_layer_stat_t const *v = &opt->layer_stat;
+    cp_vchar_t fn;
+    cp_vchar_init(&fn);
+    out_name_expand(&fn, opt->layer_stats, in_file_name);
+    bool json = has_suffix(fn.data, ".json");
+    FILE *f = fopen(fn.data, "wt");
+    if (f == NULL) {
+        fprintf(stderr, "Error: Unable to open '%s' for writing: %s\n",
+            fn.data, strerror(errno));
+        cp_vchar_fini(&fn);
+        return;
     }
 
-    /* compute diff if there is any output format that can use it */
-    if (opt->dump_js) {
-        if (!opt->no_diff) {
-            zi = 0;
-            if (!process_stack_diff(opt, &pool, &r->err, csg2_out, &zi, range.cnt)) {
-                return false;
-            }
+    if (json) {
+        fprintf(f, "[\n");
+    }
+    else {
+        fprintf(f, "zi,z,time_csg,time_diff");
+        for (cp_arr_each(i, csg_stat_field)) {
+            fprintf(f, ",%s", csg_stat_field[i].name);
         }
+        fprintf(f, "\n");
     }
-
-    /* print */
-    if (opt->dump_csg2) {
-        cp_csg2_tree_put_scad(sout, csg2_out);
-        return true;
+    double total = 0;
+    for (cp_v_each(zi, v)) {
+        layer_stat_t const *l = &cp_v_nth(v, zi);
+        total += l->time_csg + l->time_diff;
+        double z = cp_v_nth(&t->z, zi);
+        if (json) {
+            fprintf(f, "  {\"zi\":%"_Pz"u,\"z\":%g,\"time_csg\":%.6f,\"time_diff\":%.6f",
+                zi, z, l->time_csg, l->time_diff);
+            for (cp_arr_each(i, csg_stat_field)) {
+                fprintf(f, ",\"%s\":%"_Pz"u", csg_stat_field[i].name, CSG_STAT(&l->csg, i));
+            }
+            fprintf(f, "}%s\n", (zi + 1 < v->size) ? "," : "");
+        }
+        else {
+            fprintf(f, "%"_Pz"u,%g,%.6f,%.6f", zi, z, l->time_csg, l->time_diff);
+            for (cp_arr_each(i, csg_stat_field)) {
+                fprintf(f, ",%"_Pz"u", CSG_STAT(&l->csg, i));
+            }
+            fprintf(f, "\n");
+        }
     }
-    if (opt->dump_stl) {
-        cp_csg2_tree_put_stl(sout, csg2_out);
-        return true;
+    if (json) {
+        fprintf(f, "]\n");
     }
-    if (opt->dump_js) {
-        cp_csg2_tree_put_js(sout, csg2_out);
-        return true;
+    if (fclose(f) != 0) {
+        fprintf(stderr, "Error: Unable to write '%s': %s\n", fn.data, strerror(errno));
     }
-    if (opt->dump_ps) {
-        cp_ps_xform_t xform = CP_PS_XFORM_MM;
-        switch (opt->ps_scale_step) {
-        default:
-            break;
-
-        case 1:
-            cp_ps_xform_from_bb(&xform,
-                bb.min.x, bb.min.y,
-                bb.max.x, bb.max.y);
-            break;
+    cp_vchar_fini(&fn);
 
-        case 2:
-            cp_ps_xform_from_bb(&xform,
-                full_bb.min.x, full_bb.min.y,
-                full_bb.max.x, full_bb.max.y);
-            break;
+    /* summary: the most expensive layers */
+    cp_v_size_t idx = {0};
+    for (cp_v_each(zi, v)) {
+        cp_v_push(&idx, zi);
+    }
+    cp_v_qsort(&idx, 0, CP_SIZE_MAX, cmp_layer_stat, v);
+    size_t n = cp_min(opt->layer_stats_top, idx.size);
+    fprintf(stderr, "Layers: %s: most expensive %"_Pz"u of %"_Pz"u layers:\n",
+        in_file_name, n, idx.size);
+    for (cp_size_each(k, n)) {
+        size_t zi = cp_v_nth(&idx, k);
+        layer_stat_t const *l = &cp_v_nth(v, zi);
+        double tl = l->time_csg + l->time_diff;
+        fprintf(stderr, "Layers:   z=%-8g %9.3f ms %5.1f%%",
+            cp_v_nth(&t->z, zi), tl * 1000, (total > 0) ? (100 * tl / total) : 0.0);
+        for (cp_arr_each(i, csg_stat_field)) {
+            fprintf(stderr, ", %s %"_Pz"u", csg_stat_field[i].name, CSG_STAT(&l->csg, i));
         }
-        opt->ps.xform1 = &xform;
-        cp_csg2_tree_put_ps(sout, &opt->ps, csg2_out);
-        return true;
+        fprintf(stderr, "\n");
     }
+    cp_v_fini(&idx);
+}
 
-    return true;
+/**
+ * Work of a source statement for --profile-source.
+ */
+typedef struct {
+    cp_syn_file_t *file;
+    size_t line;
+    /** identifier at the location, not NUL terminated */
+    char const *name;
+    size_t name_len;
+    size_t edge_cnt;
+    size_t event_cnt;
+    double time_sweep;
+    double time_slice;
+} prof_stmt_t;
+
+typedef CP_VEC_T(prof_stmt_t) v_prof_stmt_t;
+
+static bool is_id_char(char c)
+{
+    return
+        ((c >= 'a') && (c <= 'z')) ||
+        ((c >= 'A') && (c <= 'Z')) ||
+        ((c >= '0') && (c <= '9')) ||
+        (c == '_') || (c == '$');
 }
 
-__attribute__((noreturn))
-static void my_exit(int i)
+static int cmp_prof_stmt_loc(
+    prof_stmt_t const *a,
+    prof_stmt_t const *b,
+    void *user __unused)
 {
-#ifdef PSTRACE
-    if (cp_debug_ps != NULL) {
-        cp_ps_doc_end(cp_debug_ps, cp_debug_ps_page_cnt, 0, 0, -1, -1);
-        CP_FREE(cp_debug_ps);
+    uintptr_t fa = (uintptr_t)a->file;
+    uintptr_t fb = (uintptr_t)b->file;
+    if (fa != fb) {
+        return (fa > fb) - (fa < fb);
     }
-    if (cp_debug_ps_file != NULL) {
-        fclose(cp_debug_ps_file);
-        cp_debug_ps_file = NULL;
+    if (a->line != b->line) {
+        return (a->line > b->line) - (a->line < b->line);
     }
-#endif
-    exit(i);
+    if (a->name_len != b->name_len) {
+        return (a->name_len > b->name_len) - (a->name_len < b->name_len);
+    }
+    return (a->name_len == 0) ? 0 : strncmp(a->name, b->name, a->name_len);
 }
 
-static char const *cp_prog_name(void)
+static int cmp_prof_stmt_cost(
+    prof_stmt_t const *a,
+    prof_stmt_t const *b,
+    void *user __unused)
 {
-    return CP_PROG_NAME;
+    if (a->event_cnt != b->event_cnt) {
+        return (a->event_cnt < b->event_cnt) ? +1 : -1;
+    }
+    double ta = a->time_sweep + a->time_slice;
+    double tb = b->time_sweep + b->time_slice;
+    return (ta < tb) - (ta > tb);
 }
 
-static char const *opt_help;
-
-__attribute__((noreturn))
-static void help(void)
+/**
+ * Print the work attributed to the source statements for
+ * --profile-source, ranked by the number of sweep events.
+ *
+ * Locations are grouped by file, line, and the identifier they point
+ * to, i.e., usually the name of the module that was called.
+ */
+static void profile_source_print(
+    cp_opt_t *opt,
+    cp_syn_tree_t *r,
+    char const *in_file_name)
 {
-#define PRI printf
-    PRI("Usage: %s [Options] INFILE\n", cp_prog_name());
-    PRI("\n");
-    PRI("This reads 3D CSG models from (simple syntax) SCAD files, slices\n"
-        "them into layers of 2D CSG models, applies 2D CSG boolean operations\n"
-        "to the resulting polygon stack (instead of the 3D polyhedra), and outputs the\n"
-        "result as STL file consisting of a (trivially extruded) polygon per slice.\n");
-    PRI("\n");
-    PRI("Options:\n");
-    PRI("%s", opt_help);
-#undef PRI
-    my_exit(0);
+    v_prof_stmt_t v = {0};
+    for (cp_dict_each(n, opt->prof.loc)) {
+        cp_csg_prof_loc_t const *e = CP_BOX_OF(n, cp_csg_prof_loc_t, node);
+        prof_stmt_t *s = cp_v_push0(&v);
+        s->edge_cnt = e->edge_cnt;
+        s->event_cnt = e->event_cnt;
+        s->time_sweep = e->time_sweep;
+        s->time_slice = e->time_slice;
+        cp_syn_loc_t loc;
+        if ((e->loc != NULL) && cp_syn_get_loc(&loc, r, e->loc)) {
+            s->file = loc.file;
+            s->line = loc.line;
+            s->name = e->loc;
+            if ((*s->name < '0') || (*s->name > '9')) {
+                while (is_id_char(s->name[s->name_len])) {
+                    s->name_len++;
+                }
+            }
+        }
+    }
+
+    /* merge locations of the same statement */
+    cp_v_qsort(&v, 0, CP_SIZE_MAX, cmp_prof_stmt_loc, NULL);
+    size_t k = 0;
+    prof_stmt_t total = {0};
+    for (cp_v_each(i, &v)) {
+        prof_stmt_t const *s = &cp_v_nth(&v, i);
+        total.edge_cnt += s->edge_cnt;
+        total.event_cnt += s->event_cnt;
+        total.time_sweep += s->time_sweep;
+        total.time_slice += s->time_slice;
+        if ((k > 0) && (cmp_prof_stmt_loc(&cp_v_nth(&v, k-1), s, NULL) == 0)) {
+            prof_stmt_t *d = &cp_v_nth(&v, k-1);
+            d->edge_cnt += s->edge_cnt;
+            d->event_cnt += s->event_cnt;
+            d->time_sweep += s->time_sweep;
+            d->time_slice += s->time_slice;
+        }
+        else {
+            cp_v_nth(&v, k++) = *s;
+        }
+    }
+    cp_v_set_size(&v, k);
+    cp_v_qsort(&v, 0, CP_SIZE_MAX, cmp_prof_stmt_cost, NULL);
+
+    size_t n = cp_min(opt->profile_source_top, v.size);
+    fprintf(stderr,
+        "Profile: %s: %"_Pz"u sweep events, %"_Pz"u edges, %.3f ms sweep, "
+        "%.3f ms slicing; top %"_Pz"u of %"_Pz"u statements:\n",
+        in_file_name, total.event_cnt, total.edge_cnt,
+        total.time_sweep * 1000, total.time_slice * 1000, n, v.size);
+    for (cp_size_each(i, n)) {
+        prof_stmt_t const *s = &cp_v_nth(&v, i);
+        if (s->file == NULL) {
+            fprintf(stderr, "Profile:   <unknown>:");
+        }
+        else {
+            fprintf(stderr, "Profile:   %s:%"_Pz"u:", s->file->filename.data, s->line + 1);
+            if (s->name_len > 0) {
+                fprintf(stderr, " %.*s():", (int)s->name_len, s->name);
+            }
+        }
+        fprintf(stderr,
+            " %.1f%% of sweep events, %.1f%% of edges, %.3f ms sweep, %.3f ms slicing\n",
+            (total.event_cnt > 0) ? (100 * (double)s->event_cnt / (double)total.event_cnt) : 0.0,
+            (total.edge_cnt > 0) ? (100 * (double)s->edge_cnt / (double)total.edge_cnt) : 0.0,
+            s->time_sweep * 1000, s->time_slice * 1000);
+    }
+    cp_v_fini(&v);
 }
 
-static void get_arg_bool(
-    bool *v,
-    char const *arg,
-    char const *str)
+static bool next_i(
+    size_t *ip,
+    size_t *i_alloc,
+    size_t i_count)
 {
-    if ((str == NULL) ||
-        strequ(str, "true") ||
-        strequ(str, "1") ||
-        strequ(str, "yes"))
-    {
-        *v = true;
-        return;
+    size_t i = (*i_alloc)++;
+    if (i < i_count) {
+        *ip = i;
+        return true;
     }
-    if (strequ(str, "false") ||
-        strequ(str, "0") ||
-        strequ(str, "no"))
-    {
-        *v = false;
+    return false;
+}
+
+static bool layer_csg(
+    cp_opt_t *opt,
+    cp_pool_t *pool,
+    cp_err_t *err,
+    cp_csg2_cache_t *cache,
+    cp_csg2_tree_t *csg2,
+    cp_csg2_tree_t *csg2b,
+    cp_csg2_tree_t *csg2_out,
+    size_t i)
+{
+    cp_pool_clear(pool);
+    opt->stat.layer_cnt++;
+    stat_time_t t0;
+    if (cache != NULL) {
+        stat_begin(opt, STAGE_CACHE, &t0);
+        bool hit = cp_csg2_cache_get(cache, csg2_out, i);
+        stat_end(opt, STAGE_CACHE, &t0);
+        if (hit) {
+            return true;
+        }
+    }
+    stat_begin(opt, STAGE_SLICE, &t0);
+    if (!cp_csg2_tree_add_layer(pool, csg2, err, i)) {
+        return false;
+    }
+    stat_end(opt, STAGE_SLICE, &t0);
+    if (!opt->no_csg) {
+        stat_begin(opt, STAGE_BOOL, &t0);
+        cp_csg2_op_add_layer(&opt->csg, pool, csg2b, csg2, i);
+        stat_end(opt, STAGE_BOOL, &t0);
+        /* a cancelled boolean operation leaves an empty layer */
+        if (cp_csg_cancelled(&opt->csg)) {
+            cp_vchar_printf(&err->msg, "Cancelled.\n");
+            return false;
+        }
+    }
+    if (!opt->no_tri) {
+        stat_begin(opt, STAGE_TRI, &t0);
+        if (!cp_csg2_tri_layer(pool, err, csg2_out, i)) {
+            return false;
+        }
+        stat_end(opt, STAGE_TRI, &t0);
+    }
+    if (cache != NULL) {
+        stat_begin(opt, STAGE_CACHE, &t0);
+        bool ok = cp_csg2_cache_put(cache, err, csg2_out, i);
+        stat_end(opt, STAGE_CACHE, &t0);
+        return ok;
+    }
+    return true;
+}
+
+static bool layer_diff(
+    cp_opt_t *opt,
+    cp_pool_t *pool,
+    cp_err_t *err,
+    cp_csg2_tree_t *csg2_out,
+    size_t i)
+{
+    cp_pool_clear(pool);
+    stat_time_t t0;
+    stat_begin(opt, STAGE_DIFF, &t0);
+    cp_csg2_op_diff_layer(&opt->csg, pool, csg2_out, i);
+    if (!opt->no_tri) {
+        if (!cp_csg2_tri_layer_diff(pool, err, csg2_out, i)) {
+            return false;
+        }
+    }
+    stat_end(opt, STAGE_DIFF, &t0);
+    return true;
+}
+
+/**
+ * Process the CSG of a single layer and then its triangulation
+ *
+ * If cache is non-NULL, the layer is taken from the cache if possible,
+ * and is stored there otherwise.
+ *
+ * With --layer-stats, this records the cost of the layer.
+ */
+static bool process_layer_csg(
+    cp_opt_t *opt,
+    cp_pool_t *pool,
+    cp_err_t *err,
+    cp_csg2_cache_t *cache,
+    cp_csg2_tree_t *csg2,
+    cp_csg2_tree_t *csg2b,
+    cp_csg2_tree_t *csg2_out,
+    size_t i)
+{
+    stat_time_t t0;
+    cp_csg_stat_t c0;
+    CP_PROBE1(layer_csg_begin, i);
+    double t_trace = cp_trace_now(opt->csg.trace);
+    layer_stat_begin(opt, &t0, &c0);
+    bool ok = layer_csg(opt, pool, err, cache, csg2, csg2b, csg2_out, i);
+    layer_stat_end(opt, i, false, &t0, &c0);
+    cp_trace_span_args(opt->csg.trace, "layer", t_trace,
+        "\"zi\":%"_Pz"u,\"z\":%g", i, cp_v_nth(&csg2_out->z, i));
+    CP_PROBE2(layer_csg_end, i, ok);
+    return ok;
+}
+
+/**
+ * XOR between a layer and the next one plus its triangulation
+ *
+ * With --layer-stats, this records the cost of the layer.
+ */
+static bool process_layer_diff(
+    cp_opt_t *opt,
+    cp_pool_t *pool,
+    cp_err_t *err,
+    cp_csg2_tree_t *csg2_out,
+    size_t i)
+{
+    stat_time_t t0;
+    cp_csg_stat_t c0;
+    CP_PROBE1(layer_diff_begin, i);
+    double t_trace = cp_trace_now(opt->csg.trace);
+    layer_stat_begin(opt, &t0, &c0);
+    bool ok = layer_diff(opt, pool, err, csg2_out, i);
+    layer_stat_end(opt, i, true, &t0, &c0);
+    cp_trace_span_args(opt->csg.trace, "layer diff", t_trace,
+        "\"zi\":%"_Pz"u,\"z\":%g", i, cp_v_nth(&csg2_out->z, i));
+    CP_PROBE2(layer_diff_end, i, ok);
+    return ok;
+}
+
+/**
+ * Process for each layer the CSG and then its triangulation
+ *
+ * This can theoretically be run in multiple threads: each thread
+ * needs its own pool, and next_i needs to be made atomic.
+ */
+static bool process_stack_csg(
+    cp_opt_t *opt,
+    cp_pool_t *pool,
+    cp_err_t *err,
+    cp_csg2_cache_t *cache,
+    cp_csg2_tree_t *csg2,
+    cp_csg2_tree_t *csg2b,
+    cp_csg2_tree_t *csg2_out,
+    size_t *zi_p,
+    size_t  zi_count)
+{
+    size_t i;
+    while (next_i(&i, zi_p, zi_count)) {
+        if (!progress(opt, err, CP_PROGRESS_SLICE, i, zi_count) ||
+            !process_layer_csg(opt, pool, err, cache, csg2, csg2b, csg2_out, i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Second run through the layer stack: XOR between two layers plus its triangulation
+ *
+ * This can theoretically be run in multiple threads: each thread
+ * needs its own pool, and next_i needs to be made atomic.
+ */
+static bool process_stack_diff(
+    cp_opt_t *opt,
+    cp_pool_t *pool,
+    cp_err_t *err,
+    cp_csg2_tree_t *csg2_out,
+    size_t *zi_p,
+    size_t  zi_count)
+{
+    size_t i;
+    while (next_i(&i, zi_p, zi_count)) {
+        if (!progress(opt, err, CP_PROGRESS_DIFF, i, zi_count) ||
+            !process_layer_diff(opt, pool, err, csg2_out, i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef struct {
+    cp_opt_t *opt;
+    cp_pool_t *pool;
+    cp_scad_tree_t *scad;
+    cp_csg3_tree_t *csg3;
+    /** number of statements at the start of scad->toplevel to keep */
+    size_t keep;
+} stream_t;
+
+/**
+ * Stages 2+3 for a single top-level statement in streaming mode.
+ */
+static bool stream_stmt(
+    void *user,
+    cp_syn_tree_t *r)
+{
+    stream_t *s = user;
+    cp_scad_t *root = s->scad->root;
+    stat_time_t t0;
+    stat_begin(s->opt, STAGE_SCAD, &t0);
+    if (!cp_scad_from_syn_tree(s->scad, r)) {
+        return false;
+    }
+    stat_end(s->opt, STAGE_SCAD, &t0);
+    stat_begin(s->opt, STAGE_CSG3, &t0);
+
+    bool ok = true;
+    if (s->scad->root != root) {
+        /* '!' modifier: only that subtree is used, so drop what was converted so far */
+        cp_csg3_tree_fini(s->csg3);
+        ok = cp_csg3_from_scad_tree(s->pool, r, s->csg3, &r->err, s->scad);
+        stat_end(s->opt, STAGE_CSG3, &t0);
+
+        /* keep the statement with the root SCAD object: its location is
+         * needed to report another '!' */
+        s->keep = s->scad->toplevel.size;
+        return ok;
+    }
+    if (root == NULL) {
+        ok = cp_csg3_from_scad_tree(s->pool, r, s->csg3, &r->err, s->scad);
+    }
+    stat_end(s->opt, STAGE_CSG3, &t0);
+
+    for (cp_v_each(i, &s->scad->toplevel, s->keep)) {
+        cp_scad_delete(cp_v_nth(&s->scad->toplevel, i));
+    }
+    s->scad->toplevel.size = s->keep;
+    return ok;
+}
+
+/**
+ * Stages 1..3: read a source file into a CSG3 tree.
+ *
+ * If a dump option stops processing before stage 3, this
+ * sets *done and returns true.
+ */
+static bool csg3_from_source(
+    cp_stream_t *sout,
+    cp_opt_t *opt,
+    cp_pool_t *pool,
+    cp_syn_tree_t *r,
+    cp_csg3_tree_t *csg3,
+    bool *done,
+    const char *fn,
+    FILE *f)
+{
+    cp_scad_tree_t *scad = CP_NEW(*scad);
+    stat_time_t t0;
+    stat_begin(opt, STAGE_PARSE, &t0);
+    if (has_suffix(fn, ".stl")) {
+        /* stage 1+2: STL file is read directly into a polyhedron */
+        cp_scad_polyhedron_t *p = cp_scad_new(*p, NULL);
+        cp_v_push(&scad->toplevel, cp_scad_cast(cp_scad_t, p));
+        if (!cp_stl_parse(r, &r->err, p, NULL, fn, f)) {
+            return false;
+        }
+        stat_end(opt, STAGE_PARSE, &t0);
+    }
+    else
+    if (opt->stream && !opt->dump_syn && !opt->dump_scad) {
+        /* stage 1..3, one top-level statement at a time */
+        stream_t s = {
+            .opt = opt,
+            .pool = pool,
+            .scad = scad,
+            .csg3 = csg3,
+        };
+        stats_t before = opt->stat;
+        bool ok = cp_syn_parse_each(r, fn, f, stream_stmt, &s);
+        stat_end(opt, STAGE_PARSE, &t0);
+        cp_scad_tree_fini(scad);
+        CP_FREE(scad);
+
+        /* stages 2+3 were timed by stream_stmt(): they are not parsing */
+        for (cp_size_each(i, 2)) {
+            stage_t k = (i == 0) ? STAGE_SCAD : STAGE_CSG3;
+            opt->stat.time[STAGE_PARSE].wall -= opt->stat.time[k].wall - before.time[k].wall;
+            opt->stat.time[STAGE_PARSE].cpu  -= opt->stat.time[k].cpu  - before.time[k].cpu;
+        }
+        return ok;
+    }
+    else {
+        /* stage 1: syntax tree */
+        if (!cp_syn_parse(r, fn, f)) {
+            return false;
+        }
+        stat_end(opt, STAGE_PARSE, &t0);
+        if (opt->dump_syn) {
+            cp_syn_tree_put_scad(sout, r);
+            *done = true;
+            return true;
+        }
+
+        /* stage 2: SCAD */
+        stat_begin(opt, STAGE_SCAD, &t0);
+        if (!cp_scad_from_syn_tree(scad, r)) {
+            return false;
+        }
+        stat_end(opt, STAGE_SCAD, &t0);
+    }
+    if (opt->dump_scad) {
+        cp_scad_tree_put_scad(sout, scad);
+        *done = true;
+        return true;
+    }
+
+    /* stage 3: 3D CSG */
+    stat_begin(opt, STAGE_CSG3, &t0);
+    bool ok = cp_csg3_from_scad_tree(pool, r, csg3, &r->err, scad);
+    stat_end(opt, STAGE_CSG3, &t0);
+    return ok;
+}
+
+/**
+ * Stages 1..3 from a CSG3 cache file.  If the cache is stale,
+ * the source file is read again and the cache is updated.
+ */
+static bool csg3_from_cache(
+    cp_stream_t *sout,
+    cp_opt_t *opt,
+    cp_pool_t *pool,
+    cp_syn_tree_t *r,
+    cp_csg3_tree_t *csg3,
+    bool *done,
+    const char *fn)
+{
+    bool stale = false;
+    cp_vchar_t src;
+    cp_vchar_init(&src);
+    stat_time_t t0;
+    stat_begin(opt, STAGE_PARSE, &t0);
+    if (!cp_csg3_cache_load(csg3, &stale, &src, &r->err, fn)) {
+        return false;
+    }
+    stat_end(opt, STAGE_PARSE, &t0);
+    if (!stale) {
+        cp_vchar_fini(&src);
+        return true;
+    }
+
+    if (opt->verbose >= 1) {
+        fprintf(stderr, "Info: Cache '%s' is stale, re-reading '%s'\n", fn, src.data);
+    }
+    FILE *f = fopen(src.data, "rt");
+    if (f == NULL) {
+        cp_vchar_printf(&r->err.msg, "Unable to open '%s' for reading: %s\n",
+            src.data, strerror(errno));
+        return false;
+    }
+    bool ok = csg3_from_source(sout, opt, pool, r, csg3, done, src.data, f);
+    fclose(f);
+    cp_vchar_fini(&src);
+    if (ok && !*done) {
+        stat_begin(opt, STAGE_OUTPUT, &t0);
+        ok = cp_csg3_cache_save(&r->err, fn, csg3, r);
+        stat_end(opt, STAGE_OUTPUT, &t0);
+    }
+    return ok;
+}
+
+static void put_csg2(
+    cp_opt_t *opt,
+    cp_out_t *o,
+    cp_csg2_tree_t *csg2_out,
+    cp_vec3_minmax_t const *bb,
+    cp_vec3_minmax_t const *full_bb)
+{
+    switch (o->format) {
+    case OUT_NONE:
+    case OUT_CACHE:
+        return;
+
+    case OUT_CSG2:
+        cp_csg2_tree_put_scad(&o->stream, csg2_out);
+        return;
+
+    case OUT_STL:
+        cp_csg2_tree_put_stl(&o->stream, csg2_out);
+        return;
+
+    case OUT_JS:
+        cp_csg2_tree_put_js(&o->stream, csg2_out);
         return;
+
+    case OUT_PS:{
+        cp_ps_xform_t xform = CP_PS_XFORM_MM;
+        switch (opt->ps_scale_step) {
+        default:
+            break;
+
+        case 1:
+            cp_ps_xform_from_bb(&xform,
+                bb->min.x, bb->min.y,
+                bb->max.x, bb->max.y);
+            break;
+
+        case 2:
+            cp_ps_xform_from_bb(&xform,
+                full_bb->min.x, full_bb->min.y,
+                full_bb->max.x, full_bb->max.y);
+            break;
+        }
+        opt->ps.xform1 = &xform;
+        cp_csg2_tree_put_ps(&o->stream, &opt->ps, csg2_out);
+        opt->ps.xform1 = NULL;
+        return;}
     }
-    fprintf(stderr, "Error: %s: invalid boolean: '%s'\n", arg, str);
-    my_exit(1);
+    CP_DIE("output format");
 }
 
-static void get_arg_err(
-    unsigned *v,
-    char const *arg,
-    char const *str)
+static void put_csg2_begin(
+    cp_out_t *o,
+    cp_csg2_tree_t *csg2_out)
 {
-    if (strequ(str, "fail") ||
-        strequ(str, "error") ||
-        strequ(str, "err"))
-    {
-        *v = CP_ERR_FAIL;
+    switch (o->format) {
+    case OUT_CSG2:
+        cp_csg2_tree_put_scad_begin(&o->stream, csg2_out);
+        return;
+
+    case OUT_STL:
+        cp_csg2_tree_put_stl_begin(&o->stream, csg2_out);
+        return;
+
+    case OUT_JS:
+        o->js = cp_csg2_tree_put_js_begin(&o->stream, csg2_out);
+        return;
+
+    case OUT_NONE:
+    case OUT_PS:
+    case OUT_CACHE:
         return;
     }
+    CP_DIE("output format");
+}
+
+static void put_csg2_layer(
+    cp_out_t *o,
+    cp_csg2_tree_t *csg2_out,
+    size_t zi)
+{
+    switch (o->format) {
+    case OUT_CSG2:
+        cp_csg2_tree_put_scad_layer(&o->stream, csg2_out, zi);
+        return;
+
+    case OUT_STL:
+        cp_csg2_tree_put_stl_layer(&o->stream, csg2_out, zi);
+        return;
+
+    case OUT_JS:
+        cp_csg2_tree_put_js_layer(o->js, &o->stream, zi);
+        return;
+
+    case OUT_NONE:
+    case OUT_PS:
+    case OUT_CACHE:
+        return;
+    }
+    CP_DIE("output format");
+}
+
+static void put_csg2_end(
+    cp_out_t *o,
+    cp_csg2_tree_t *csg2_out)
+{
+    switch (o->format) {
+    case OUT_CSG2:
+        cp_csg2_tree_put_scad_end(&o->stream, csg2_out);
+        return;
+
+    case OUT_STL:
+        cp_csg2_tree_put_stl_end(&o->stream, csg2_out);
+        return;
+
+    case OUT_JS:
+        cp_csg2_tree_put_js_end(o->js, &o->stream);
+        o->js = NULL;
+        return;
+
+    case OUT_NONE:
+    case OUT_PS:
+    case OUT_CACHE:
+        return;
+    }
+    CP_DIE("output format");
+}
+
+/**
+ * Write a finished layer to all outputs, then delete it.
+ */
+static void put_layer_done(
+    cp_opt_t *opt,
+    cp_csg2_tree_t *csg2_out,
+    size_t zi)
+{
+    stat_time_t t0;
+    stat_begin(opt, STAGE_OUTPUT, &t0);
+    double t_trace = cp_trace_now(opt->csg.trace);
+    for (cp_v_each(i, &opt->out)) {
+        put_csg2_layer(&cp_v_nth(&opt->out, i), csg2_out, zi);
+    }
+    cp_trace_span_args(opt->csg.trace, "write layer", t_trace,
+        "\"zi\":%"_Pz"u", zi);
+    cp_csg2_tree_delete_layer(csg2_out, zi);
+    stat_end(opt, STAGE_OUTPUT, &t0);
+}
+
+/**
+ * Process and write the layer stack layer by layer.
+ *
+ * A layer is written to all outputs as soon as it and its diffs
+ * are complete, i.e., with diffs, one layer after it was sliced.
+ * It is then deleted, together with the corresponding input layer,
+ * so memory does not grow with the number of layers.
+ *
+ * This requires a single stack, i.e., the CSG stage must not
+ * be skipped.
+ */
+static bool process_stack_stream(
+    cp_opt_t *opt,
+    cp_pool_t *pool,
+    cp_err_t *err,
+    cp_csg2_cache_t *cache,
+    cp_csg2_tree_t *csg2,
+    cp_csg2_tree_t *csg2_out,
+    bool diff,
+    size_t zi_count)
+{
+    assert(!opt->no_csg);
+    for (cp_size_each(i, zi_count)) {
+        if (!progress(opt, err, CP_PROGRESS_SLICE, i, zi_count) ||
+            !process_layer_csg(opt, pool, err, cache, csg2, csg2_out, csg2_out, i))
+        {
+            return false;
+        }
+        cp_csg2_tree_delete_layer(csg2, i);
+
+        if (!diff) {
+            put_layer_done(opt, csg2_out, i);
+        }
+        else if (i > 0) {
+            if (!process_layer_diff(opt, pool, err, csg2_out, i - 1)) {
+                return false;
+            }
+            put_layer_done(opt, csg2_out, i - 1);
+        }
+    }
+    if (diff && (zi_count > 0)) {
+        if (!process_layer_diff(opt, pool, err, csg2_out, zi_count - 1)) {
+            return false;
+        }
+        put_layer_done(opt, csg2_out, zi_count - 1);
+    }
+    return true;
+}
+
+static bool do_file_pool(
+    cp_opt_t *opt,
+    cp_pool_t *pool,
+    cp_syn_tree_t *r,
+    const char *fn,
+    FILE *f)
+{
+    /* stream for the intermediate stage dumps: there is only one output */
+    cp_stream_t *sout = &cp_v_nth(&opt->out, 0).stream;
+
+    opt->progress.user = (void*)(size_t)fn;
+    if (!progress(opt, &r->err, CP_PROGRESS_READ, 0, 0)) {
+        return false;
+    }
+
+    /* stage 1..3: 3D CSG */
+    cp_csg3_tree_t *csg3 = CP_NEW(*csg3);
+    csg3->opt = &opt->csg;
+    bool done = false;
+    if (has_suffix(fn, ".hob3lc")) {
+        if (!csg3_from_cache(sout, opt, pool, r, csg3, &done, fn)) {
+            return false;
+        }
+    }
+    else {
+        if (!csg3_from_source(sout, opt, pool, r, csg3, &done, fn, f)) {
+            return false;
+        }
+    }
+    if (done) {
+        return true;
+    }
+
+    bool need_slice = false;
+    bool need_diff = false;
+    bool can_stream = !opt->no_csg;
+    stat_time_t t0;
+    for (cp_v_each(i, &opt->out)) {
+        cp_out_t const *o = &cp_v_nth(&opt->out, i);
+        if (o->format == OUT_CACHE) {
+            stat_begin(opt, STAGE_OUTPUT, &t0);
+            if (!cp_csg3_cache_save(&r->err, o->file_name, csg3, r)) {
+                return false;
+            }
+            stat_end(opt, STAGE_OUTPUT, &t0);
+        }
+        else {
+            need_slice = true;
+        }
+        need_diff |= (o->format == OUT_JS);
+        can_stream &= (o->format != OUT_PS);
+    }
+    if (!need_slice) {
+        return true;
+    }
+
+    cp_vec3_minmax_t full_bb = CP_VEC3_MINMAX_EMPTY;
+    if (csg3->root != NULL) {
+        cp_csg3_tree_bb(&full_bb, csg3, true);
+#ifdef PSTRACE
+        cp_ps_xform_from_bb(&cp_debug_ps_xform,
+            full_bb.min.x, full_bb.min.y,
+            full_bb.max.x, full_bb.max.y);
+        cp_debug_ps_xform.add_x -= CP_PS_PAPER_X/2;
+        cp_debug_ps_xform.add_y -= CP_PS_PAPER_Y/2;
+        cp_debug_ps_xform.add_x *= cp_debug_ps_scale_x;
+        cp_debug_ps_xform.add_y *= cp_debug_ps_scale_y;
+        cp_debug_ps_xform.mul_x *= cp_debug_ps_scale_x;
+        cp_debug_ps_xform.mul_y *= cp_debug_ps_scale_y;
+        cp_debug_ps_xform.add_x += CP_PS_PAPER_X/2;
+        cp_debug_ps_xform.add_y += CP_PS_PAPER_Y/2;
+        cp_debug_ps_xform.add_x += (cp_debug_ps_xlat_x * cp_debug_ps_xform.mul_x);
+        cp_debug_ps_xform.add_y += (cp_debug_ps_xlat_y * cp_debug_ps_xform.mul_y);
+#endif
+    }
+
+    if (opt->dump_csg3) {
+        cp_csg3_tree_put_scad(sout, csg3);
+        return true;
+    }
+
+    /* Get bounding box (normal one, i.e., ignoring stuff that is subtracted) */
+    cp_vec3_minmax_t bb = CP_VEC3_MINMAX_EMPTY;
+    cp_csg3_tree_bb(&bb, csg3, false);
+
+    /* simplify the tree: each layer has less work with a smaller tree */
+    stat_begin(opt, STAGE_CSG3, &t0);
+    cp_csg3_tree_optimise(csg3);
+    stat_end(opt, STAGE_CSG3, &t0);
+
+    if (opt->dump_csg3_opt) {
+        cp_csg3_tree_put_scad(sout, csg3);
+        return true;
+    }
+
+    /* stage 4: 2D CSG */
+    cp_dim_t z_min = bb.min.z + opt->z_step/2;
+    cp_dim_t z_max = bb.max.z;
+    if (opt->have_z_min) {
+        z_min = opt->z_min;
+    }
+    if (opt->have_z_max) {
+        z_max = opt->z_max;
+    }
+
+    cp_range_t range;
+    cp_range_init(&range, z_min, z_max, opt->z_step);
+    if (range.cnt == 0) {
+        range.cnt = 1;
+    }
+    if (opt->z_list.size > 0) {
+        range.cnt = opt->z_list.size;
+    }
+
+    if (opt->verbose >= 1) {
+        if (opt->z_list.size > 0) {
+            fprintf(stderr, "Info: Z: list, step=%g, layer_cnt=%"_Pz"u\n",
+                range.step, range.cnt);
+        }
+        else {
+            fprintf(stderr, "Info: Z: min=%g, step=%g, layer_cnt=%"_Pz"u, max=%g\n",
+                range.min, range.step, range.cnt,
+                range.min + (range.step * cp_f(range.cnt - 1)));
+        }
+    }
+
+    /* process layer by layer: extract layer, slice, triangulate */
+    cp_csg2_tree_t *csg2 = CP_NEW(*csg2);
+    if (opt->z_list.size > 0) {
+        cp_csg2_tree_from_csg3_z(csg2, csg3, opt->z_list.data, opt->z_list.size,
+            opt->z_step, &opt->csg);
+    }
+    else {
+        cp_csg2_tree_from_csg3(csg2, csg3, &range, &opt->csg);
+    }
+
+    cp_csg2_tree_t *csg2b = CP_NEW(*csg2b);
+    cp_csg2_op_tree_init(csg2b, csg2);
+
+    cp_csg2_tree_t *csg2_out = opt->no_csg ? csg2 : csg2b;
+
+    if (opt->layer_stats != NULL) {
+        cp_v_clear(&opt->layer_stat, 0);
+        cp_v_set_size(&opt->layer_stat, range.cnt);
+    }
+
+    /* layer cache: this stores the result of the CSG pass */
+    cp_csg2_cache_t *cache = NULL;
+    if ((opt->cache != NULL) && !opt->no_csg) {
+        cache = opt->cache;
+        cp_csg2_cache_set_tree(cache, csg3, !opt->no_tri);
+    }
+
+    bool ok;
+    if (can_stream) {
+        stat_begin(opt, STAGE_OUTPUT, &t0);
+        for (cp_v_each(i, &opt->out)) {
+            put_csg2_begin(&cp_v_nth(&opt->out, i), csg2_out);
+        }
+        stat_end(opt, STAGE_OUTPUT, &t0);
+        ok = process_stack_stream(opt, pool, &r->err, cache, csg2, csg2_out,
+            need_diff && !opt->no_diff, range.cnt);
+
+        /* On error, the footer is not written, so that a partial output
+         * file is not mistaken for a complete one. */
+        if (ok) {
+            stat_begin(opt, STAGE_OUTPUT, &t0);
+            for (cp_v_each(i, &opt->out)) {
+                put_csg2_end(&cp_v_nth(&opt->out, i), csg2_out);
+            }
+            stat_end(opt, STAGE_OUTPUT, &t0);
+        }
+    }
+    else {
+        size_t zi = 0;
+        ok = process_stack_csg(opt, pool, &r->err, cache, csg2, csg2b, csg2_out, &zi, range.cnt);
+
+        /* compute diff if there is any output format that can use it */
+        if (ok && need_diff && !opt->no_diff) {
+            zi = 0;
+            ok = process_stack_diff(opt, pool, &r->err, csg2_out, &zi, range.cnt);
+        }
+
+        /* print: all outputs from the same stack */
+        if (ok) {
+            ok = progress(opt, &r->err, CP_PROGRESS_WRITE, range.cnt, range.cnt);
+        }
+        if (ok) {
+            stat_begin(opt, STAGE_OUTPUT, &t0);
+            for (cp_v_each(i, &opt->out)) {
+                double t_trace = cp_trace_now(opt->csg.trace);
+                put_csg2(opt, &cp_v_nth(&opt->out, i), csg2_out, &bb, &full_bb);
+                cp_trace_span_args(opt->csg.trace, "write", t_trace,
+                    "\"output\":%"_Pz"u", i);
+            }
+            stat_end(opt, STAGE_OUTPUT, &t0);
+        }
+    }
+
+    if (opt->layer_stats != NULL) {
+        layer_stats_write(opt, csg2, fn);
+    }
+
+    if (cache != NULL) {
+        if (opt->verbose >= 1) {
+            fprintf(stderr, "Info: Layer cache: %"_Pz"u reused, %"_Pz"u computed\n",
+                cache->hit_cnt, cache->miss_cnt);
+        }
+    }
+    if (ok) {
+        ok = progress(opt, &r->err, CP_PROGRESS_DONE, range.cnt, range.cnt);
+    }
+    return ok;
+}
+
+static bool do_file(
+    cp_opt_t *opt,
+    cp_syn_tree_t *r,
+    const char *fn,
+    FILE *f)
+{
+    /* pool for tmp objects */
+    cp_pool_t pool;
+    cp_pool_init(&pool, 0);
+
+    bool ok = do_file_pool(opt, &pool, r, fn, f);
+
+    opt->stat.pool_used_max = pool.used_max;
+    opt->stat.pool_elem_max = pool.elem_max;
+    opt->stat.pool_block_total = pool.block_total;
+    return ok;
+}
+
+/**
+ * In a job of --serve mode: the connection to the client, to which the
+ * exit status is sent.
+ */
+static int serve_conn = -1;
+
+__attribute__((noreturn))
+static void my_exit(int i)
+{
+    if (serve_conn >= 0) {
+        fflush(stdout);
+        fflush(stderr);
+        int32_t status = i;
+        (void)!write(serve_conn, &status, sizeof(status));
+    }
+#ifdef PSTRACE
+    if (cp_debug_ps != NULL) {
+        cp_ps_doc_end(cp_debug_ps, cp_debug_ps_page_cnt, 0, 0, -1, -1);
+        CP_FREE(cp_debug_ps);
+    }
+    if (cp_debug_ps_file != NULL) {
+        fclose(cp_debug_ps_file);
+        cp_debug_ps_file = NULL;
+    }
+#endif
+    exit(i);
+}
+
+static char const *cp_prog_name(void)
+{
+    return CP_PROG_NAME;
+}
+
+static char const *opt_help;
+
+__attribute__((noreturn))
+static void help(void)
+{
+#define PRI printf
+    PRI("Usage: %s [Options] INFILE\n", cp_prog_name());
+    PRI("       %s --serve=SOCKET\n", cp_prog_name());
+    PRI("       %s --client=SOCKET [Options] INFILE\n", cp_prog_name());
+    PRI("\n");
+    PRI("This reads 3D CSG models from (simple syntax) SCAD files, slices\n"
+        "them into layers of 2D CSG models, applies 2D CSG boolean operations\n"
+        "to the resulting polygon stack (instead of the 3D polyhedra), and outputs the\n"
+        "result as STL file consisting of a (trivially extruded) polygon per slice.\n");
+    PRI("\n");
+    PRI("If INFILE ends in .stl, it is read as a binary or ASCII STL file instead.\n");
+    PRI("If INFILE ends in .hob3lc, it is read as a 3D CSG cache file written with\n"
+        "'-o FILE.hob3lc'.  If the source file of the cache has changed, it is read\n"
+        "again and the cache file is updated.\n");
+    PRI("If INFILE is '-', the SCAD file is read from stdin.\n");
+    PRI("\n");
+    PRI("With --serve, the process waits for jobs on the given Unix socket.  With\n"
+        "--client, the job is run by that server instead of in this process, using\n"
+        "the current directory, stdin, stdout, and stderr of the client, and the\n"
+        "client exits with the status of the job.\n");
+    PRI("\n");
+    PRI("Options:\n");
+    PRI("%s", opt_help);
+#undef PRI
+    my_exit(0);
+}
+
+static void get_arg_bool(
+    bool *v,
+    char const *arg,
+    char const *str)
+{
+    if ((str == NULL) ||
+        strequ(str, "true") ||
+        strequ(str, "1") ||
+        strequ(str, "yes"))
+    {
+        *v = true;
+        return;
+    }
+    if (strequ(str, "false") ||
+        strequ(str, "0") ||
+        strequ(str, "no"))
+    {
+        *v = false;
+        return;
+    }
+    fprintf(stderr, "Error: %s: invalid boolean: '%s'\n", arg, str);
+    my_exit(1);
+}
+
+static void get_arg_err(
+    unsigned *v,
+    char const *arg,
+    char const *str)
+{
+    if (strequ(str, "fail") ||
+        strequ(str, "error") ||
+        strequ(str, "err"))
+    {
+        *v = CP_ERR_FAIL;
+        return;
+    }
+
+    if (strequ(str, "ign") ||
+        strequ(str, "ignore"))
+    {
+        *v = CP_ERR_IGNORE;
+        return;
+    }
+
+    if (strequ(str, "warn") ||
+        strequ(str, "warning"))
+    {
+        *v = CP_ERR_WARN;
+        return;
+    }
+
+    fprintf(stderr, "Error: %s: invalid problem handling: '%s', expected 'error' or 'ignore'\n",
+        arg, str);
+    my_exit(1);
+}
+
+static void get_arg_neg_bool(
+    bool *v,
+    char const *arg,
+    char const *str)
+{
+    bool x = false;
+    get_arg_bool(&x, arg, str);
+    *v = !x;
+}
+
+#define get_arg_angle get_arg_dim
+#define get_arg_scale get_arg_dim
+
+static void get_arg_dim(
+    cp_dim_t *v,
+    char const *arg,
+    char const *str)
+{
+    char *r = NULL;
+    *v = strtod(str, &r);
+    if ((str == r) || (*r != '\0')) {
+        fprintf(stderr, "Error: %s: invalid number: '%s'\n", arg, str);
+        my_exit(1);
+    }
+}
+
+static int cmp_double(
+    double const *a,
+    double const *b,
+    void *user __unused)
+{
+    return (*a < *b) ? -1 : (*a > *b) ? +1 : 0;
+}
+
+static void get_arg_z_list(
+    cp_v_double_t *v,
+    char const *arg,
+    char const *str)
+{
+    cp_v_clear(v, 0);
+    char const *p = str;
+    for (;;) {
+        char *r = NULL;
+        double z = strtod(p, &r);
+        if ((p == r) || ((*r != ',') && (*r != '\0'))) {
+            fprintf(stderr, "Error: %s: invalid list of numbers: '%s'\n", arg, str);
+            my_exit(1);
+        }
+        cp_v_push(v, z);
+        if (*r == '\0') {
+            break;
+        }
+        p = r + 1;
+    }
+
+    /* sort and remove duplicates */
+    cp_v_qsort(v, 0, CP_SIZE_MAX, cmp_double, NULL);
+    size_t k = 0;
+    for (cp_v_each(i, v)) {
+        if ((k == 0) || !cp_eq(cp_v_nth(v, k-1), cp_v_nth(v, i))) {
+            cp_v_nth(v, k++) = cp_v_nth(v, i);
+        }
+    }
+    cp_v_set_size(v, k);
+}
+
+static void get_arg_xy_window(
+    cp_vec2_minmax_t *v,
+    char const *arg,
+    char const *str)
+{
+    double c[4];
+    char const *p = str;
+    for (cp_arr_each(i, c)) {
+        char *r = NULL;
+        c[i] = strtod(p, &r);
+        if ((p == r) || (*r != ((i == 3) ? '\0' : ','))) {
+            fprintf(stderr, "Error: %s: expected 'X0,Y0,X1,Y1': '%s'\n", arg, str);
+            my_exit(1);
+        }
+        p = r + 1;
+    }
+    v->min.x = c[0];
+    v->min.y = c[1];
+    v->max.x = c[2];
+    v->max.y = c[3];
+    if (!cp_lt(v->min.x, v->max.x) || !cp_lt(v->min.y, v->max.y)) {
+        fprintf(stderr, "Error: %s: empty window: '%s'\n", arg, str);
+        my_exit(1);
+    }
+}
+
+static void get_arg_size(
+    size_t *v,
+    char const *arg,
+    char const *str)
+{
+    char *r = NULL;
+    unsigned long long val = strtoull(str, &r, 10);
+    if ((str == r) || (*r != '\0')) {
+        fprintf(stderr, "Error: %s: invalid number: '%s'\n", arg, str);
+        my_exit(1);
+    }
+    *v = val & CP_MAX_OF(*v);
+}
+
+static void get_arg_stats_opt(
+    unsigned *v,
+    char const *arg,
+    char const *str)
+{
+    if (str == NULL) {
+        *v = STATS_TEXT;
+    }
+    else if (strequ(str, "json")) {
+        *v = STATS_JSON;
+    }
+    else {
+        fprintf(stderr, "Error: %s: expected 'json': '%s'\n", arg, str);
+        my_exit(1);
+    }
+}
+
+static void get_arg_uint8(
+    unsigned char *v,
+    char const *arg,
+    char const *str)
+{
+    size_t v2;
+    get_arg_size(&v2, arg, str);
+    if (v2 > 255) {
+        fprintf(stderr, "Error %s: invalid color value: %s expected 0..255\n", arg, str);
+        my_exit(1);
+    }
+    *v = v2 & 0xff;
+}
+
+static void get_arg_rgb(
+    cp_color_rgb_t *v,
+    char const *arg,
+    char const *str)
+{
+    char *r = NULL;
+    unsigned long w = strtoul(str, &r, 16);
+    if ((str == r) || (*r != '\0')) {
+        fprintf(stderr, "Error: %s: invalid rgb color: '%s'\n", arg, str);
+        my_exit(1);
+    }
+
+    v->r = (w >> 16) & 0xff;
+    v->g = (w >> 8)  & 0xff;
+    v->b = (w >> 0)  & 0xff;
+}
+
+typedef struct {
+    char const *name;
+    void (*func)(cp_opt_t *, char const *, char const *);
+    unsigned need_arg;
+} cp_get_opt_t;
+
+#include "opt.inc"
+
+typedef struct {
+    char const *s;
+    size_t n;
+} cp_string_n_t;
+
+static int opt_cmp(void const *_a, void const *_b)
+{
+    cp_string_n_t const *a = _a;
+    cp_get_opt_t const *b = _b;
+    int i = strncmp(a->s, b->name, a->n);
+    if (i != 0) {
+        return i;
+    }
+    if (b->name[a->n] != '\0') {
+        return -1;
+    }
+    return 0;
+}
+
+static void parse_opt(
+    cp_opt_t *opt,
+    int *i,
+    int argc,
+    char **argv)
+{
+    char const *argvi = argv[*i];
+
+    cp_string_n_t key = { .s = argvi };
+    while (*key.s == '-') {
+        key.s++;
+    }
+    key.n = strlen(key.s);
+    char const *eq = strchr(key.s, '=');
+    if (eq != NULL) {
+        key.n = CP_PTRDIFF(eq, key.s);
+    }
+
+    cp_get_opt_t *g =
+        bsearch(&key, opt_list, cp_countof(opt_list), sizeof(opt_list[0]), opt_cmp);
+    if (g == NULL) {
+        fprintf(stderr, "Error: Unrecognised option: '%s'\n", argvi);
+        my_exit(1);
+    }
+
+    char const *arg = NULL;
+    if (g->need_arg > 0) {
+        if (key.s[key.n] == '=') {
+            arg = key.s + key.n + 1;
+        }
+        else
+        if (g->need_arg == 2) {
+            if ((*i + 1) >= argc) {
+                fprintf(stderr, "Error: Expected argument for '%s'\n", argvi);
+                my_exit(1);
+            }
+            arg = argv[++*i];
+        }
+    }
+
+    g->func(opt, argvi, arg);
+}
+
+/**
+ * Name of the temporary file an output is written to before it is
+ * renamed.
+ */
+static void out_tmp_name(
+    cp_vchar_t *fn,
+    cp_out_t const *o)
+{
+    cp_vchar_printf(fn, "%s.%ld.new", o->file_name, (long)getpid());
+}
+
+/**
+ * Open the output files.
+ *
+ * With atomic, each file is written under a temporary name and is
+ * renamed by close_out().
+ */
+static void open_out(
+    cp_opt_t *opt,
+    bool atomic)
+{
+    for (cp_v_each(i, &opt->out)) {
+        cp_out_t *o = &cp_v_nth(&opt->out, i);
+        o->file = stdout;
+        if (o->format == OUT_CACHE) {
+            /* the cache is written in binary by cp_csg3_cache_save() */
+            o->file = NULL;
+        }
+        else if (o->file_name != NULL) {
+            cp_vchar_t fn;
+            cp_vchar_init(&fn);
+            if (atomic) {
+                out_tmp_name(&fn, o);
+            }
+            else {
+                cp_vchar_printf(&fn, "%s", o->file_name);
+            }
+            o->file = fopen(fn.data, "wt");
+            if (o->file == NULL) {
+                fprintf(stderr, "Error: Unable to open '%s' for writing: %s\n",
+                    fn.data, strerror(errno));
+                my_exit(1);
+            }
+            cp_vchar_fini(&fn);
+        }
+        o->stream = *CP_STREAM_FROM_FILE(o->file);
+    }
+}
+
+/**
+ * Close the output files.
+ *
+ * With atomic, the temporary files are renamed if ok is true, and
+ * removed otherwise, so the old output stays in place if there was an
+ * error.
+ *
+ * Returns whether all files were written.
+ */
+static bool close_out(
+    cp_opt_t *opt,
+    bool atomic,
+    bool ok)
+{
+    for (cp_v_each(i, &opt->out)) {
+        cp_out_t *o = &cp_v_nth(&opt->out, i);
+        if ((o->file == NULL) || (o->file == stdout)) {
+            continue;
+        }
+        bool ok1 = (fclose(o->file) == 0);
+        o->file = NULL;
+        if (!atomic) {
+            continue;
+        }
+        cp_vchar_t fn;
+        cp_vchar_init(&fn);
+        out_tmp_name(&fn, o);
+        if (ok && ok1 && (rename(fn.data, o->file_name) != 0)) {
+            ok1 = false;
+        }
+        if (!ok1) {
+            fprintf(stderr, "Error: Unable to write '%s': %s\n",
+                o->file_name, strerror(errno));
+        }
+        if (!(ok && ok1)) {
+            (void)remove(fn.data);
+        }
+        cp_vchar_fini(&fn);
+        ok = ok && ok1;
+    }
+    return ok;
+}
+
+/**
+ * Open the --trace file for an input file.  On error, this prints a
+ * message and processing continues without trace.
+ */
+static void trace_open(
+    cp_opt_t *opt,
+    char const *in_file_name)
+{
+    cp_vchar_t fn;
+    cp_vchar_init(&fn);
+    out_name_expand(&fn, opt->trace_name, in_file_name);
+    if (cp_trace_open(&opt->trace, fn.data)) {
+        opt->csg.trace = &opt->trace;
+    }
+    else {
+        fprintf(stderr, "Error: Unable to open '%s' for writing: %s\n",
+            fn.data, strerror(errno));
+    }
+    cp_vchar_fini(&fn);
+}
+
+/**
+ * Process one input file into all outputs.
+ *
+ * On error, prints the error message and returns false.
+ */
+static bool run_file(
+    cp_opt_t *opt,
+    cp_syn_tree_t *r,
+    char const *in_file_name,
+    bool atomic)
+{
+    open_out(opt, atomic);
+
+    FILE *fin = stdin;
+    if (strequ(in_file_name, "-")) {
+        in_file_name = "<stdin>";
+    }
+    else {
+        fin = fopen(in_file_name, "rt");
+        if (fin == NULL) {
+            fprintf(stderr, "Error: Unable to open '%s' for reading: %s\n",
+                in_file_name, strerror(errno));
+            (void)close_out(opt, atomic, false);
+            return false;
+        }
+    }
+
+    CP_ZERO(&opt->stat);
+    if (opt->trace_name != NULL) {
+        trace_open(opt, in_file_name);
+    }
+    bool ok = do_file(opt, r, in_file_name, fin);
+    if (fin != stdin) {
+        fclose(fin);
+    }
+    if (opt->csg.trace != NULL) {
+        if (!cp_trace_close(opt->csg.trace)) {
+            fprintf(stderr, "Error: Unable to write trace for '%s': %s\n",
+                in_file_name, strerror(errno));
+        }
+        opt->csg.trace = NULL;
+    }
+    if (opt->stats != STATS_NONE) {
+        stats_print(opt, in_file_name);
+    }
+    if (opt->csg.prof != NULL) {
+        if (ok) {
+            profile_source_print(opt, r, in_file_name);
+        }
+        cp_csg_prof_fini(&opt->prof);
+    }
+
+    if (!ok) {
+        /* print error (FIXME: make this readable) */
+        cp_vchar_t pre, post;
+        cp_syn_format_loc(&pre, &post, r, r->err.loc, r->err.loc2);
+
+        if (r->err.msg.size == 0) {
+            cp_vchar_printf(&r->err.msg, "Unknown failure.\n");
+        }
+        if (r->err.msg.data[r->err.msg.size-1] != '\n') {
+            cp_vchar_push(&r->err.msg, '\n');
+        }
+        fprintf(stderr, "%sError: %s%s", pre.data, r->err.msg.data, post.data);
+    }
+
+    return close_out(opt, atomic, ok);
+}
+
+typedef CP_VEC_T(cp_vchar_t) v_vchar_t;
+
+static void v_vchar_clear(
+    v_vchar_t *v)
+{
+    for (cp_v_each(i, v)) {
+        cp_vchar_fini(&cp_v_nth(v, i));
+    }
+    cp_v_clear(v, 0);
+}
+
+/**
+ * Add a file name to the list of watched files unless it is already there.
+ */
+static void name_add(
+    v_vchar_t *name,
+    char const *s)
+{
+    for (cp_v_each(i, name)) {
+        if (strequ(cp_v_nth(name, i).data, s)) {
+            return;
+        }
+    }
+    cp_vchar_printf(cp_v_push0(name), "%s", s);
+}
+
+typedef struct {
+    int wd;
+    char *base;
+} watch_file_t;
+
+typedef CP_VEC_T(watch_file_t) watch_v_file_t;
+
+/**
+ * Watched files: one inotify instance for the whole watch mode, so
+ * that changes during a run are queued and noticed afterwards.
+ */
+typedef struct {
+    int fd;
+    watch_v_file_t file;
+} watch_t;
+
+static void watch_init(
+    watch_t *w)
+{
+    CP_ZERO(w);
+    w->fd = inotify_init1(IN_CLOEXEC);
+    if (w->fd < 0) {
+        fprintf(stderr, "Error: Unable to use inotify: %s\n", strerror(errno));
+        my_exit(1);
+    }
+}
+
+/**
+ * Set the list of watched files.
+ *
+ * The directories of the files are watched, not the files themselves,
+ * so that editors that save by renaming a new file are noticed.
+ * Directories that are not needed anymore stay watched: their events
+ * are ignored.
+ */
+static void watch_set(
+    watch_t *w,
+    v_vchar_t const *name)
+{
+    for (cp_v_each(i, &w->file)) {
+        free(cp_v_nth(&w->file, i).base);
+    }
+    cp_v_clear(&w->file, 0);
+
+    for (cp_v_each(i, name)) {
+        char *d = strdup(cp_v_nth(name, i).data);
+        char *b = strdup(cp_v_nth(name, i).data);
+        int wd = inotify_add_watch(w->fd, dirname(d), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0) {
+            fprintf(stderr, "Warning: Unable to watch '%s': %s\n",
+                cp_v_nth(name, i).data, strerror(errno));
+        }
+        else {
+            cp_v_push(&w->file, ((watch_file_t){ .wd = wd, .base = strdup(basename(b)) }));
+        }
+        free(d);
+        free(b);
+    }
+}
+
+/**
+ * Wait until one of the watched files is written or replaced.
+ *
+ * Events that were queued since the last call, e.g., during a run, are
+ * processed first, so a save during a run triggers the next run at
+ * once.  Changes that come in quick succession are waited for, so
+ * that a save that writes several files triggers only one run.
+ */
+static void watch_wait(
+    watch_t *w)
+{
+    bool changed = false;
+    for (;;) {
+        struct pollfd pfd = { .fd = w->fd, .events = POLLIN };
+        int n = poll(&pfd, 1, changed ? 100 : -1);
+        if ((n < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (n == 0) {
+            /* quiet period after a change */
+            break;
+        }
+
+        char buff[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t len = (n < 0) ? -1 : read(w->fd, buff, sizeof(buff));
+        if ((len < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (len <= 0) {
+            /* without events, watching would become a busy loop */
+            fprintf(stderr, "Error: Unable to wait for changes: %s\n",
+                strerror(len < 0 ? errno : EIO));
+            my_exit(1);
+        }
+        for (char *p = buff; p < (buff + len);) {
+            struct inotify_event const *e = (struct inotify_event const *)p;
+            p += sizeof(*e) + e->len;
+            if (e->len == 0) {
+                continue;
+            }
+            for (cp_v_each(i, &w->file)) {
+                watch_file_t const *f = &cp_v_nth(&w->file, i);
+                if ((f->wd == e->wd) && strequ(f->base, e->name)) {
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Watch mode: process the input file, then wait for a change of the
+ * input file or of any file it uses or includes, then process it
+ * again, forever.
+ *
+ * Each run is done in a child process, so that no memory of a run
+ * needs to be freed explicitly and a failing run does not end the
+ * watch.  The layers computed by the child are passed back via the
+ * log of the layer cache and are kept in memory, so that the next
+ * run only computes the layers that are touched by the change.
+ */
+__attribute__((noreturn))
+static void watch(
+    cp_opt_t *opt,
+    char const *in_file_name)
+{
+    v_vchar_t name = {0};
+    name_add(&name, in_file_name);
+
+    /* watch before the first run: a change during a run must be noticed */
+    watch_t w;
+    watch_init(&w);
+    watch_set(&w, &name);
+
+    for (;;) {
+        int log_fd[2], name_fd[2];
+        if ((pipe(log_fd) != 0) || (pipe(name_fd) != 0)) {
+            fprintf(stderr, "Error: Unable to create pipe: %s\n", strerror(errno));
+            my_exit(1);
+        }
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if (pid < 0) {
+            fprintf(stderr, "Error: Unable to fork: %s\n", strerror(errno));
+            my_exit(1);
+        }
+        if (pid == 0) {
+            close(log_fd[0]);
+            close(name_fd[0]);
+            opt->cache->log = fdopen(log_fd[1], "wb");
+            cp_syn_tree_t *r = CP_NEW(*r);
+            bool ok = run_file(opt, r, in_file_name, true);
+            fclose(opt->cache->log);
+
+            /* the file names are sent only after the log is closed:
+             * the parent reads the log to its end first */
+            FILE *f = fdopen(name_fd[1], "wt");
+            for (cp_v_each(i, &r->file)) {
+                fprintf(f, "%s\n", cp_v_nth(&r->file, i)->filename.data);
+            }
+            fclose(f);
+            my_exit(ok ? 0 : 1);
+        }
+
+        close(log_fd[1]);
+        close(name_fd[1]);
+        FILE *f = fdopen(log_fd[0], "rb");
+        (void)cp_csg2_cache_read_log(opt->cache, f);
+        fclose(f);
+
+        v_vchar_t new_name = {0};
+        f = fdopen(name_fd[0], "rt");
+        char *line = NULL;
+        size_t line_size = 0;
+        ssize_t len;
+        while ((len = getline(&line, &line_size, f)) > 0) {
+            if (line[len-1] == '\n') {
+                line[len-1] = '\0';
+            }
+            cp_vchar_printf(cp_v_push0(&new_name), "%s", line);
+        }
+        free(line);
+        fclose(f);
+
+        int status;
+        while ((waitpid(pid, &status, 0) < 0) && (errno == EINTR)) {}
+        bool ok = WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+
+        if (ok) {
+            /* forget layers and files that the current model does not use */
+            cp_csg2_cache_sweep(opt->cache);
+            v_vchar_clear(&name);
+            name_add(&name, in_file_name);
+        }
+        /* After an error, the old files are still watched, because the
+         * child may have stopped before reading all of them. */
+        for (cp_v_each(i, &new_name)) {
+            name_add(&name, cp_v_nth(&new_name, i).data);
+        }
+        v_vchar_clear(&new_name);
+        cp_v_fini(&new_name);
+
+        if (opt->verbose >= 1) {
+            fprintf(stderr, "Info: Watching %"_Pz"u file%s for changes.\n",
+                name.size, name.size == 1 ? "" : "s");
+        }
+        watch_set(&w, &name);
+        watch_wait(&w);
+    }
+}
+
+/**
+ * Expand an output file name pattern for a given input file.
+ *
+ * '%n' is replaced by the base name of the input file without its
+ * suffix, '%%' is replaced by '%'.  Any other use of '%' is an error.
+ */
+static void out_name_expand(
+    cp_vchar_t *fn,
+    char const *pattern,
+    char const *in_file_name)
+{
+    for (char const *p = pattern; *p != '\0'; p++) {
+        if (*p != '%') {
+            cp_vchar_push(fn, *p);
+            continue;
+        }
+        p++;
+        switch (*p) {
+        case '%':
+            cp_vchar_push(fn, '%');
+            break;
+
+        case 'n': {
+            char const *base = strrchr(in_file_name, '/');
+            base = (base == NULL) ? in_file_name : base + 1;
+            char const *dot = strrchr(base, '.');
+            size_t len = (dot == NULL) || (dot == base) ? strlen(base) : (size_t)(dot - base);
+            cp_vchar_append_arr(fn, base, len);
+            break;}
+
+        default:
+            fprintf(stderr, "Error: Unrecognised '%%' sequence in output file name: '%s'\n",
+                pattern);
+            my_exit(1);
+        }
+    }
+}
+
+/**
+ * Set the output file names for the given input file by expanding
+ * their patterns.
+ */
+static void out_set_name(
+    cp_opt_t *opt,
+    char const *in_file_name)
+{
+    for (cp_v_each(i, &opt->out)) {
+        cp_out_t *o = &cp_v_nth(&opt->out, i);
+        if ((o->file_name != NULL) && (strchr(o->file_name, '%') != NULL)) {
+            cp_vchar_t fn;
+            cp_vchar_init(&fn);
+            out_name_expand(&fn, o->file_name, in_file_name);
+            o->file_name = fn.data;
+        }
+    }
+}
+
+/**
+ * Expand an output file name pattern for an input file and fail if the
+ * result is already in the list of used names, e.g., because two input
+ * files in different directories have the same base name.
+ */
+static void out_name_unique(
+    v_vchar_t *used,
+    char const *pattern,
+    char const *in_file_name)
+{
+    cp_vchar_t fn;
+    cp_vchar_init(&fn);
+    out_name_expand(&fn, pattern, in_file_name);
+    for (cp_v_each(i, used)) {
+        if (strequ(cp_v_nth(used, i).data, fn.data)) {
+            fprintf(stderr, "Error: Output file '%s' would be written more than once, "
+                "again for '%s'.\n", fn.data, in_file_name);
+            my_exit(1);
+        }
+    }
+    cp_v_push(used, fn);
+}
+
+typedef struct {
+    char const *file_name;
+    off_t size;
+    pid_t pid;
+} batch_file_t;
+
+typedef CP_VEC_T(batch_file_t) batch_v_file_t;
+
+static int batch_cmp_size(
+    batch_file_t const *a,
+    batch_file_t const *b,
+    void *user __unused)
+{
+    return (a->size > b->size) ? -1 : (a->size < b->size) ? +1 : 0;
+}
+
+/**
+ * Wait for one job of a batch to finish and report its failure.
+ *
+ * Returns whether the job succeeded.
+ */
+static bool batch_wait(
+    batch_v_file_t *file)
+{
+    int status;
+    pid_t pid;
+    while (((pid = wait(&status)) < 0) && (errno == EINTR)) {}
+    assert(pid > 0);
+    for (cp_v_each(i, file)) {
+        batch_file_t const *f = &cp_v_nth(file, i);
+        if (f->pid != pid) {
+            continue;
+        }
+        if (WIFSIGNALED(status)) {
+            fprintf(stderr, "Error: '%s': Crashed with signal %d.\n",
+                f->file_name, WTERMSIG(status));
+            return false;
+        }
+        if (WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "Error: '%s': Failed.\n", f->file_name);
+            return false;
+        }
+        return true;
+    }
+    CP_DIE("unknown child process");
+}
 
-    if (strequ(str, "ign") ||
-        strequ(str, "ignore"))
-    {
-        *v = CP_ERR_IGNORE;
-        return;
+/**
+ * Process multiple input files, each in a child process, at most
+ * opt->jobs at a time.  The largest files are started first, so that
+ * a large file started last does not delay the end of the batch.
+ *
+ * A failing file does not stop the batch.  Exits with status 1 if any
+ * file failed.
+ */
+__attribute__((noreturn))
+static void batch(
+    cp_opt_t *opt,
+    cp_v_cstr_t const *in_file)
+{
+    batch_v_file_t file = {0};
+    for (cp_v_each(i, in_file)) {
+        batch_file_t *f = cp_v_push0(&file);
+        f->file_name = cp_v_nth(in_file, i);
+        struct stat st;
+        if (stat(f->file_name, &st) == 0) {
+            f->size = st.st_size;
+        }
     }
+    cp_v_qsort(&file, 0, CP_SIZE_MAX, batch_cmp_size, NULL);
 
-    if (strequ(str, "warn") ||
-        strequ(str, "warning"))
-    {
-        *v = CP_ERR_WARN;
-        return;
+    size_t running = 0;
+    size_t fail_cnt = 0;
+    for (cp_v_each(i, &file)) {
+        batch_file_t *f = &cp_v_nth(&file, i);
+        if (running >= opt->jobs) {
+            fail_cnt += !batch_wait(&file);
+            running--;
+        }
+        fflush(stdout);
+        fflush(stderr);
+        f->pid = fork();
+        if (f->pid < 0) {
+            fprintf(stderr, "Error: Unable to fork: %s\n", strerror(errno));
+            my_exit(1);
+        }
+        if (f->pid == 0) {
+            out_set_name(opt, f->file_name);
+            cp_syn_tree_t *r = CP_NEW(*r);
+            my_exit(run_file(opt, r, f->file_name, false) ? 0 : 1);
+        }
+        running++;
+    }
+    while (running > 0) {
+        fail_cnt += !batch_wait(&file);
+        running--;
     }
 
-    fprintf(stderr, "Error: %s: invalid problem handling: '%s', expected 'error' or 'ignore'\n",
-        arg, str);
-    my_exit(1);
+    if (fail_cnt > 0) {
+        fprintf(stderr, "Error: %"_Pz"u of %"_Pz"u files failed.\n", fail_cnt, file.size);
+        my_exit(1);
+    }
+    my_exit(0);
 }
 
-static void get_arg_neg_bool(
-    bool *v,
-    char const *arg,
-    char const *str)
+/**
+ * Protocol of --serve and --client:
+ *
+ * The client connects and sends a 32-bit length in host byte order,
+ * together with its stdin, stdout, and stderr file descriptors as
+ * SCM_RIGHTS.  Then it sends that many bytes: its current directory
+ * and its command line arguments, each terminated by a 0 byte.
+ *
+ * The server runs the job in a child process with the client's
+ * directory and file descriptors, and then sends the exit status as a
+ * 32-bit integer.  If the job crashes, the connection is closed
+ * without a status.
+ *
+ * Only the user running the server can connect: the socket has mode
+ * 0600, and connections from other users are rejected.
+ */
+#define SERVE_MAX_REQUEST (1024 * 1024)
+
+static void serve_addr(
+    struct sockaddr_un *a,
+    char const *path)
 {
-    bool x = false;
-    get_arg_bool(&x, arg, str);
-    *v = !x;
+    CP_ZERO(a);
+    a->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(a->sun_path)) {
+        fprintf(stderr, "Error: Socket path too long: '%s'\n", path);
+        my_exit(1);
+    }
+    strcpy(a->sun_path, path);
 }
 
-#define get_arg_angle get_arg_dim
-#define get_arg_scale get_arg_dim
-
-static void get_arg_dim(
-    cp_dim_t *v,
-    char const *arg,
-    char const *str)
+static bool read_all(
+    int fd,
+    void *data,
+    size_t size)
 {
-    char *r = NULL;
-    *v = strtod(str, &r);
-    if ((str == r) || (*r != '\0')) {
-        fprintf(stderr, "Error: %s: invalid number: '%s'\n", arg, str);
-        my_exit(1);
+    char *p = data;
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if ((n < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= (size_t)n;
     }
+    return true;
 }
 
-static void get_arg_size(
-    size_t *v,
-    char const *arg,
-    char const *str)
+static bool write_all(
+    int fd,
+    void const *data,
+    size_t size)
 {
-    char *r = NULL;
-    unsigned long long val = strtoull(str, &r, 10);
-    if ((str == r) || (*r != '\0')) {
-        fprintf(stderr, "Error: %s: invalid number: '%s'\n", arg, str);
-        my_exit(1);
+    char const *p = data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if ((n < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= (size_t)n;
     }
-    *v = val & CP_MAX_OF(*v);
+    return true;
 }
 
-static void get_arg_uint8(
-    unsigned char *v,
-    char const *arg,
-    char const *str)
+static int cli_main(int argc, char **argv);
+
+/**
+ * Run one job of --serve mode in a child process: receive the request
+ * from connection c, then run it like a command line.
+ */
+__attribute__((noreturn))
+static void serve_job(
+    int c)
 {
-    size_t v2;
-    get_arg_size(&v2, arg, str);
-    if (v2 > 255) {
-        fprintf(stderr, "Error %s: invalid color value: %s expected 0..255\n", arg, str);
+    uint32_t len = 0;
+    int fd[3] = { -1, -1, -1 };
+    union {
+        char buff[CMSG_SPACE(sizeof(fd))];
+        struct cmsghdr align;
+    } ctrl;
+    struct iovec iov = { .iov_base = &len, .iov_len = sizeof(len) };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = ctrl.buff,
+        .msg_controllen = sizeof(ctrl.buff),
+    };
+    if (recvmsg(c, &msg, MSG_CMSG_CLOEXEC) != sizeof(len)) {
+        _exit(1);
+    }
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+    if ((cm == NULL) ||
+        (cm->cmsg_level != SOL_SOCKET) ||
+        (cm->cmsg_type != SCM_RIGHTS) ||
+        (cm->cmsg_len != CMSG_LEN(sizeof(fd))) ||
+        (len == 0) ||
+        (len > SERVE_MAX_REQUEST))
+    {
+        _exit(1);
+    }
+    memcpy(fd, CMSG_DATA(cm), sizeof(fd));
+
+    char *data = CP_NEW_ARR(*data, len + 1);
+    if (!read_all(c, data, len) || (data[len-1] != '\0')) {
+        _exit(1);
+    }
+
+    for (cp_size_each(i, 3)) {
+        if (dup2(fd[i], (int)i) < 0) {
+            _exit(1);
+        }
+        close(fd[i]);
+    }
+    serve_conn = c;
+
+    /* split into directory and arguments */
+    char const *dir = data;
+    char *end = data + len;
+    char *p = data + strlen(data) + 1;
+    size_t argc = 0;
+    char **argv = CP_NEW_ARR(*argv, len + 1);
+    while (p < end) {
+        argv[argc++] = p;
+        p += strlen(p) + 1;
+    }
+    if (argc == 0) {
+        fprintf(stderr, "Error: Empty request.\n");
         my_exit(1);
     }
-    *v = v2 & 0xff;
+    if (chdir(dir) != 0) {
+        fprintf(stderr, "Error: Unable to change to directory '%s': %s\n",
+            dir, strerror(errno));
+        my_exit(1);
+    }
+    my_exit(cli_main((int)argc, argv));
 }
 
-static void get_arg_rgb(
-    cp_color_rgb_t *v,
-    char const *arg,
-    char const *str)
+/**
+ * --serve mode: wait for jobs on the given Unix socket and run each
+ * job in a child process, at most jobs at a time.
+ *
+ * The child processes start from the initialised state of this
+ * process, so start-up of the program is paid once.
+ */
+__attribute__((noreturn))
+static void serve(
+    char const *path,
+    size_t jobs)
 {
-    char *r = NULL;
-    unsigned long w = strtoul(str, &r, 16);
-    if ((str == r) || (*r != '\0')) {
-        fprintf(stderr, "Error: %s: invalid rgb color: '%s'\n", arg, str);
+    struct sockaddr_un a;
+    serve_addr(&a, path);
+
+    /* remove a stale socket, but no other kind of file */
+    struct stat st;
+    if ((lstat(path, &st) == 0) && S_ISSOCK(st.st_mode)) {
+        (void)unlink(path);
+    }
+
+    /* only this user may connect: the socket is created with mode 0600 */
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    mode_t mask = umask(0177);
+    bool ok = (fd >= 0) && (bind(fd, (struct sockaddr *)&a, sizeof(a)) == 0);
+    umask(mask);
+    if (!ok || (listen(fd, 64) != 0)) {
+        fprintf(stderr, "Error: Unable to listen on '%s': %s\n", path, strerror(errno));
         my_exit(1);
     }
 
-    v->r = (w >> 16) & 0xff;
-    v->g = (w >> 8)  & 0xff;
-    v->b = (w >> 0)  & 0xff;
-}
+    /* clients that go away must not kill the server */
+    signal(SIGPIPE, SIG_IGN);
 
-typedef struct {
-    char const *name;
-    void (*func)(cp_opt_t *, char const *, char const *);
-    unsigned need_arg;
-} cp_get_opt_t;
+    size_t running = 0;
+    for (;;) {
+        /* reap finished jobs, and wait for one if all workers are busy */
+        for (;;) {
+            int status;
+            pid_t pid = waitpid(-1, &status, (running >= jobs) ? 0 : WNOHANG);
+            if ((pid < 0) && (errno == EINTR)) {
+                continue;
+            }
+            if (pid <= 0) {
+                break;
+            }
+            running--;
+        }
 
-#include "opt.inc"
+        int c = accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+        if (c < 0) {
+            if ((errno != EINTR) && (errno != ECONNABORTED)) {
+                fprintf(stderr, "Warning: accept failed: %s\n", strerror(errno));
+            }
+            continue;
+        }
 
-typedef struct {
-    char const *s;
-    size_t n;
-} cp_string_n_t;
+        /* the mode of the socket may have been changed: check the peer, too */
+        struct ucred cred;
+        socklen_t cred_size = sizeof(cred);
+        if ((getsockopt(c, SOL_SOCKET, SO_PEERCRED, &cred, &cred_size) != 0) ||
+            (cred.uid != getuid()))
+        {
+            fprintf(stderr, "Warning: Rejected connection from another user.\n");
+            close(c);
+            continue;
+        }
 
-static int opt_cmp(void const *_a, void const *_b)
-{
-    cp_string_n_t const *a = _a;
-    cp_get_opt_t const *b = _b;
-    int i = strncmp(a->s, b->name, a->n);
-    if (i != 0) {
-        return i;
-    }
-    if (b->name[a->n] != '\0') {
-        return -1;
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if (pid < 0) {
+            fprintf(stderr, "Warning: Unable to fork: %s\n", strerror(errno));
+        }
+        else if (pid == 0) {
+            close(fd);
+            signal(SIGPIPE, SIG_DFL);
+            serve_job(c);
+        }
+        else {
+            running++;
+        }
+        close(c);
     }
-    return 0;
 }
 
-static void parse_opt(
-    cp_opt_t *opt,
-    int *i,
+/**
+ * --client mode: run a command line by a --serve process.
+ */
+__attribute__((noreturn))
+static void client(
+    char const *path,
     int argc,
     char **argv)
 {
-    char const *argvi = argv[*i];
-
-    cp_string_n_t key = { .s = argvi };
-    while (*key.s == '-') {
-        key.s++;
+    cp_vchar_t data;
+    cp_vchar_init(&data);
+    char *cwd = getcwd(NULL, 0);
+    if (cwd == NULL) {
+        fprintf(stderr, "Error: Unable to get current directory: %s\n", strerror(errno));
+        exit(1);
     }
-    key.n = strlen(key.s);
-    char const *eq = strchr(key.s, '=');
-    if (eq != NULL) {
-        key.n = CP_PTRDIFF(eq, key.s);
+    cp_vchar_append_arr(&data, cwd, strlen(cwd) + 1);
+    free(cwd);
+    for (int i = 0; i < argc; i++) {
+        cp_vchar_append_arr(&data, argv[i], strlen(argv[i]) + 1);
     }
-
-    cp_get_opt_t *g =
-        bsearch(&key, opt_list, cp_countof(opt_list), sizeof(opt_list[0]), opt_cmp);
-    if (g == NULL) {
-        fprintf(stderr, "Error: Unrecognised option: '%s'\n", argvi);
-        my_exit(1);
+    if (data.size > SERVE_MAX_REQUEST) {
+        fprintf(stderr, "Error: Command line too long.\n");
+        exit(1);
     }
 
-    char const *arg = NULL;
-    if (g->need_arg > 0) {
-        if (key.s[key.n] == '=') {
-            arg = key.s + key.n + 1;
-        }
-        else
-        if (g->need_arg == 2) {
-            if ((*i + 1) >= argc) {
-                fprintf(stderr, "Error: Expected argument for '%s'\n", argvi);
-                my_exit(1);
-            }
-            arg = argv[++*i];
-        }
+    struct sockaddr_un a;
+    serve_addr(&a, path);
+    int c = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if ((c < 0) || (connect(c, (struct sockaddr *)&a, sizeof(a)) != 0)) {
+        fprintf(stderr, "Error: Unable to connect to '%s': %s\n", path, strerror(errno));
+        exit(1);
     }
 
-    g->func(opt, argvi, arg);
+    uint32_t len = (uint32_t)data.size;
+    int fd[3] = { 0, 1, 2 };
+    union {
+        char buff[CMSG_SPACE(sizeof(fd))];
+        struct cmsghdr align;
+    } ctrl;
+    CP_ZERO(&ctrl);
+    struct iovec iov = { .iov_base = &len, .iov_len = sizeof(len) };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = ctrl.buff,
+        .msg_controllen = sizeof(ctrl.buff),
+    };
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(fd));
+    memcpy(CMSG_DATA(cm), fd, sizeof(fd));
+
+    int32_t status;
+    if ((sendmsg(c, &msg, 0) != sizeof(len)) ||
+        !write_all(c, data.data, data.size))
+    {
+        fprintf(stderr, "Error: Unable to send job to '%s': %s\n", path, strerror(errno));
+        exit(1);
+    }
+    if (!read_all(c, &status, sizeof(status))) {
+        fprintf(stderr, "Error: Job failed without status.\n");
+        exit(1);
+    }
+    exit(status);
 }
 
-static bool has_suffix(
-    char const *haystack,
-    char const *needle)
+int main(int argc, char **argv)
 {
-    size_t len1 = strlen(haystack);
-    size_t len2 = strlen(needle);
-    if (len1 < len2) {
-        return false;
+    if ((argc >= 2) && (strncmp(argv[1], "--client=", 9) == 0)) {
+        /* pass our program name, then the rest of the command line */
+        char const *path = argv[1] + 9;
+        argv[1] = argv[0];
+        client(path, argc - 1, argv + 1);
     }
-    return strequ(haystack + len1 - len2, needle);
+#ifdef CP_ALLOC_STATS
+    atexit(cp_alloc_print);
+#endif
+    return cli_main(argc, argv);
 }
 
-int main(int argc, char **argv)
+static int cli_main(int argc, char **argv)
 {
     /* init options */
     cp_opt_t opt = {0};
@@ -533,22 +2768,66 @@ int main(int argc, char **argv)
     opt.csg.optimise = CP_CSG2_OPT_DEFAULT;
     opt.csg.color_rand = 0;
     opt.verbose = 1;
+    opt.layer_stats_top = 10;
+    opt.profile_source_top = 20;
 
     /* parse command line */
-    char const *in_file_name = NULL;
+    cp_v_cstr_t in_file = {0};
     for (int i = 1; i < argc; i++) {
-        if (argv[i][0] == '-') {
+        if ((argv[i][0] == '-') && (argv[i][1] != '\0')) {
             parse_opt(&opt, &i, argc, argv);
         }
-        else
-        if (in_file_name == NULL) {
-            in_file_name = argv[i];
-        }
         else {
-            fprintf(stderr, "Error: Multiple input files cannot be processed: '%s'\n",
-                argv[i]);
-            my_exit(1);
+            cp_v_push(&in_file, argv[i]);
+        }
+    }
+
+    if (opt.jobs == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        opt.jobs = (n > 0) ? (size_t)n : 1;
+    }
+
+    if (opt.serve != NULL) {
+        /* jobs start from the state of the server, so it must be pristine */
+        for (int i = 1; i < argc; i++) {
+            if (strequ(argv[i], "-j") || strequ(argv[i], "--jobs") ||
+                strequ(argv[i], "--serve"))
+            {
+                /* skip the argument */
+                i++;
+                continue;
+            }
+            if ((strncmp(argv[i], "--serve=", 8) != 0) &&
+                (strncmp(argv[i], "--jobs=", 7) != 0))
+            {
+                fprintf(stderr, "Error: --serve cannot be used with '%s'\n", argv[i]);
+                my_exit(1);
+            }
         }
+        serve(opt.serve, opt.jobs);
+    }
+
+    if (in_file.size == 0) {
+        fprintf(stderr, "Error: No input file given.  Try --help.\n");
+        my_exit(1);
+    }
+
+    if ((opt.z_list.size > 0) && (opt.have_z_min || opt.have_z_max)) {
+        fprintf(stderr, "Error: --z-list cannot be used with --min, --max, or --z.\n");
+        my_exit(1);
+    }
+
+    if (opt.csg.progress != NULL) {
+        /* cancel cleanly on the first signal, terminate on the second */
+        opt.progress.func = progress_print;
+        sig_progress = &opt.progress;
+        struct sigaction sa = {
+            .sa_handler = sig_cancel,
+            .sa_flags = (int)SA_RESETHAND,
+        };
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
     }
 
     /* post-process options */
@@ -579,72 +2858,123 @@ int main(int argc, char **argv)
     cp_debug_ps_xform.add_y += (cp_debug_ps_xlat_y * cp_debug_ps_xform.mul_y);
 #endif
 
-    /* output file: */
-    cp_stream_t *sout = CP_STREAM_FROM_FILE(stdout);
-    FILE *fout = NULL;
-    if (opt.out_file_name) {
-        fout = fopen(opt.out_file_name, "wt");
-        if (fout == NULL) {
-            fprintf(stderr, "Error: Unable to open '%s' for writing: %s\n",
-                opt.out_file_name, strerror(errno));
+    /* output files: */
+    if (opt.out.size == 0) {
+        cp_v_push(&opt.out, ((cp_out_t){ .file_name = NULL }));
+    }
+    if (opt.have_dump) {
+        if (opt.out.size > 1) {
+            fprintf(stderr, "Error: --dump-... cannot be used with multiple outputs.\n");
             my_exit(1);
         }
-        sout = CP_STREAM_FROM_FILE(fout);
-
-        if (!opt.have_dump) {
-            if (has_suffix(opt.out_file_name, ".stl")) {
-                opt.dump_stl = true;
+        cp_out_t *o = &cp_v_nth(&opt.out, 0);
+        o->format =
+            opt.dump_csg2 ? OUT_CSG2 :
+            opt.dump_stl  ? OUT_STL :
+            opt.dump_js   ? OUT_JS :
+            opt.dump_ps   ? OUT_PS :
+            OUT_NONE;
+    }
+    else {
+        for (cp_v_each(i, &opt.out)) {
+            cp_out_t *o = &cp_v_nth(&opt.out, i);
+            if (o->file_name == NULL) {
+                continue;
             }
-            else if (has_suffix(opt.out_file_name, ".js")) {
-                opt.dump_js = true;
+            if (has_suffix(o->file_name, ".stl")) {
+                o->format = OUT_STL;
+            }
+            else if (has_suffix(o->file_name, ".js")) {
+                o->format = OUT_JS;
             }
             else if (
-                has_suffix(opt.out_file_name, ".scad") ||
-                has_suffix(opt.out_file_name, ".csg"))
+                has_suffix(o->file_name, ".scad") ||
+                has_suffix(o->file_name, ".csg"))
             {
-                opt.dump_csg2 = true;
+                o->format = OUT_CSG2;
+            }
+            else if (has_suffix(o->file_name, ".ps")) {
+                o->format = OUT_PS;
             }
-            else if (has_suffix(opt.out_file_name, ".ps")) {
-                opt.dump_ps = true;
+            else if (has_suffix(o->file_name, ".hob3lc")) {
+                o->format = OUT_CACHE;
             }
             else {
                 fprintf(stderr, "Error: Unrecognised file ending: '%s'.  Use --dump-...\n",
-                    opt.out_file_name);
+                    o->file_name);
                 my_exit(1);
             }
         }
     }
-
-    /* process files */
-    FILE *fin = fopen(in_file_name, "rt");
-    if (fin == NULL) {
-        fprintf(stderr, "Error: Unable to open '%s' for reading: %s\n",
-            in_file_name, strerror(errno));
-        my_exit(1);
+    for (cp_v_each(i, &opt.out)) {
+        cp_out_t const *o = &cp_v_nth(&opt.out, i);
+        if (o->file_name != NULL) {
+            /* check the pattern */
+            cp_vchar_t fn;
+            cp_vchar_init(&fn);
+            out_name_expand(&fn, o->file_name, "");
+            cp_vchar_fini(&fn);
+        }
+    }
+    if (in_file.size > 1) {
+        for (cp_v_each(i, &opt.out)) {
+            cp_out_t const *o = &cp_v_nth(&opt.out, i);
+            if ((o->file_name == NULL) || (strstr(o->file_name, "%n") == NULL)) {
+                fprintf(stderr, "Error: With multiple input files, each output file name "
+                    "must contain '%%n'.\n");
+                my_exit(1);
+            }
+        }
+        if (opt.watch) {
+            fprintf(stderr, "Error: --watch can only be used with a single input file.\n");
+            my_exit(1);
+        }
+    }
+    {
+        /* each output file must be written only once */
+        v_vchar_t used = {0};
+        for (cp_v_each(i, &in_file)) {
+            char const *in_file_name = cp_v_nth(&in_file, i);
+            for (cp_v_each(j, &opt.out)) {
+                char const *name = cp_v_nth(&opt.out, j).file_name;
+                if (name != NULL) {
+                    out_name_unique(&used, name, in_file_name);
+                }
+            }
+            if (opt.layer_stats != NULL) {
+                out_name_unique(&used, opt.layer_stats, in_file_name);
+            }
+            if (opt.trace_name != NULL) {
+                out_name_unique(&used, opt.trace_name, in_file_name);
+            }
+        }
+        v_vchar_clear(&used);
+        cp_v_fini(&used);
     }
 
-    cp_syn_tree_t *r = CP_NEW(*r);
-    bool ok = do_file(sout, &opt, r, in_file_name, fin);
-    fclose(fin);
+    /* layer cache */
+    cp_csg2_cache_t cache;
+    if ((opt.cache_dir != NULL) || opt.watch) {
+        cp_err_t err = {0};
+        if (!cp_csg2_cache_init(&cache, &err, opt.cache_dir, opt.watch)) {
+            fprintf(stderr, "Error: %s", err.msg.data);
+            my_exit(1);
+        }
+        opt.cache = &cache;
+    }
 
-    if (fout != NULL) {
-        fclose(fout);
+    if (in_file.size > 1) {
+        batch(&opt, &in_file);
     }
 
-    /* print error (FIXME: make this readable) */
-    if (!ok) {
-        cp_vchar_t pre, post;
-        cp_syn_format_loc(&pre, &post, r, r->err.loc, r->err.loc2);
+    char const *in_file_name = cp_v_nth(&in_file, 0);
+    out_set_name(&opt, in_file_name);
 
-        if (r->err.msg.size == 0) {
-            cp_vchar_printf(&r->err.msg, "Unknown failure.\n");
-        }
-        if (r->err.msg.data[r->err.msg.size-1] != '\n') {
-            cp_vchar_push(&r->err.msg, '\n');
-        }
-        fprintf(stderr, "%sError: %s%s", pre.data, r->err.msg.data, post.data);
-        my_exit(1);
+    if (opt.watch) {
+        watch(&opt, in_file_name);
     }
 
-    my_exit(0);
+    /* process files */
+    cp_syn_tree_t *r = CP_NEW(*r);
+    my_exit(run_file(&opt, r, in_file_name, false) ? 0 : 1);
 }
@@ -7,6 +7,7 @@
 #include <hob3lbase/alloc.h>
 #include <hob3lbase/pool.h>
 #include <hob3lbase/arith.h>
+#include "probe.h"
 
 /**
  * Align block to 4k pages
@@ -71,6 +72,8 @@ static void block_clear(
 extern void cp_pool_clear(
     cp_pool_t *a)
 {
+    a->used = 0;
+    a->elem = 0;
     if (a->cur != NULL) {
         block_clear(a->cur);
         for (cp_list_each(i, a->cur)) {
@@ -176,6 +179,16 @@ extern void *cp_pool_calloc(
         return NULL;
     }
 
+    cp_alloc_count(file, line, CP_ALLOC_POOL, nmemb * size);
+    pool->used += nmemb * size;
+    if (pool->used_max < pool->used) {
+        pool->used_max = pool->used;
+    }
+    pool->elem += nmemb;
+    if (pool->elem_max < pool->elem) {
+        pool->elem_max = pool->elem;
+    }
+
     if (pool->cur != NULL) {
         void *r = try_block_calloc(file, line, pool->cur, nmemb, size, align);
         if (r != NULL) {
@@ -193,6 +206,8 @@ extern void *cp_pool_calloc(
         cp_list_insert(b, pool->cur);
     }
     pool->cur = b;
+    pool->block_total += pool->block_size;
+    CP_PROBE2(pool_block, pool->block_size, pool->block_total);
 
     void *r = try_block_calloc(file, line, pool->cur, nmemb, size, align);
     assert(r != NULL);
@@ -0,0 +1,34 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/*
+ * Static tracepoints for perf, bpftrace, and SystemTap.
+ *
+ * With 'make USDT=1', these become USDT probes 'hob3l:NAME' from
+ * <sys/sdt.h>, which cost a single nop instruction while no tracer is
+ * attached.  Otherwise, they compile to nothing and the arguments are
+ * not evaluated.
+ */
+
+#ifndef __CP_SRC_PROBE_H
+#define __CP_SRC_PROBE_H
+
+#ifdef CP_USDT
+
+#include <sys/sdt.h>
+
+#define CP_PROBE0(name)          DTRACE_PROBE(hob3l, name)
+#define CP_PROBE1(name, a)       DTRACE_PROBE1(hob3l, name, a)
+#define CP_PROBE2(name, a, b)    DTRACE_PROBE2(hob3l, name, a, b)
+#define CP_PROBE3(name, a, b, c) DTRACE_PROBE3(hob3l, name, a, b, c)
+
+#else
+
+#define CP_PROBE0(name)          ((void)0)
+#define CP_PROBE1(name, a)       ((void)0)
+#define CP_PROBE2(name, a, b)    ((void)0)
+#define CP_PROBE3(name, a, b, c) ((void)0)
+
+#endif
+
+#endif /* __CP_SRC_PROBE_H */
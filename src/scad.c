@@ -1,6 +1,7 @@
 /* -*- Mode: C -*- */
 /* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
 
+#include <strings.h>
 #include <hob3lbase/vchar.h>
 #include <hob3lbase/mat.h>
 #include <hob3lbase/alloc.h>
@@ -8,12 +9,15 @@
 #include <hob3l/gc.h>
 #include <hob3l/scad.h>
 #include <hob3l/syn.h>
+#include <hob3l/stl.h>
 #include "internal.h"
 
 typedef struct {
     cp_scad_tree_t *top;
     cp_err_t *err;
     cp_syn_tree_t *syn;
+    /** stack of files currently being included, to detect recursion */
+    cp_v_syn_file_p_t include;
 } ctxt_t;
 
 typedef char const *val_t;
@@ -315,12 +319,11 @@ static bool _get_grey(
     return get_grey(r, t, v);
 }
 
-#if 0
 static bool try_get_str(
     char const **r,
     cp_syn_value_t const *v)
 {
-    cp_syn_value_string_t *a = cp_syn_try_cast(*a, v);
+    cp_syn_value_string_t const *a = cp_syn_try_cast(*a, v);
     if (a != NULL) {
         *r = a->value;
         return true;
@@ -348,7 +351,6 @@ static bool _get_str(
 {
     return get_str(r, t, v);
 }
-#endif /*0*/
 
 static bool try_get_size(
     size_t *r,
@@ -1008,6 +1010,72 @@ static bool polyhedron_from_item(
     return true;
 }
 
+/**
+ * Construct the name of a file referenced from within the file that
+ * contains loc: relative names are relative to that file's directory.
+ */
+static void file_name_rel(
+    cp_vchar_t *r,
+    ctxt_t *t,
+    cp_loc_t loc,
+    char const *name)
+{
+    cp_syn_loc_t sl;
+    if ((name[0] != '/') && cp_syn_get_loc(&sl, t->syn, loc)) {
+        char const *dir = sl.file->filename.data;
+        char const *sep = strrchr(dir, '/');
+        if (sep != NULL) {
+            cp_vchar_append_arr(r, dir, CP_PTRDIFF(sep, dir) + 1);
+        }
+    }
+    cp_vchar_printf(r, "%s", name);
+}
+
+static bool import_from_item(
+    ctxt_t *t,
+    cp_syn_stmt_item_t *f,
+    cp_scad_t *_r)
+{
+    cp_scad_polyhedron_t *r = cp_scad_cast(*r, _r);
+
+    char const *file = NULL;
+    cp_syn_value_t const *_convexity = NULL;
+    if (!GET_ARG(t, f->loc, &f->arg,
+        (
+            PARAM_STR ("file", &file, NULL),
+        ),
+        (
+            PARAM_RAW ("convexity", &_convexity, ((bool[]){false})),
+        )))
+    {
+        return false;
+    }
+
+    if (!has_suffix(file, ".stl")) {
+        cp_vchar_printf(&t->err->msg, "Only STL files can be imported.\n");
+        t->err->loc = f->loc;
+        return false;
+    }
+
+    cp_vchar_t fn;
+    cp_vchar_init(&fn);
+    file_name_rel(&fn, t, f->loc, file);
+
+    FILE *fi = fopen(fn.data, "rb");
+    if (fi == NULL) {
+        cp_vchar_printf(&t->err->msg, "Unable to open '%s' for reading: %s\n",
+            fn.data, strerror(errno));
+        t->err->loc = f->loc;
+        cp_vchar_fini(&fn);
+        return false;
+    }
+
+    bool ok = cp_stl_parse(t->syn, t->err, r, f->loc, fn.data, fi);
+    fclose(fi);
+    cp_vchar_fini(&fn);
+    return ok;
+}
+
 static bool polygon_from_item(
     ctxt_t *t,
     cp_syn_stmt_item_t *f,
@@ -1455,6 +1523,11 @@ static bool v_scad_from_syn_stmt_item(
            .type = CP_SCAD_UNION,
            .from = union_from_item
         },
+        {
+           .id = "import",
+           .type = CP_SCAD_POLYHEDRON,
+           .from = import_from_item
+        },
         {
            .id = "intersection",
            .type = CP_SCAD_INTERSECTION,
@@ -1557,12 +1630,56 @@ static bool v_scad_from_syn_stmt_item(
     return c->from(t, f, r);
 }
 
+static bool lib_from_path(
+    cp_syn_file_t **fp,
+    ctxt_t *t,
+    cp_loc_t loc,
+    char const *path)
+{
+    cp_vchar_t fn;
+    cp_vchar_init(&fn);
+    file_name_rel(&fn, t, loc, path);
+    bool ok = cp_syn_parse_lib(fp, t->syn, loc, fn.data);
+    cp_vchar_fini(&fn);
+    return ok;
+}
+
+/**
+ * 'use' imports only modules and functions, which are not supported,
+ * so the file is only parsed, but nothing is instantiated.
+ */
 static bool v_scad_from_syn_stmt_use(
-    ctxt_t *t __unused,
+    ctxt_t *t,
     cp_v_scad_p_t *result __unused,
-    cp_syn_stmt_use_t *f __unused)
+    cp_syn_stmt_use_t *f)
+{
+    cp_syn_file_t *lib;
+    return lib_from_path(&lib, t, f->loc, f->path);
+}
+
+static bool v_scad_from_syn_stmt_include(
+    ctxt_t *t,
+    cp_v_scad_p_t *result,
+    cp_syn_stmt_include_t *f)
 {
-    CP_NYI("use <...>");
+    cp_syn_file_t *lib;
+    if (!lib_from_path(&lib, t, f->loc, f->path)) {
+        return false;
+    }
+
+    for (cp_v_each(i, &t->include)) {
+        if (cp_v_nth(&t->include, i) == lib) {
+            cp_vchar_printf(&t->err->msg, "Recursive inclusion of '%s'.\n",
+                lib->filename.data);
+            t->err->loc = f->loc;
+            return false;
+        }
+    }
+
+    cp_v_push(&t->include, lib);
+    bool ok = v_scad_from_v_syn_stmt(t, result, &lib->toplevel);
+    cp_v_pop(&t->include);
+    return ok;
 }
 
 static bool v_scad_from_syn_stmt(
@@ -1575,6 +1692,9 @@ static bool v_scad_from_syn_stmt(
        return v_scad_from_syn_stmt_item(t, result, cp_syn_cast(cp_syn_stmt_item_t, f));
     case CP_SYN_STMT_USE:
        return v_scad_from_syn_stmt_use(t, result, cp_syn_cast(cp_syn_stmt_use_t, f));
+    case CP_SYN_STMT_INCLUDE:
+       return v_scad_from_syn_stmt_include(
+           t, result, cp_syn_cast(cp_syn_stmt_include_t, f));
     default:
        CP_NYI("type=0x%x", f->type);
     }
@@ -1622,5 +1742,107 @@ extern bool cp_scad_from_syn_tree(
         .top = result,
         .err = &syn->err,
     };
-    return v_scad_from_v_syn_stmt(&t, &result->toplevel, &syn->toplevel);
+    bool ok = v_scad_from_v_syn_stmt(&t, &result->toplevel, &syn->toplevel);
+    cp_v_fini(&t.include);
+    return ok;
+}
+
+static void v_scad_delete(
+    cp_v_scad_p_t *v)
+{
+    for (cp_v_each(i, v)) {
+        cp_scad_delete(cp_v_nth(v, i));
+    }
+    cp_v_fini(v);
+}
+
+/**
+ * Delete a SCAD object and all its children.
+ */
+extern void cp_scad_delete(
+    cp_scad_t *s)
+{
+    switch (s->type) {
+    case CP_SCAD_UNION:
+        v_scad_delete(&cp_scad_cast(cp_scad_union_t, s)->child);
+        break;
+
+    case CP_SCAD_DIFFERENCE:
+        v_scad_delete(&cp_scad_cast(cp_scad_difference_t, s)->child);
+        break;
+
+    case CP_SCAD_INTERSECTION:
+        v_scad_delete(&cp_scad_cast(cp_scad_intersection_t, s)->child);
+        break;
+
+    case CP_SCAD_MULTMATRIX:
+        v_scad_delete(&cp_scad_cast(cp_scad_multmatrix_t, s)->child);
+        break;
+
+    case CP_SCAD_TRANSLATE:
+        v_scad_delete(&cp_scad_cast(cp_scad_translate_t, s)->child);
+        break;
+
+    case CP_SCAD_MIRROR:
+        v_scad_delete(&cp_scad_cast(cp_scad_mirror_t, s)->child);
+        break;
+
+    case CP_SCAD_SCALE:
+        v_scad_delete(&cp_scad_cast(cp_scad_scale_t, s)->child);
+        break;
+
+    case CP_SCAD_ROTATE:
+        v_scad_delete(&cp_scad_cast(cp_scad_rotate_t, s)->child);
+        break;
+
+    case CP_SCAD_COLOR:
+        v_scad_delete(&cp_scad_cast(cp_scad_color_t, s)->child);
+        break;
+
+    case CP_SCAD_LINEXT:
+        v_scad_delete(&cp_scad_cast(cp_scad_linext_t, s)->child);
+        break;
+
+    case CP_SCAD_POLYHEDRON:{
+        cp_scad_polyhedron_t *o = cp_scad_cast(*o, s);
+        for (cp_v_each(i, &o->faces)) {
+            cp_v_fini(&cp_v_nth(&o->faces, i).points);
+        }
+        cp_v_fini(&o->faces);
+        cp_v_fini(&o->points);
+        break;}
+
+    case CP_SCAD_POLYGON:{
+        cp_scad_polygon_t *o = cp_scad_cast(*o, s);
+        for (cp_v_each(i, &o->paths)) {
+            cp_v_fini(&cp_v_nth(&o->paths, i).points);
+        }
+        cp_v_fini(&o->paths);
+        cp_v_fini(&o->points);
+        break;}
+
+    case CP_SCAD_SPHERE:
+    case CP_SCAD_CUBE:
+    case CP_SCAD_CYLINDER:
+    case CP_SCAD_CIRCLE:
+    case CP_SCAD_SQUARE:
+        break;
+
+    default:
+        CP_NYI("type=0x%x", s->type);
+    }
+    CP_FREE(s);
+}
+
+/**
+ * Delete all objects of a SCAD tree.  The tree itself is not freed.
+ */
+extern void cp_scad_tree_fini(
+    cp_scad_tree_t *t)
+{
+    for (cp_v_each(i, &t->toplevel)) {
+        cp_scad_delete(cp_v_nth(&t->toplevel, i));
+    }
+    cp_v_fini(&t->toplevel);
+    t->root = NULL;
 }
@@ -0,0 +1,165 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/*
+ * Test of the library API in hob3l/slicer.h, using only that header,
+ * like an application would.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <hob3l/slicer.h>
+#include "test.h"
+
+#define BUF(s) (s), strlen(s)
+
+static char const *cube = "cube([10,10,10]);";
+static char const *cube_hole =
+    "difference() { cube([10,10,4]); translate([2,2,-1]) cube([6,6,6]); }";
+static char const *stl_empty = "solid empty\nendsolid empty\n";
+
+/**
+ * Area of a layer: the paths are oriented so that holes count negative.
+ */
+static double area(
+    cp_slicer_layer_t const *l)
+{
+    double a = 0;
+    for (size_t i = 0; i < l->path_cnt; i++) {
+        size_t b = l->path_start[i];
+        size_t e = l->path_start[i+1];
+        for (size_t j = b; j < e; j++) {
+            double const *p = &l->point[2 * l->path_idx[j]];
+            double const *q = &l->point[2 * l->path_idx[(j + 1 < e) ? j + 1 : b]];
+            a += (p[0] * q[1]) - (q[0] * p[1]);
+        }
+    }
+    return (a < 0 ? -a : a) / 2;
+}
+
+static bool near(double a, double b)
+{
+    return ((a - b) < 1e-6) && ((b - a) < 1e-6);
+}
+
+/** Stage at which cancel_at() cancels */
+static unsigned cancel_stage;
+
+/** Progress callback that cancels the slicer at cancel_stage */
+static void cancel_at(
+    void *user,
+    unsigned stage,
+    size_t zi __attribute__((unused)),
+    size_t zi_cnt __attribute__((unused)))
+{
+    if (stage == cancel_stage) {
+        cp_slicer_set_cancel(user, true);
+    }
+}
+
+int main(void)
+{
+    cp_slicer_layer_t l;
+    TEST_EQ(cp_slicer_api_version(), CP_SLICER_API_VERSION);
+
+    cp_slicer_t *s = cp_slicer_new();
+    TEST_NE(s, NULL);
+    TEST_EQ(cp_slicer_error(s)[0], '\0');
+
+    /* load from memory, compute layers by index */
+    cp_slicer_set_step(s, 1);
+    TEST_EQ(cp_slicer_load_buffer(s, "cube.scad", BUF(cube)), true);
+    TEST_EQ(cp_slicer_layer_cnt(s), 10);
+    TEST_EQ(cp_slicer_get_layer(s, 0, &l), true);
+    TEST_EQ(near(l.z, 0.5), true);
+    TEST_EQ(l.path_cnt, 1);
+    TEST_EQ(l.path_start[1] - l.path_start[0], 4);
+    TEST_EQ(near(area(&l), 100), true);
+    TEST_EQ(l.triangle_cnt, 2);
+    TEST_EQ(cp_slicer_get_layer(s, 9, &l), true);
+    TEST_EQ(near(l.z, 9.5), true);
+    TEST_EQ(cp_slicer_get_layer(s, 10, &l), false);
+    TEST_NE(cp_slicer_error(s)[0], '\0');
+
+    /* compute layers at arbitrary z */
+    TEST_EQ(cp_slicer_get_layer_at(s, 3.25, &l), true);
+    TEST_EQ(near(l.z, 3.25), true);
+    TEST_EQ(near(area(&l), 100), true);
+    TEST_EQ(cp_slicer_get_layer_at(s, 20, &l), true);
+    TEST_EQ(l.path_cnt, 0);
+    TEST_EQ(l.triangle_cnt, 0);
+
+    /* reload a different model into the same slicer */
+    TEST_EQ(cp_slicer_load_buffer(s, "hole.scad", BUF(cube_hole)), true);
+    TEST_EQ(cp_slicer_layer_cnt(s), 4);
+    TEST_EQ(cp_slicer_get_layer_at(s, 1, &l), true);
+    TEST_EQ(l.path_cnt, 2);
+    TEST_EQ(near(area(&l), 100 - 36), true);
+
+    /* syntax errors are reported with the file name */
+    TEST_EQ(cp_slicer_load_buffer(s, "bad.scad", BUF("cube([1,1,1]")), false);
+    TEST_NE(strstr(cp_slicer_error(s), "bad.scad"), NULL);
+    TEST_NE(strstr(cp_slicer_error(s), "Error:"), NULL);
+    TEST_EQ(cp_slicer_layer_cnt(s), 0);
+
+    /* STL data is detected by the name */
+    TEST_EQ(cp_slicer_load_buffer(s, "empty.STL", BUF(stl_empty)), false);
+    TEST_NE(strstr(cp_slicer_error(s), "no triangles"), NULL);
+
+    /* missing files are reported */
+    TEST_EQ(cp_slicer_load_file(s, "scad-test/does-not-exist.scad"), false);
+    TEST_NE(cp_slicer_error(s)[0], '\0');
+
+    /* after an error, a new model can be loaded */
+    TEST_EQ(cp_slicer_load_buffer(s, "cube.scad", BUF(cube)), true);
+    TEST_EQ(cp_slicer_error(s)[0], '\0');
+    TEST_EQ(cp_slicer_layer_cnt(s), 10);
+    TEST_EQ(cp_slicer_get_layer(s, 5, &l), true);
+    TEST_EQ(near(area(&l), 100), true);
+
+    cp_slicer_delete(s);
+
+    /* xy window: empty rectangles are rejected, others clip */
+    s = cp_slicer_new();
+    cp_slicer_set_step(s, 1);
+    TEST_EQ(cp_slicer_set_xy_window(s, 0, 0, 0, 5), false);
+    TEST_NE(strstr(cp_slicer_error(s), "Empty xy window"), NULL);
+    TEST_EQ(cp_slicer_set_xy_window(s, 0, 5, 5, 0), false);
+    TEST_EQ(cp_slicer_set_xy_window(s, 0, 0, 5, 5), true);
+    TEST_EQ(cp_slicer_load_buffer(s, "cube.scad", BUF(cube)), true);
+    TEST_EQ(cp_slicer_get_layer(s, 0, &l), true);
+    TEST_EQ(near(area(&l), 25), true);
+    cp_slicer_delete(s);
+
+    /* cancel from the progress callback: nothing is returned */
+    s = cp_slicer_new();
+    cp_slicer_set_step(s, 1);
+    cp_slicer_set_progress(s, cancel_at, s);
+    cancel_stage = CP_SLICER_STAGE_READ;
+    TEST_EQ(cp_slicer_load_buffer(s, "cube.scad", BUF(cube)), false);
+    TEST_NE(strstr(cp_slicer_error(s), "Cancelled"), NULL);
+    TEST_EQ(cp_slicer_layer_cnt(s), 0);
+
+    cp_slicer_set_cancel(s, false);
+    cancel_stage = CP_SLICER_STAGE_SLICE;
+    TEST_EQ(cp_slicer_load_buffer(s, "cube.scad", BUF(cube)), true);
+    l.path_cnt = 12345;
+    l.triangle_cnt = 12345;
+    TEST_EQ(cp_slicer_get_layer(s, 0, &l), false);
+    TEST_NE(strstr(cp_slicer_error(s), "Cancelled"), NULL);
+    TEST_EQ(l.path_cnt, 12345);
+    TEST_EQ(l.triangle_cnt, 12345);
+    TEST_EQ(cp_slicer_get_layer_at(s, 3.25, &l), false);
+    TEST_EQ(l.path_cnt, 12345);
+
+    /* the flag stays set until it is cleared */
+    cp_slicer_set_progress(s, NULL, NULL);
+    TEST_EQ(cp_slicer_get_layer(s, 1, &l), false);
+    cp_slicer_set_cancel(s, false);
+    TEST_EQ(cp_slicer_get_layer(s, 1, &l), true);
+    TEST_EQ(near(area(&l), 100), true);
+    cp_slicer_delete(s);
+
+    fprintf(stderr, "TEST:OK\n");
+    return 0;
+}
@@ -0,0 +1,525 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+/* for fmemopen() */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <hob3lbase/arith.h>
+#include <hob3lbase/vec.h>
+#include <hob3lbase/mat.h>
+#include <hob3lbase/pool.h>
+#include <hob3lbase/alloc.h>
+#include <hob3lbase/vchar.h>
+#include <hob3l/syn.h>
+#include <hob3l/scad.h>
+#include <hob3l/stl.h>
+#include <hob3l/csg.h>
+#include <hob3l/csg3.h>
+#include <hob3l/csg2.h>
+#include <hob3l/slicer.h>
+#include "internal.h"
+
+struct cp_slicer {
+    cp_csg_opt_t csg;
+    cp_dim_t z_step;
+    cp_dim_t z_min;
+    cp_dim_t z_max;
+    bool have_range;
+    bool tri;
+    cp_vec2_minmax_t xy_window;
+
+    /** progress callback, and the cancellation flag used via csg.progress */
+    cp_slicer_progress_t progress_func;
+    void *progress_user;
+    cp_progress_t progress;
+
+    /** pool for temporary objects */
+    cp_pool_t pool;
+
+    /** the stages of the loaded model */
+    bool loaded;
+    cp_syn_tree_t syn;
+    cp_scad_tree_t scad;
+    cp_csg3_tree_t csg3;
+    cp_csg2_tree_t csg2;
+    cp_csg2_tree_t csg2b;
+
+    /** the current layer */
+    cp_v_double_t point;
+    cp_v_size_t path_start;
+    cp_v_size_t path_idx;
+    cp_v_size_t triangle;
+
+    /** message of the last error */
+    cp_vchar_t err;
+};
+
+/**
+ * Format the error of the syntax tree into s->err and clear it.
+ */
+static void set_error(
+    cp_slicer_t *s)
+{
+    cp_err_t *e = &s->syn.err;
+    cp_vchar_t pre, post;
+    cp_syn_format_loc(&pre, &post, &s->syn, e->loc, e->loc2);
+    if (e->msg.size == 0) {
+        cp_vchar_printf(&e->msg, "Unknown failure.\n");
+    }
+    if (e->msg.data[e->msg.size-1] != '\n') {
+        cp_vchar_push(&e->msg, '\n');
+    }
+    cp_vchar_clear(&s->err);
+    cp_vchar_printf(&s->err, "%sError: %s%s", pre.data, e->msg.data, post.data);
+    cp_vchar_fini(&pre);
+    cp_vchar_fini(&post);
+    cp_vchar_fini(&e->msg);
+    CP_ZERO(e);
+}
+
+cp_static_assert(CP_SLICER_STAGE_READ == CP_PROGRESS_READ);
+cp_static_assert(CP_SLICER_STAGE_SLICE == CP_PROGRESS_SLICE);
+
+/**
+ * Report progress and check for cancellation.
+ */
+static bool progress(
+    cp_slicer_t *s,
+    cp_progress_stage_t stage,
+    size_t zi,
+    size_t zi_cnt)
+{
+    if (s->progress_func != NULL) {
+        s->progress_func(s->progress_user, stage, zi, zi_cnt);
+    }
+    if (cp_csg_cancelled(&s->csg)) {
+        cp_vchar_printf(&s->syn.err.msg, "Cancelled.\n");
+        return false;
+    }
+    return true;
+}
+
+static void model_fini(
+    cp_slicer_t *s)
+{
+    cp_csg2_tree_fini(&s->csg2b);
+    cp_csg2_tree_fini(&s->csg2);
+    cp_csg3_tree_fini(&s->csg3);
+    cp_scad_tree_fini(&s->scad);
+    cp_syn_tree_fini(&s->syn);
+    CP_ZERO(&s->csg3);
+    CP_ZERO(&s->scad);
+    CP_ZERO(&s->syn);
+    s->loaded = false;
+}
+
+static bool load(
+    cp_slicer_t *s,
+    char const *name,
+    FILE *f)
+{
+    model_fini(s);
+    cp_vchar_clear(&s->err);
+    cp_pool_clear(&s->pool);
+    s->csg3.opt = &s->csg;
+
+    if (!progress(s, CP_PROGRESS_READ, 0, 0)) {
+        set_error(s);
+        return false;
+    }
+
+    bool ok;
+    if (has_suffix(name, ".stl")) {
+        cp_scad_polyhedron_t *p = cp_scad_new(*p, NULL);
+        cp_v_push(&s->scad.toplevel, cp_scad_cast(cp_scad_t, p));
+        ok = cp_stl_parse(&s->syn, &s->syn.err, p, NULL, name, f);
+    }
+    else {
+        ok = cp_syn_parse(&s->syn, name, f) && cp_scad_from_syn_tree(&s->scad, &s->syn);
+    }
+    ok = ok && cp_csg3_from_scad_tree(&s->pool, &s->syn, &s->csg3, &s->syn.err, &s->scad);
+    ok = ok && progress(s, CP_PROGRESS_READ, 0, 0);
+    if (!ok) {
+        set_error(s);
+        return false;
+    }
+
+    /* layers: like the command line tool */
+    cp_vec3_minmax_t bb = CP_VEC3_MINMAX_EMPTY;
+    cp_csg3_tree_bb(&bb, &s->csg3, false);
+    cp_dim_t z_min = bb.min.z + s->z_step/2;
+    cp_dim_t z_max = bb.max.z;
+    if (s->have_range) {
+        z_min = s->z_min;
+        z_max = s->z_max;
+    }
+    cp_range_t range;
+    cp_range_init(&range, z_min, z_max, s->z_step);
+    if (range.cnt == 0) {
+        range.cnt = 1;
+    }
+
+    cp_csg3_tree_optimise(&s->csg3);
+    cp_csg2_tree_from_csg3(&s->csg2, &s->csg3, &range, &s->csg);
+    cp_csg2_op_tree_init(&s->csg2b, &s->csg2);
+    s->loaded = true;
+    return true;
+}
+
+/**
+ * Copy layer zi of the op tree t into the arrays of the slicer.
+ */
+static void layer_get(
+    cp_slicer_t *s,
+    cp_slicer_layer_t *layer,
+    cp_csg2_tree_t *t,
+    size_t zi)
+{
+    cp_v_clear(&s->point, 0);
+    cp_v_clear(&s->path_start, 0);
+    cp_v_clear(&s->path_idx, 0);
+    cp_v_clear(&s->triangle, 0);
+    cp_v_push(&s->path_start, 0);
+
+    cp_csg2_stack_t *st = cp_csg2_cast(*st, t->root);
+    cp_csg2_layer_t *l = cp_csg2_stack_get_layer(st, zi);
+    if ((l != NULL) && (cp_csg_add_size(l->root) > 0)) {
+        assert(cp_csg_add_size(l->root) == 1);
+        cp_csg2_poly_t *p = cp_csg2_cast(*p, cp_v_nth(&l->root->add, 0));
+        for (cp_v_each(i, &p->point)) {
+            cp_vec2_t const *v = &cp_v_nth(&p->point, i).coord;
+            cp_v_push(&s->point, v->x);
+            cp_v_push(&s->point, v->y);
+        }
+        for (cp_v_each(i, &p->path)) {
+            cp_csg2_path_t const *q = &cp_v_nth(&p->path, i);
+            cp_v_append(&s->path_idx, &q->point_idx);
+            cp_v_push(&s->path_start, s->path_idx.size);
+        }
+        for (cp_v_each(i, &p->triangle)) {
+            for (cp_size_each(j, 3)) {
+                cp_v_push(&s->triangle, cp_v_nth(&p->triangle, i).p[j]);
+            }
+        }
+    }
+
+    CP_ZERO(layer);
+    layer->z = cp_v_nth(&t->z, zi);
+    layer->point_cnt = s->point.size / 2;
+    layer->point = s->point.data;
+    layer->path_cnt = s->path_start.size - 1;
+    layer->path_start = s->path_start.data;
+    layer->path_idx = s->path_idx.data;
+    layer->triangle_cnt = s->triangle.size / 3;
+    layer->triangle = s->triangle.data;
+}
+
+/**
+ * Returns CP_SLICER_API_VERSION of the library.
+ */
+extern unsigned cp_slicer_api_version(void)
+{
+    return CP_SLICER_API_VERSION;
+}
+
+/**
+ * Allocate a new slicer with default options.
+ */
+extern cp_slicer_t *cp_slicer_new(void)
+{
+    cp_slicer_t *s = CP_NEW(*s);
+    s->z_step = 0.2;
+    s->tri = true;
+    s->csg.max_fn = 100;
+    s->csg.layer_gap = -1;
+    s->csg.max_simultaneous = CP_CSG2_MAX_LAZY;
+    s->csg.optimise = CP_CSG2_OPT_DEFAULT;
+    s->csg.progress = &s->progress;
+    cp_pool_init(&s->pool, 0);
+    cp_vchar_init(&s->err);
+    return s;
+}
+
+/**
+ * Free a slicer and everything it contains.
+ */
+extern void cp_slicer_delete(
+    cp_slicer_t *s)
+{
+    if (s == NULL) {
+        return;
+    }
+    model_fini(s);
+    cp_pool_fini(&s->pool);
+    cp_v_fini(&s->point);
+    cp_v_fini(&s->path_start);
+    cp_v_fini(&s->path_idx);
+    cp_v_fini(&s->triangle);
+    cp_vchar_fini(&s->err);
+    CP_FREE(s);
+}
+
+/**
+ * Set the distance between layers (default: 0.2).
+ *
+ * Options must be set before the model is loaded.
+ */
+extern void cp_slicer_set_step(
+    cp_slicer_t *s,
+    double step)
+{
+    s->z_step = step;
+}
+
+/**
+ * Set the z coordinate of the first and last layer.  By default, the
+ * layers cover the bounding box of the model.
+ */
+extern void cp_slicer_set_range(
+    cp_slicer_t *s,
+    double z_min,
+    double z_max)
+{
+    s->z_min = z_min;
+    s->z_max = z_max;
+    s->have_range = true;
+}
+
+/**
+ * Compute only the part of each layer inside the given xy rectangle.
+ * Objects outside are skipped, and the others are clipped right after
+ * slicing.  By default, the whole layer is computed.
+ *
+ * If the rectangle is empty, i.e., if x0 >= x1 or y0 >= y1, the
+ * setting is not changed, and this returns false, and
+ * cp_slicer_error() returns the message.
+ */
+extern bool cp_slicer_set_xy_window(
+    cp_slicer_t *s,
+    double x0,
+    double y0,
+    double x1,
+    double y1)
+{
+    if (!cp_lt(x0, x1) || !cp_lt(y0, y1)) {
+        cp_vchar_clear(&s->err);
+        cp_vchar_printf(&s->err, "Error: Empty xy window: %g,%g,%g,%g\n", x0, y0, x1, y1);
+        return false;
+    }
+    s->xy_window.min.x = x0;
+    s->xy_window.min.y = y0;
+    s->xy_window.max.x = x1;
+    s->xy_window.max.y = y1;
+    s->csg.xy_window = &s->xy_window;
+    return true;
+}
+
+/**
+ * Set the maximum number of polygon vertices of a circle (default: 100).
+ */
+extern void cp_slicer_set_max_fn(
+    cp_slicer_t *s,
+    size_t max_fn)
+{
+    s->csg.max_fn = max_fn;
+}
+
+/**
+ * Set whether layers are triangulated (default: true).
+ */
+extern void cp_slicer_set_tri(
+    cp_slicer_t *s,
+    bool tri)
+{
+    s->tri = tri;
+}
+
+/**
+ * Set a callback that is invoked before reading a model and before
+ * computing each layer, or NULL for none (the default).
+ */
+extern void cp_slicer_set_progress(
+    cp_slicer_t *s,
+    cp_slicer_progress_t func,
+    void *user)
+{
+    s->progress_func = func;
+    s->progress_user = user;
+}
+
+/**
+ * Set or clear the cancellation flag.
+ *
+ * This may be called from another thread or from a signal handler
+ * while the slicer is working.  When set, loading a model and
+ * computing layers fail with a 'Cancelled' error as soon as possible,
+ * also in the middle of a layer.  The flag stays set until it is
+ * cleared again.
+ */
+extern void cp_slicer_set_cancel(
+    cp_slicer_t *s,
+    bool cancel)
+{
+    atomic_store_explicit(&s->progress.cancel, cancel, memory_order_relaxed);
+}
+
+/**
+ * Load a model from a SCAD file, or from an STL file if the name ends
+ * in '.stl'.  Any previously loaded model is freed.
+ *
+ * On error, returns false, and cp_slicer_error() returns the message.
+ */
+extern bool cp_slicer_load_file(
+    cp_slicer_t *s,
+    char const *file_name)
+{
+    FILE *f = fopen(file_name, "rb");
+    if (f == NULL) {
+        model_fini(s);
+        cp_vchar_clear(&s->err);
+        cp_vchar_printf(&s->err, "Error: Unable to open '%s' for reading: %s\n",
+            file_name, strerror(errno));
+        return false;
+    }
+    bool ok = load(s, file_name, f);
+    fclose(f);
+    return ok;
+}
+
+/**
+ * Load a model from memory.  name is used in error messages, and as
+ * the base for relative 'use' and 'include' file names.  If it ends in
+ * '.stl', the data is read as an STL file.
+ *
+ * On error, returns false, and cp_slicer_error() returns the message.
+ */
+extern bool cp_slicer_load_buffer(
+    cp_slicer_t *s,
+    char const *name,
+    void const *data,
+    size_t size)
+{
+    /* fmemopen() cannot open an empty buffer */
+    FILE *f = (size == 0) ? fopen("/dev/null", "rb") : fmemopen((void*)(size_t)data, size, "rb");
+    if (f == NULL) {
+        model_fini(s);
+        cp_vchar_clear(&s->err);
+        cp_vchar_printf(&s->err, "Error: Unable to read '%s' from memory: %s\n",
+            name, strerror(errno));
+        return false;
+    }
+    bool ok = load(s, name, f);
+    fclose(f);
+    return ok;
+}
+
+/**
+ * Returns the number of layers of the loaded model.
+ */
+extern size_t cp_slicer_layer_cnt(
+    cp_slicer_t const *s)
+{
+    return s->loaded ? s->csg2.z.size : 0;
+}
+
+/**
+ * Compute layer zi of the trees a (from the model) and r (from
+ * cp_csg2_op_tree_init()), copy it into layer, and delete it from
+ * the trees.
+ */
+static bool layer_compute(
+    cp_slicer_t *s,
+    cp_slicer_layer_t *layer,
+    cp_csg2_tree_t *r,
+    cp_csg2_tree_t *a,
+    size_t zi)
+{
+    cp_pool_clear(&s->pool);
+    bool ok =
+        progress(s, CP_PROGRESS_SLICE, zi, cp_slicer_layer_cnt(s)) &&
+        cp_csg2_tree_add_layer(&s->pool, a, &s->syn.err, zi);
+    if (ok) {
+        cp_csg2_op_add_layer(&s->csg, &s->pool, r, a, zi);
+        /* a cancelled boolean operation leaves an empty layer */
+        ok = progress(s, CP_PROGRESS_SLICE, zi, cp_slicer_layer_cnt(s));
+        if (ok && s->tri) {
+            ok = cp_csg2_tri_layer(&s->pool, &s->syn.err, r, zi);
+        }
+    }
+    if (ok) {
+        layer_get(s, layer, r, zi);
+    }
+    else {
+        set_error(s);
+    }
+
+    cp_csg2_tree_delete_layer(a, zi);
+    cp_csg2_tree_delete_layer(r, zi);
+    return ok;
+}
+
+/**
+ * Compute layer zi of the loaded model.
+ *
+ * Layers can be computed in any order.  Only the current layer is kept
+ * in memory.
+ *
+ * On error, returns false, and cp_slicer_error() returns the message.
+ */
+extern bool cp_slicer_get_layer(
+    cp_slicer_t *s,
+    size_t zi,
+    cp_slicer_layer_t *layer)
+{
+    cp_vchar_clear(&s->err);
+    if (zi >= cp_slicer_layer_cnt(s)) {
+        cp_vchar_printf(&s->err, "Error: No layer %"_Pz"u.\n", zi);
+        return false;
+    }
+    return layer_compute(s, layer, &s->csg2b, &s->csg2, zi);
+}
+
+/**
+ * Compute a layer of the loaded model at an arbitrary z coordinate,
+ * independent of the step and range settings.
+ *
+ * This does the work of a single layer: no other layers are computed
+ * or allocated.
+ *
+ * The result is valid as for cp_slicer_get_layer().
+ *
+ * On error, returns false, and cp_slicer_error() returns the message.
+ */
+extern bool cp_slicer_get_layer_at(
+    cp_slicer_t *s,
+    double z,
+    cp_slicer_layer_t *layer)
+{
+    cp_vchar_clear(&s->err);
+    if (!s->loaded) {
+        cp_vchar_printf(&s->err, "Error: No model loaded.\n");
+        return false;
+    }
+
+    cp_csg2_tree_t a = {0};
+    cp_csg2_tree_from_csg3_z(&a, &s->csg3, &z, 1, s->z_step, &s->csg);
+    cp_csg2_tree_t r = {0};
+    cp_csg2_op_tree_init(&r, &a);
+
+    bool ok = layer_compute(s, layer, &r, &a, 0);
+
+    cp_csg2_tree_fini(&r);
+    cp_csg2_tree_fini(&a);
+    return ok;
+}
+
+/**
+ * Returns the message of the last error, including the source
+ * location, or an empty string if there was no error.
+ */
+extern char const *cp_slicer_error(
+    cp_slicer_t const *s)
+{
+    return s->err.size == 0 ? "" : s->err.data;
+}
@@ -0,0 +1,470 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+#include <stdint.h>
+#include <hob3lbase/vec.h>
+#include <hob3lbase/mat.h>
+#include <hob3lbase/arith.h>
+#include <hob3lbase/alloc.h>
+#include <hob3l/syn.h>
+#include <hob3l/stl.h>
+#include "internal.h"
+
+/** Size of binary STL header, including the triangle count */
+#define BIN_HEAD_SIZE 84
+
+/** Size of one binary STL triangle record */
+#define BIN_TRI_SIZE  50
+
+typedef CP_VEC_T(cp_loc_t) v_loc_t;
+
+typedef struct {
+    cp_err_t *err;
+    char const *filename;
+
+    /** location of import statement, for binary files */
+    cp_loc_t loc;
+
+    /** welded vertices */
+    cp_v_vec3_loc_t point;
+
+    /** open addressing hash table into 'point': index+1, 0 = empty */
+    cp_v_size_t hash;
+
+    /** grid cell size for welding */
+    cp_f_t cell;
+
+    /** three point indices per triangle */
+    cp_v_size_t tri;
+
+    /** location of each triangle corner */
+    v_loc_t tri_loc;
+
+    /** location of each triangle */
+    v_loc_t face_loc;
+} ctxt_t;
+
+__attribute__((format(printf,3,4)))
+static bool msg(
+    ctxt_t *c,
+    cp_loc_t loc,
+    char const *form, ...)
+{
+    va_list va;
+    va_start(va, form);
+    if (loc == NULL) {
+        cp_vchar_printf(&c->err->msg, "%s: ", c->filename);
+    }
+    cp_vchar_vprintf(&c->err->msg, form, va);
+    va_end(va);
+    c->err->loc = loc;
+    return false;
+}
+
+static long long cell_of(
+    ctxt_t *c,
+    cp_f_t x)
+{
+    cp_f_t f = floor(x / c->cell);
+    return (long long)f;
+}
+
+static size_t hash_cell(
+    ctxt_t *c,
+    long long x,
+    long long y,
+    long long z)
+{
+    uint64_t h = (uint64_t)x * 0x9e3779b97f4a7c15ULL;
+    h ^= (uint64_t)y * 0xc2b2ae3d27d4eb4fULL;
+    h ^= (uint64_t)z * 0x165667b19e3779f9ULL;
+    h ^= h >> 29;
+    return (size_t)h & (c->hash.size - 1);
+}
+
+static void hash_insert(
+    ctxt_t *c,
+    size_t idx)
+{
+    cp_vec3_t const *v = &cp_v_nth(&c->point, idx).coord;
+    size_t h = hash_cell(c, cell_of(c, v->x), cell_of(c, v->y), cell_of(c, v->z));
+    while (cp_v_nth(&c->hash, h) != 0) {
+        h = (h + 1) & (c->hash.size - 1);
+    }
+    cp_v_nth(&c->hash, h) = idx + 1;
+}
+
+static void hash_grow(
+    ctxt_t *c)
+{
+    size_t n = c->hash.size * 2;
+    if (n == 0) {
+        n = 1024;
+    }
+    cp_v_fini(&c->hash);
+    cp_v_init0(&c->hash, n);
+    for (cp_v_each(i, &c->point)) {
+        hash_insert(c, i);
+    }
+}
+
+/**
+ * Find a point closer than cp_pt_epsilon in the grid cells around v.
+ *
+ * The cell size is at least twice the epsilon, so in each dimension,
+ * at most two cells need to be checked.
+ */
+static size_t weld_find(
+    ctxt_t *c,
+    cp_vec3_t const *v)
+{
+    long long lo[3], hi[3];
+    for (cp_arr_each(k, lo)) {
+        lo[k] = cell_of(c, v->v[k] - cp_pt_epsilon);
+        hi[k] = cell_of(c, v->v[k] + cp_pt_epsilon);
+    }
+    for (long long x = lo[0]; x <= hi[0]; x++) {
+        for (long long y = lo[1]; y <= hi[1]; y++) {
+            for (long long z = lo[2]; z <= hi[2]; z++) {
+                size_t h = hash_cell(c, x, y, z);
+                while (cp_v_nth(&c->hash, h) != 0) {
+                    size_t idx = cp_v_nth(&c->hash, h) - 1;
+                    if (cp_vec3_pt_eq(&cp_v_nth(&c->point, idx).coord, v)) {
+                        return idx;
+                    }
+                    h = (h + 1) & (c->hash.size - 1);
+                }
+            }
+        }
+    }
+    return CP_SIZE_MAX;
+}
+
+/**
+ * Return the index of the point v, adding it if no point is close by.
+ */
+static size_t weld(
+    ctxt_t *c,
+    cp_vec3_t const *v,
+    cp_loc_t loc)
+{
+    size_t idx = weld_find(c, v);
+    if (idx != CP_SIZE_MAX) {
+        return idx;
+    }
+
+    idx = c->point.size;
+    cp_vec3_loc_t *p = cp_v_push0(&c->point);
+    p->coord = *v;
+    p->loc = loc;
+    if ((c->point.size * 2) > c->hash.size) {
+        hash_grow(c);
+    }
+    else {
+        hash_insert(c, idx);
+    }
+    return idx;
+}
+
+/**
+ * Add a triangle given in STL orientation, i.e., counter-clockwise
+ * when viewed from outside.  Triangles that degenerate by welding
+ * are dropped.
+ */
+static void tri_add(
+    ctxt_t *c,
+    cp_vec3_t const v[3],
+    cp_loc_t const vloc[3],
+    cp_loc_t loc)
+{
+    size_t i[3];
+    for (cp_size_each(k, 3)) {
+        i[k] = weld(c, &v[k], vloc[k]);
+    }
+    if ((i[0] == i[1]) || (i[1] == i[2]) || (i[2] == i[0])) {
+        return;
+    }
+
+    /* reverse to get clockwise orientation */
+    cp_v_push(&c->tri, i[0]);
+    cp_v_push(&c->tri, i[2]);
+    cp_v_push(&c->tri, i[1]);
+    cp_v_push(&c->tri_loc, vloc[0]);
+    cp_v_push(&c->tri_loc, vloc[2]);
+    cp_v_push(&c->tri_loc, vloc[1]);
+    cp_v_push(&c->face_loc, loc);
+}
+
+static uint32_t get_le32(
+    unsigned char const *b)
+{
+    return
+        ((uint32_t)b[0])       |
+        ((uint32_t)b[1] << 8)  |
+        ((uint32_t)b[2] << 16) |
+        ((uint32_t)b[3] << 24);
+}
+
+static cp_f_t get_float32(
+    unsigned char const *b)
+{
+    uint32_t u = get_le32(b);
+    float f;
+    cp_static_assert(sizeof(f) == sizeof(u));
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static bool parse_bin(
+    ctxt_t *c,
+    unsigned char const *data,
+    size_t cnt)
+{
+    unsigned char const *b = data + BIN_HEAD_SIZE;
+    for (cp_size_each(i, cnt)) {
+        /* skip normal: orientation is derived from the vertex order */
+        unsigned char const *q = b + 12;
+        cp_vec3_t v[3];
+        for (cp_size_each(k, 3)) {
+            for (cp_size_each(j, 3)) {
+                v[k].v[j] = get_float32(q);
+                q += 4;
+            }
+            if (!isfinite(v[k].x) || !isfinite(v[k].y) || !isfinite(v[k].z)) {
+                return msg(c, c->loc,
+                    "Non-finite coordinate in triangle %"_Pz"u of binary STL file.\n", i);
+            }
+        }
+        tri_add(c, v, (cp_loc_t[3]){ c->loc, c->loc, c->loc }, c->loc);
+        b += BIN_TRI_SIZE;
+    }
+    return true;
+}
+
+static char const *skip_space(
+    char const *s)
+{
+    while ((*s == ' ') || (*s == '\t') || (*s == '\r') || (*s == '\n')) {
+        s++;
+    }
+    return s;
+}
+
+static bool is_word(
+    char const *s,
+    char const *w)
+{
+    size_t n = strlen(w);
+    if (strncmp(s, w, n) != 0) {
+        return false;
+    }
+    return (s[n] == '\0') || (s[n] == ' ') || (s[n] == '\t') ||
+        (s[n] == '\r') || (s[n] == '\n');
+}
+
+static bool expect_word(
+    ctxt_t *c,
+    char const **s,
+    char const *w)
+{
+    *s = skip_space(*s);
+    if (!is_word(*s, w)) {
+        return msg(c, *s, "Expected '%s'.\n", w);
+    }
+    *s += strlen(w);
+    return true;
+}
+
+static bool expect_float(
+    ctxt_t *c,
+    cp_f_t *r,
+    char const **s)
+{
+    *s = skip_space(*s);
+    char *e = NULL;
+    *r = strtod(*s, &e);
+    if ((e == *s) || !is_word(e, "") || !isfinite(*r)) {
+        return msg(c, *s, "Expected a number.\n");
+    }
+    *s = e;
+    return true;
+}
+
+static char const *skip_line(
+    char const *s)
+{
+    while ((*s != '\0') && (*s != '\n')) {
+        s++;
+    }
+    return s;
+}
+
+static bool parse_ascii(
+    ctxt_t *c,
+    char const *s)
+{
+    s = skip_space(s);
+    if (!expect_word(c, &s, "solid")) {
+        return false;
+    }
+    s = skip_line(s);
+
+    for (;;) {
+        s = skip_space(s);
+        cp_loc_t loc = s;
+        if (is_word(s, "endsolid")) {
+            s = skip_space(skip_line(s));
+            if (*s == '\0') {
+                return true;
+            }
+            /* some files concatenate multiple solids */
+            if (!expect_word(c, &s, "solid")) {
+                return false;
+            }
+            s = skip_line(s);
+            continue;
+        }
+        if (!is_word(s, "facet")) {
+            return msg(c, s, "Expected 'facet' or 'endsolid'.\n");
+        }
+        s += 5;
+
+        cp_vec3_t n;
+        if (!expect_word(c, &s, "normal") ||
+            !expect_float(c, &n.x, &s) ||
+            !expect_float(c, &n.y, &s) ||
+            !expect_float(c, &n.z, &s) ||
+            !expect_word(c, &s, "outer") ||
+            !expect_word(c, &s, "loop"))
+        {
+            return false;
+        }
+
+        cp_vec3_t v[3];
+        cp_loc_t vloc[3];
+        for (cp_size_each(k, 3)) {
+            vloc[k] = skip_space(s);
+            if (!expect_word(c, &s, "vertex") ||
+                !expect_float(c, &v[k].x, &s) ||
+                !expect_float(c, &v[k].y, &s) ||
+                !expect_float(c, &v[k].z, &s))
+            {
+                return false;
+            }
+        }
+
+        if (!expect_word(c, &s, "endloop") ||
+            !expect_word(c, &s, "endfacet"))
+        {
+            return false;
+        }
+
+        tri_add(c, v, vloc, loc);
+    }
+}
+
+static bool parse_content(
+    ctxt_t *c,
+    cp_syn_file_t *f)
+{
+    /* content is NUL terminated: do not count the NUL */
+    assert(f->content.size > 0);
+    size_t z = f->content.size - 1;
+    unsigned char const *data = (unsigned char const *)f->content.data;
+
+    /* binary STL is recognised by its exact size, because binary
+     * headers may start with 'solid', too. */
+    if (z >= BIN_HEAD_SIZE) {
+        size_t cnt = get_le32(data + BIN_HEAD_SIZE - 4);
+        if ((cnt <= ((z - BIN_HEAD_SIZE) / BIN_TRI_SIZE)) &&
+            ((BIN_HEAD_SIZE + (cnt * BIN_TRI_SIZE)) == z))
+        {
+            bool ok = parse_bin(c, data, cnt);
+
+            /* there are no source locations inside binary files, so
+             * drop the content */
+            cp_vchar_fini(&f->content);
+            cp_vchar_fini(&f->content_orig);
+            cp_v_fini(&f->line);
+            return ok;
+        }
+    }
+
+    if (!is_word(skip_space(f->content.data), "solid")) {
+        return msg(c, NULL,
+            "Not an STL file: neither binary STL of matching size, "
+            "nor ASCII STL starting with 'solid'.\n");
+    }
+    return parse_ascii(c, f->content.data);
+}
+
+/* ********************************************************************** */
+
+/**
+ * Read an STL file into a polyhedron.
+ *
+ * The file content is registered with the syntax tree so that
+ * locations of ASCII STL files can be reported in error messages.
+ * Locations of binary STL files refer to \a loc instead.
+ *
+ * The faces of the result are clockwise when viewed from the outside,
+ * like in SCAD polyhedra, i.e., the result can be processed like any
+ * polyhedron read from a SCAD file.
+ *
+ * On error, returns false and fills in err.
+ */
+extern bool cp_stl_parse(
+    cp_syn_tree_t *syn,
+    cp_err_t *err,
+    cp_scad_polyhedron_t *r,
+    cp_loc_t loc,
+    char const *filename,
+    FILE *file)
+{
+    ctxt_t c = {
+        .err = err,
+        .filename = filename,
+        .loc = loc,
+        .cell = 2 * cp_pt_epsilon,
+    };
+
+    cp_syn_file_t *f;
+    if (!cp_syn_read(&f, syn, filename, file)) {
+        if (err != &syn->err) {
+            cp_vchar_append(&err->msg, &syn->err.msg);
+        }
+        err->loc = loc;
+        return false;
+    }
+    f->include_loc = loc;
+
+    hash_grow(&c);
+    bool ok = parse_content(&c, f);
+    if (ok && (c.point.size == 0)) {
+        ok = msg(&c, NULL, "STL file contains no triangles.\n");
+    }
+    if (ok) {
+        /* copy points (same data type, just copy the array) */
+        cp_v_init_with(&r->points, c.point.data, c.point.size);
+
+        /* one face per triangle */
+        cp_v_init0(&r->faces, c.face_loc.size);
+        for (cp_v_each(i, &r->faces)) {
+            cp_scad_face_t *sf = &cp_v_nth(&r->faces, i);
+            sf->loc = cp_v_nth(&c.face_loc, i);
+            cp_v_init0(&sf->points, 3);
+            for (cp_size_each(k, 3)) {
+                cp_vec3_loc_ref_t *pr = &cp_v_nth(&sf->points, k);
+                pr->ref = &cp_v_nth(&r->points, cp_v_nth(&c.tri, (3*i) + k));
+                pr->loc = cp_v_nth(&c.tri_loc, (3*i) + k);
+            }
+        }
+    }
+
+    cp_v_fini(&c.point);
+    cp_v_fini(&c.hash);
+    cp_v_fini(&c.tri);
+    cp_v_fini(&c.tri_loc);
+    cp_v_fini(&c.face_loc);
+    return ok;
+}
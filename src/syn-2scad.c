@@ -12,6 +12,14 @@
 #include <hob3l/syn.h>
 #include "internal.h"
 
+static void cp_syn_stmt_include_put_scad(
+    cp_stream_t *s,
+    int d,
+    cp_syn_stmt_include_t *f)
+{
+    cp_printf(s, "%*sinclude <%s>\n", d, "", f->path);
+}
+
 static void cp_syn_stmt_put_scad(
     cp_stream_t *s,
     int d,
@@ -129,6 +137,9 @@ static void cp_syn_stmt_put_scad(
     case CP_SYN_STMT_USE:
         cp_syn_stmt_use_put_scad(s, d, cp_syn_cast(cp_syn_stmt_use_t, f));
         return;
+    case CP_SYN_STMT_INCLUDE:
+        cp_syn_stmt_include_put_scad(s, d, cp_syn_cast(cp_syn_stmt_include_t, f));
+        return;
     default:
         CP_NYI("type=0x%x", f->type);
     }
@@ -3,9 +3,13 @@
 
 /* SCAD parser */
 
+/* for realpath() */
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <sys/stat.h>
 #include <hob3l/syn.h>
 #include <hob3lbase/vchar.h>
 #include <hob3lbase/alloc.h>
@@ -31,6 +35,32 @@
 #define K_MODULE    (_T_KEY + 3) /* 'module' */
 #define K_FUNCTION  (_T_KEY + 4) /* 'function' */
 
+/**
+ * Library file parsed via 'use' or 'include'.
+ */
+typedef struct {
+    /** real path of the file */
+    char *path;
+    /** modification time and size of the file when it was read */
+    struct timespec mtime;
+    off_t size;
+    /** number of syntax trees that use this file */
+    size_t ref_cnt;
+    /** the file has changed since it was read: only kept for old references */
+    bool stale;
+    cp_syn_file_t *file;
+} lib_t;
+
+typedef CP_VEC_T(lib_t) v_lib_t;
+
+/**
+ * Process-wide cache of parsed library files, so that each library
+ * is parsed only once regardless of how often it is referenced.
+ * Entries are keyed by real path, modification time, and size, so a
+ * library that changed on disk is parsed again.
+ */
+static v_lib_t lib_cache;
+
 typedef struct {
     cp_syn_tree_t *tree;
 
@@ -41,6 +71,10 @@ typedef struct {
     unsigned tok_type;
     const char *tok_string;
     const char *tok_loc;
+
+    /** if non-NULL, invoked for each top-level statement */
+    cp_syn_stmt_cb_t stmt_cb;
+    void *stmt_user;
 } parse_t;
 
 static bool have_err_msg(parse_t *p)
@@ -768,17 +802,18 @@ static bool parse_stmt_item(
     }
 }
 
-static bool parse_stmt_use(
+static bool parse_path(
     parse_t *p,
-    cp_syn_stmt_use_t *r)
+    unsigned key,
+    char const **path)
 {
-    if (!expect(p, K_USE)) {
+    if (!expect(p, key)) {
         return false;
     }
     tok_path(p);
 
-    r->path = p->tok_string;
-    if (!expect(p, T_PATH)) {
+    *path = p->tok_string;
+    if (!expect_err(p, T_PATH)) {
         return false;
     }
 
@@ -835,7 +870,14 @@ static bool parse_stmt_list(
         case K_USE:{
             cp_syn_stmt_use_t *f = cp_syn_new(*f, p->tok_string);
             cp_v_push(r, cp_syn_cast(cp_syn_stmt_t, f));
-            if (!parse_stmt_use(p, f)) {
+            if (!parse_path(p, K_USE, &f->path)) {
+                return false;
+            }
+            break;}
+        case K_INCLUDE:{
+            cp_syn_stmt_include_t *f = cp_syn_new(*f, p->tok_string);
+            cp_v_push(r, cp_syn_cast(cp_syn_stmt_t, f));
+            if (!parse_path(p, K_INCLUDE, &f->path)) {
                 return false;
             }
             break;}
@@ -848,57 +890,60 @@ static bool parse_stmt_list(
             }
             break;
         }
+
+        if ((p->stmt_cb != NULL) && (r->size > 0)) {
+            assert(r == &p->tree->toplevel);
+            bool ok = p->stmt_cb(p->stmt_user, p->tree);
+            for (cp_v_each(i, r)) {
+                cp_syn_stmt_delete(cp_v_nth(r, i));
+            }
+            r->size = 0;
+            if (!ok) {
+                return false;
+            }
+        }
     }
 }
 
-static bool cp_scad_read_file(
-    parse_t *p,
-    cp_syn_tree_t *r,
-    cp_syn_file_t *f,
-    char const *filename,
-    FILE *file)
+static void value_delete(
+    cp_syn_value_t *v)
 {
-    cp_vchar_printf(&f->filename, "%s", filename);
-    f->file = file;
-
-    /* read file */
-    for(;;) {
-        char buff[4096];
-        size_t cnt = fread(buff, 1, sizeof(buff), f->file);
-        assert(cnt <= sizeof(buff));
-        if (cnt == 0) {
-            if (feof(f->file)) {
-                break;
-            }
-            cp_vchar_printf(&r->err.msg, "File read error: %s.\n",
-                strerror(ferror(f->file)));
-            return false;
+    if (v == NULL) {
+        return;
+    }
+    switch (v->type) {
+    case CP_SYN_VALUE_RANGE:{
+        cp_syn_value_range_t *w = cp_syn_cast(*w, v);
+        value_delete(w->start);
+        value_delete(w->end);
+        value_delete(w->inc);
+        break;}
+
+    case CP_SYN_VALUE_ARRAY:{
+        cp_syn_value_array_t *w = cp_syn_cast(*w, v);
+        for (cp_v_each(i, &w->value)) {
+            value_delete(cp_v_nth(&w->value, i));
         }
-        cp_vchar_append_arr(&f->content, buff, cnt);
+        cp_v_fini(&w->value);
+        break;}
     }
-    size_t z = f->content.size;
-    cp_vchar_push(&f->content, '\0');
-
-    /* make a copy */
-    cp_vchar_append(&f->content_orig, &f->content);
-
-    /* init scanner */
-    p->lex_string = f->content.data;
-    p->lex_cur = *p->lex_string;
-    p->lex_end = f->content.data + z;
+    CP_FREE(v);
+}
 
-    /* cut into lines for lookup */
-    cp_v_push(&f->line, p->lex_string);
-    for (char const *i = p->lex_string; i < p->lex_end; i++) {
-        if (*i == '\n') {
-            cp_v_push(&f->line, i+1);
-        }
+static void stmt_item_delete(
+    cp_syn_stmt_item_t *s)
+{
+    for (cp_v_each(i, &s->arg)) {
+        cp_syn_arg_t *a = cp_v_nth(&s->arg, i);
+        value_delete(a->value);
+        CP_FREE(a);
     }
-    if (cp_v_last(&f->line) != p->lex_end) {
-        cp_v_push(&f->line, p->lex_end);
+    cp_v_fini(&s->arg);
+    for (cp_v_each(i, &s->body)) {
+        stmt_item_delete(cp_v_nth(&s->body, i));
     }
-
-    return true;
+    cp_v_fini(&s->body);
+    CP_FREE(s);
 }
 
 static int cmp_line(
@@ -997,32 +1042,85 @@ static void cp_syn_get_loc_src_aux(
 /* ********************************************************************** */
 
 /**
- * Parse a file into a SCAD syntax tree.
+ * Read a file into memory and append it to the list of files of the
+ * syntax tree, so that pointers into its content can be used as
+ * source locations.
+ *
+ * The content is NUL terminated and cut into lines, i.e., this
+ * sets up everything cp_syn_get_loc() needs.
+ *
+ * If fp is non-NULL, the new file entry is stored in *fp.
+ *
+ * On error, returns false and fills in r->err.
  */
-extern bool cp_syn_parse(
+extern bool cp_syn_read(
+    cp_syn_file_t **fp,
     cp_syn_tree_t *r,
     char const *filename,
     FILE *file)
 {
-    assert(r != NULL);
-    assert(file != NULL);
-    CP_ZERO(r);
-
-    /* basic init */
-    parse_t p[1];
-    CP_ZERO(p);
-    p->tree = r;
-
     cp_syn_file_t *f = CP_NEW(*f);
     cp_v_push(&r->file, f);
-    if (!cp_scad_read_file(p, r, f, filename, file)) {
-        return false;
+    if (fp != NULL) {
+        *fp = f;
+    }
+
+    cp_vchar_printf(&f->filename, "%s", filename);
+    f->file = file;
+
+    /* read file */
+    for(;;) {
+        char buff[4096];
+        size_t cnt = fread(buff, 1, sizeof(buff), f->file);
+        assert(cnt <= sizeof(buff));
+        if (cnt == 0) {
+            if (feof(f->file)) {
+                break;
+            }
+            cp_vchar_printf(&r->err.msg, "File read error: %s.\n",
+                strerror(ferror(f->file)));
+            return false;
+        }
+        cp_vchar_append_arr(&f->content, buff, cnt);
     }
+    size_t z = f->content.size;
+    cp_vchar_push(&f->content, '\0');
+
+    /* make a copy */
+    cp_vchar_append(&f->content_orig, &f->content);
+
+    /* cut into lines for lookup */
+    char const *start = f->content.data;
+    char const *end = start + z;
+    cp_v_push(&f->line, start);
+    for (char const *i = start; i < end; i++) {
+        if (*i == '\n') {
+            cp_v_push(&f->line, i+1);
+        }
+    }
+    if (cp_v_last(&f->line) != end) {
+        cp_v_push(&f->line, end);
+    }
+
+    return true;
+}
+
+static bool parse_content(
+    parse_t *p,
+    cp_syn_file_t *f,
+    cp_v_syn_stmt_p_t *toplevel)
+{
+    cp_syn_tree_t *r = p->tree;
+
+    /* init scanner */
+    p->lex_string = f->content.data;
+    p->lex_cur = *p->lex_string;
+    p->lex_end = f->content.data + f->content.size - 1;
 
     /* scan first token */
     tok_next(p);
 
-    bool ok = parse_stmt_list(p, &r->toplevel);
+    bool ok = parse_stmt_list(p, toplevel);
     if (!ok) {
         /* generic error message */
         if (r->err.loc == NULL) {
@@ -1041,6 +1139,243 @@ extern bool cp_syn_parse(
     return true;
 }
 
+static bool parse_file(
+    parse_t *p,
+    cp_syn_tree_t *r,
+    char const *filename,
+    FILE *file)
+{
+    cp_syn_file_t *f;
+    if (!cp_syn_read(&f, r, filename, file)) {
+        return false;
+    }
+    return parse_content(p, f, &r->toplevel);
+}
+
+/**
+ * Parse a file into a SCAD syntax tree.
+ */
+extern bool cp_syn_parse(
+    cp_syn_tree_t *r,
+    char const *filename,
+    FILE *file)
+{
+    assert(r != NULL);
+    assert(file != NULL);
+    CP_ZERO(r);
+
+    /* basic init */
+    parse_t p[1];
+    CP_ZERO(p);
+    p->tree = r;
+    return parse_file(p, r, filename, file);
+}
+
+/**
+ * Parse a file statement by statement.
+ *
+ * After each top-level statement is parsed, tree->toplevel contains
+ * only that statement, and cb is invoked.  After cb returns, the
+ * statement is deleted and tree->toplevel is cleared again.  The
+ * file content is kept, so source locations remain valid.
+ *
+ * This way, the syntax tree of only one top-level statement is in
+ * memory at any time.
+ *
+ * On error, returns false and fills in r->err.
+ */
+extern bool cp_syn_parse_each(
+    cp_syn_tree_t *r,
+    char const *filename,
+    FILE *file,
+    cp_syn_stmt_cb_t cb,
+    void *user)
+{
+    assert(r != NULL);
+    assert(file != NULL);
+    assert(cb != NULL);
+    CP_ZERO(r);
+
+    parse_t p[1];
+    CP_ZERO(p);
+    p->tree = r;
+    p->stmt_cb = cb;
+    p->stmt_user = user;
+    return parse_file(p, r, filename, file);
+}
+
+static void v_stmt_delete(
+    cp_v_syn_stmt_p_t *v)
+{
+    for (cp_v_each(i, v)) {
+        cp_syn_stmt_delete(cp_v_nth(v, i));
+    }
+    cp_v_fini(v);
+}
+
+static void file_delete(
+    cp_syn_file_t *f)
+{
+    v_stmt_delete(&f->toplevel);
+    cp_vchar_fini(&f->filename);
+    cp_vchar_fini(&f->content);
+    cp_vchar_fini(&f->content_orig);
+    cp_v_fini(&f->line);
+    CP_FREE(f);
+}
+
+static lib_t *lib_find(
+    cp_syn_file_t const *f)
+{
+    for (cp_v_each(i, &lib_cache)) {
+        lib_t *l = &cp_v_nth(&lib_cache, i);
+        if (l->file == f) {
+            return l;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Delete library files that have changed on disk and are not used
+ * by any syntax tree anymore.
+ */
+static void lib_sweep(void)
+{
+    size_t k = 0;
+    for (cp_v_each(i, &lib_cache)) {
+        lib_t *l = &cp_v_nth(&lib_cache, i);
+        if (l->stale && (l->ref_cnt == 0)) {
+            file_delete(l->file);
+            free(l->path);
+            continue;
+        }
+        cp_v_nth(&lib_cache, k++) = *l;
+    }
+    lib_cache.size = k;
+}
+
+/**
+ * Parse a library file referenced by 'use' or 'include'.
+ *
+ * Each file is parsed only once per process: the result is cached
+ * under the real path of the file and shared by all references and
+ * all syntax trees.  If the modification time or size of the file
+ * has changed, it is parsed again.  The file is added to r->file so
+ * that source locations inside it can be reported.
+ *
+ * loc is the location of the referencing statement.
+ *
+ * On success, *fp is set to the file, whose toplevel member
+ * contains the parsed statements.
+ *
+ * On error, returns false and fills in r->err.
+ */
+extern bool cp_syn_parse_lib(
+    cp_syn_file_t **fp,
+    cp_syn_tree_t *r,
+    cp_loc_t loc,
+    char const *filename)
+{
+    char *path = realpath(filename, NULL);
+    if (path == NULL) {
+        cp_vchar_printf(&r->err.msg, "Unable to open '%s' for reading: %s\n",
+            filename, strerror(errno));
+        r->err.loc = loc;
+        return false;
+    }
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        cp_vchar_printf(&r->err.msg, "Unable to open '%s' for reading: %s\n",
+            filename, strerror(errno));
+        r->err.loc = loc;
+        free(path);
+        return false;
+    }
+
+    /* parsed before? */
+    for (cp_v_each(i, &lib_cache)) {
+        lib_t *l = &cp_v_nth(&lib_cache, i);
+        if (l->stale || !strequ(l->path, path)) {
+            continue;
+        }
+        if ((l->mtime.tv_sec != st.st_mtim.tv_sec) ||
+            (l->mtime.tv_nsec != st.st_mtim.tv_nsec) ||
+            (l->size != st.st_size))
+        {
+            /* changed on disk: parse again */
+            l->stale = true;
+            lib_sweep();
+            break;
+        }
+        free(path);
+        *fp = l->file;
+        for (cp_v_each(j, &r->file)) {
+            if (cp_v_nth(&r->file, j) == l->file) {
+                return true;
+            }
+        }
+        cp_v_push(&r->file, l->file);
+        l->ref_cnt++;
+        return true;
+    }
+
+    FILE *file = fopen(filename, "rt");
+    if (file == NULL) {
+        cp_vchar_printf(&r->err.msg, "Unable to open '%s' for reading: %s\n",
+            filename, strerror(errno));
+        r->err.loc = loc;
+        free(path);
+        return false;
+    }
+
+    cp_syn_file_t *f;
+    bool ok = cp_syn_read(&f, r, filename, file);
+    fclose(file);
+    f->file = NULL;
+    f->include_loc = loc;
+    if (ok) {
+        parse_t p[1];
+        CP_ZERO(p);
+        p->tree = r;
+        ok = parse_content(p, f, &f->toplevel);
+    }
+    if (!ok) {
+        free(path);
+        return false;
+    }
+
+    cp_v_push(&lib_cache, ((lib_t){
+        .path = path,
+        .mtime = st.st_mtim,
+        .size = st.st_size,
+        .ref_cnt = 1,
+        .file = f,
+    }));
+    *fp = f;
+    return true;
+}
+
+/**
+ * Delete a statement and all its sub-statements and values.
+ */
+extern void cp_syn_stmt_delete(
+    cp_syn_stmt_t *s)
+{
+    switch (s->type) {
+    case CP_SYN_STMT_ITEM:
+        stmt_item_delete(cp_syn_cast(cp_syn_stmt_item_t, s));
+        return;
+
+    case CP_SYN_STMT_USE:
+    case CP_SYN_STMT_INCLUDE:
+        CP_FREE(s);
+        return;
+    }
+    CP_NYI("type=0x%x", s->type);
+}
+
 /**
  * Return a file location for a pointer to a token or any
  * other pointer into the file contents.
@@ -1126,4 +1461,36 @@ extern void cp_syn_format_loc(
         cp_vchar_append(post, &post2);
         cp_vchar_fini(&post2);
     }
+
+    /* make sure both are strings even if there is no location */
+    cp_vchar_append_arr(pre,  "", 0);
+    cp_vchar_append_arr(post, "", 0);
+}
+
+/**
+ * Delete all statements and files of a syntax tree.  The tree itself
+ * is not freed.
+ *
+ * Library files read via 'use' or 'include' stay in the process-wide
+ * cache for other syntax trees, unless they have changed on disk and
+ * no other tree uses them.
+ */
+extern void cp_syn_tree_fini(
+    cp_syn_tree_t *r)
+{
+    v_stmt_delete(&r->toplevel);
+    for (cp_v_each(i, &r->file)) {
+        cp_syn_file_t *f = cp_v_nth(&r->file, i);
+        lib_t *l = lib_find(f);
+        if (l != NULL) {
+            assert(l->ref_cnt > 0);
+            l->ref_cnt--;
+            continue;
+        }
+        file_delete(f);
+    }
+    lib_sweep();
+    cp_v_fini(&r->file);
+    cp_vchar_fini(&r->err.msg);
+    CP_ZERO(&r->err);
 }
@@ -0,0 +1,108 @@
+/* -*- Mode: C -*- */
+/* Copyright (C) 2018 by Henrik Theiling, License: GPLv3, see LICENSE file */
+
+#include <stdarg.h>
+#include <unistd.h>
+#include <hob3lbase/def.h>
+#include <hob3lbase/clock.h>
+#include <hob3lbase/trace.h>
+
+static void span_write(
+    cp_trace_t *t,
+    char const *name,
+    double t0)
+{
+    double t1 = cp_trace_now(t);
+    fprintf(t->file,
+        "%s{\"name\":\"%s\",\"cat\":\"hob3l\",\"ph\":\"X\","
+        "\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u",
+        (t->event_cnt == 0) ? "" : ",\n",
+        name, t0 * 1e6, (t1 - t0) * 1e6, t->pid, t->pid);
+    t->event_cnt++;
+}
+
+/**
+ * Open a trace file.
+ *
+ * On error, returns false, and errno is set.
+ */
+extern bool cp_trace_open(
+    cp_trace_t *t,
+    char const *file_name)
+{
+    CP_ZERO(t);
+    t->file = fopen(file_name, "wt");
+    if (t->file == NULL) {
+        return false;
+    }
+    t->pid = (unsigned)getpid();
+    fprintf(t->file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    return true;
+}
+
+/**
+ * Finish and close the trace file.
+ *
+ * On error, returns false, and errno is set.
+ */
+extern bool cp_trace_close(
+    cp_trace_t *t)
+{
+    if ((t == NULL) || (t->file == NULL)) {
+        return true;
+    }
+    fprintf(t->file, "\n]}\n");
+    bool ok = (fclose(t->file) == 0);
+    t->file = NULL;
+    return ok;
+}
+
+/**
+ * Current time in seconds, the start of a span, or 0 if t is NULL.
+ */
+extern double cp_trace_now(
+    cp_trace_t const *t)
+{
+    if (t == NULL) {
+        return 0;
+    }
+    return cp_clock_wall();
+}
+
+/**
+ * Write a span from t0 (as returned by cp_trace_now()) until now.
+ */
+extern void cp_trace_span(
+    cp_trace_t *t,
+    char const *name,
+    double t0)
+{
+    if (t == NULL) {
+        return;
+    }
+    span_write(t, name, t0);
+    fprintf(t->file, "}");
+}
+
+/**
+ * Write a span like cp_trace_span() with arguments.  args are the
+ * members of a JSON object, e.g. "\"zi\":%zu".
+ */
+extern void cp_trace_span_args(
+    cp_trace_t *t,
+    char const *name,
+    double t0,
+    char const *args,
+    ...)
+{
+    if (t == NULL) {
+        return;
+    }
+    span_write(t, name, t0);
+    fprintf(t->file, ",\"args\":{");
+    va_list va;
+    va_start(va, args);
+    vfprintf(t->file, args, va);
+    va_end(va);
+    fprintf(t->file, "}}");
+}
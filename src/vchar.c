@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <hob3lbase/vchar.h>
+#include <hob3lbase/alloc.h>
 
 /**
  * Finalise/discard a vector.
@@ -34,6 +35,8 @@ static void __grow(
         assert(new_alloc > vec->alloc);
     }
 
+    cp_alloc_count(CP_FILE, CP_LINE, CP_ALLOC_HEAP,
+        sizeof(vec->data[0]) * (new_alloc - vec->alloc));
     vec->data = realloc(vec->data, sizeof(vec->data[0]) * new_alloc);
     vec->alloc = new_alloc;
 }
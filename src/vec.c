@@ -9,6 +9,7 @@
 #include <hob3lbase/arith.h>
 #include <hob3lbase/vec.h>
 #include <hob3lbase/panic.h>
+#include <hob3lbase/alloc.h>
 
 /**
  * Internal: Shallow delete a vector: remove all sub-structures, but not the
@@ -47,6 +48,8 @@ static void __grow(
         assert(new_alloc > vec->alloc);
     }
 
+    cp_alloc_count(CP_FILE, CP_LINE, CP_ALLOC_HEAP,
+        __cp_v_size(new_alloc - vec->alloc, esz));
     vec->data = realloc(vec->data, __cp_v_size(new_alloc, esz));
     vec->alloc = new_alloc;
 }
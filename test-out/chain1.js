@@ -0,0 +1,10 @@
+scene.push({
+   'group':{},
+   'scaleV':512000,
+   'scaleC':255,
+   'shiftI':0,
+   'vertex':[2560,0,51,5120,-2560,51,0,0,51,-2560,0,51,5120,2560,51,0,0,51,5120,2560,51,-2560,0,154,5120,2560,154,5120,2560,51,-2560,0,51,-2560,0,154,0,0,51,5120,2560,154,0,0,154,0,0,51,5120,2560,51,5120,2560,154,2560,0,51,0,0,154,2560,0,154,2560,0,51,0,0,51,0,0,154,5120,-2560,51,2560,0,154,5120,-2560,154,5120,-2560,51,2560,0,51,2560,0,154,0,0,51,5120,-2560,154,0,0,154,0,0,51,5120,-2560,51,5120,-2560,154,-2560,0,51,0,0,154,-2560,0,154,-2560,0,51,0,0,51,0,0,154,5120,2560,154,-2560,0,256,5120,2560,256,5120,2560,154,-2560,0,154,-2560,0,256,0,0,154,5120,2560,256,0,0,256,0,0,154,5120,2560,154,5120,2560,256,2560,0,154,0,0,256,2560,0,256,2560,0,154,0,0,154,0,0,256,5120,-2560,154,2560,0,256,5120,-2560,256,5120,-2560,154,2560,0,154,2560,0,256,0,0,154,5120,-2560,256,0,0,256,0,0,154,5120,-2560,154,5120,-2560,256,-2560,0,154,0,0,256,-2560,0,256,-2560,0,154,0,0,154,0,0,256,5120,2560,256,-2560,0,358,5120,2560,358,5120,2560,256,-2560,0,256,-2560,0,358,0,0,256,5120,2560,358,0,0,358,0,0,256,5120,2560,256,5120,2560,358,2560,0,256,0,0,358,2560,0,358,2560,0,256,0,0,256,0,0,358,5120,-2560,256,2560,0,358,5120,-2560,358,5120,-2560,256,2560,0,256,2560,0,358,0,0,256,5120,-2560,358,0,0,358,0,0,256,5120,-2560,256,5120,-2560,358,-2560,0,256,0,0,358,-2560,0,358,-2560,0,256,0,0,256,0,0,358,5120,2560,358,-2560,0,461,5120,2560,461,5120,2560,358,-2560,0,358,-2560,0,461,0,0,358,5120,2560,461,0,0,461,0,0,358,5120,2560,358,5120,2560,461,2560,0,358,0,0,461,2560,0,461,2560,0,358,0,0,358,0,0,461,5120,-2560,358,2560,0,461,5120,-2560,461,5120,-2560,358,2560,0,358,2560,0,461,0,0,358,5120,-2560,461,0,0,461,0,0,358,5120,-2560,358,5120,-2560,461,-2560,0,358,0,0,461,-2560,0,461,-2560,0,358,0,0,358,0,0,461,5120,2560,461,-2560,0,563,5120,2560,563,5120,2560,461,-2560,0,461,-2560,0,563,0,0,461,5120,2560,563,0,0,563,0,0,461,5120,2560,461,5120,2560,563,2560,0,461,0,0,563,2560,0,563,2560,0,461,0,0,461,0,0,563,5120,-2560,461,2560,0,563,5120,-2560,563,5120,-2560,461,2560,0,461,2560,0,563,0,0,461,5120,-2560,563,0,0,563,0,0,461,5120,-2560,461,5120,-2560,563,-2560,0,461,0,0,563,-2560,0,563,-2560,0,461,0,0,461,0,0,563,5120,2560,563,-2560,0,666,5120,2560,666,5120,2560,563,-2560,0,563,-2560,0,666,0,0,563,5120,2560,666,0,0,666,0,0,563,5120,2560,563,5120,2560,666,2560,0,563,0,0,666,2560,0,666,2560,0,563,0,0,563,0,0,666,5120,-2560,563,2560,0,666,5120,-2560,666,5120,-2560,563,2560,0,563,2560,0,666,0,0,563,5120,-2560,666,0,0,666,0,0,563,5120,-2560,563,5120,-2560,666,-2560,0,563,0,0,666,-2560,0,666,-2560,0,563,0,0,563,0,0,666,5120,2560,666,-2560,0,768,5120,2560,768,5120,2560,666,-2560,0,666,-2560,0,768,0,0,666,5120,2560,768,0,0,768,0,0,666,5120,2560,666,5120,2560,768,2560,0,666,0,0,768,2560,0,768,2560,0,666,0,0,666,0,0,768,5120,-2560,666,2560,0,768,5120,-2560,768,5120,-2560,666,2560,0,666,2560,0,768,0,0,666,5120,-2560,768,0,0,768,0,0,666,5120,-2560,666,5120,-2560,768,-2560,0,666,0,0,768,-2560,0,768,-2560,0,666,0,0,666,0,0,768,5120,2560,768,-2560,0,870,5120,2560,870,5120,2560,768,-2560,0,768,-2560,0,870,0,0,768,5120,2560,870,0,0,870,0,0,768,5120,2560,768,5120,2560,870,2560,0,768,0,0,870,2560,0,870,2560,0,768,0,0,768,0,0,870,5120,-2560,768,2560,0,870,5120,-2560,870,5120,-2560,768,2560,0,768,2560,0,870,0,0,768,5120,-2560,870,0,0,870,0,0,768,5120,-2560,768,5120,-2560,870,-2560,0,768,0,0,870,-2560,0,870,-2560,0,768,0,0,768,0,0,870,5120,2560,870,-2560,0,973,5120,2560,973,5120,2560,870,-2560,0,870,-2560,0,973,0,0,870,5120,2560,973,0,0,973,0,0,870,5120,2560,870,5120,2560,973,2560,0,870,0,0,973,2560,0,973,2560,0,870,0,0,870,0,0,973,5120,-2560,870,2560,0,973,5120,-2560,973,5120,-2560,870,2560,0,870,2560,0,973,0,0,870,5120,-2560,973,0,0,973,0,0,870,5120,-2560,870,5120,-2560,973,-2560,0,870,0,0,973,-2560,0,973,-2560,0,870,0,0,870,0,0,973,5120,2560,973,-2560,0,1075,5120,2560,1075,5120,2560,973,-2560,0,973,-2560,0,1075,0,0,973,5120,2560,1075,0,0,1075,0,0,973,5120,2560,973,5120,2560,1075,2560,0,973,0,0,1075,2560,0,1075,2560,0,973,0,0,973,0,0,1075,5120,-2560,973,2560,0,1075,5120,-2560,1075,5120,-2560,973,2560,0,973,2560,0,1075,0,0,973,5120,-2560,1075,0,0,1075,0,0,973,5120,-2560,973,5120,-2560,1075,-2560,0,973,0,0,1075,-2560,0,1075,-2560,0,973,0,0,973,0,0,1075,5120,2560,1075,-2560,0,1178,5120,2560,1178,5120,2560,1075,-2560,0,1075,-2560,0,1178,0,0,1075,5120,2560,1178,0,0,1178,0,0,1075,5120,2560,1075,5120,2560,1178,2560,0,1075,0,0,1178,2560,0,1178,2560,0,1075,0,0,1075,0,0,1178,5120,-2560,1075,2560,0,1178,5120,-2560,1178,5120,-2560,1075,2560,0,1075,2560,0,1178,0,0,1075,5120,-2560,1178,0,0,1178,0,0,1075,5120,-2560,1075,5120,-2560,1178,-2560,0,1075,0,0,1178,-2560,0,1178,-2560,0,1075,0,0,1075,0,0,1178,5120,2560,1178,-2560,0,1280,5120,2560,1280,5120,2560,1178,-2560,0,1178,-2560,0,1280,0,0,1178,5120,2560,1280,0,0,1280,0,0,1178,5120,2560,1178,5120,2560,1280,2560,0,1178,0,0,1280,2560,0,1280,2560,0,1178,0,0,1178,0,0,1280,5120,-2560,1178,2560,0,1280,5120,-2560,1280,5120,-2560,1178,2560,0,1178,2560,0,1280,0,0,1178,5120,-2560,1280,0,0,1280,0,0,1178,5120,-2560,1178,5120,-2560,1280,-2560,0,1178,0,0,1280,-2560,0,1280,-2560,0,1178,0,0,1178,0,0,1280,5120,2560,1280,-2560,0,1382,5120,2560,1382,5120,2560,1280,-2560,0,1280,-2560,0,1382,0,0,1280,5120,2560,1382,0,0,1382,0,0,1280,5120,2560,1280,5120,2560,1382,2560,0,1280,0,0,1382,2560,0,1382,2560,0,1280,0,0,1280,0,0,1382,5120,-2560,1280,2560,0,1382,5120,-2560,1382,5120,-2560,1280,2560,0,1280,2560,0,1382,0,0,1280,5120,-2560,1382,0,0,1382,0,0,1280,5120,-2560,1280,5120,-2560,1382,-2560,0,1280,0,0,1382,-2560,0,1382,-2560,0,1280,0,0,1280,0,0,1382,5120,2560,1382,-2560,0,1485,5120,2560,1485,5120,2560,1382,-2560,0,1382,-2560,0,1485,0,0,1382,5120,2560,1485,0,0,1485,0,0,1382,5120,2560,1382,5120,2560,1485,2560,0,1382,0,0,1485,2560,0,1485,2560,0,1382,0,0,1382,0,0,1485,5120,-2560,1382,2560,0,1485,5120,-2560,1485,5120,-2560,1382,2560,0,1382,2560,0,1485,0,0,1382,5120,-2560,1485,0,0,1485,0,0,1382,5120,-2560,1382,5120,-2560,1485,-2560,0,1382,0,0,1485,-2560,0,1485,-2560,0,1382,0,0,1382,0,0,1485,5120,2560,1485,-2560,0,1587,5120,2560,1587,5120,2560,1485,-2560,0,1485,-2560,0,1587,0,0,1485,5120,2560,1587,0,0,1587,0,0,1485,5120,2560,1485,5120,2560,1587,2560,0,1485,0,0,1587,2560,0,1587,2560,0,1485,0,0,1485,0,0,1587,5120,-2560,1485,2560,0,1587,5120,-2560,1587,5120,-2560,1485,2560,0,1485,2560,0,1587,0,0,1485,5120,-2560,1587,0,0,1587,0,0,1485,5120,-2560,1485,5120,-2560,1587,-2560,0,1485,0,0,1587,-2560,0,1587,-2560,0,1485,0,0,1485,0,0,1587,5120,2560,1587,-2560,0,1690,5120,2560,1690,5120,2560,1587,-2560,0,1587,-2560,0,1690,0,0,1587,5120,2560,1690,0,0,1690,0,0,1587,5120,2560,1587,5120,2560,1690,2560,0,1587,0,0,1690,2560,0,1690,2560,0,1587,0,0,1587,0,0,1690,5120,-2560,1587,2560,0,1690,5120,-2560,1690,5120,-2560,1587,2560,0,1587,2560,0,1690,0,0,1587,5120,-2560,1690,0,0,1690,0,0,1587,5120,-2560,1587,5120,-2560,1690,-2560,0,1587,0,0,1690,-2560,0,1690,-2560,0,1587,0,0,1587,0,0,1690,5120,2560,1690,-2560,0,1792,5120,2560,1792,5120,2560,1690,-2560,0,1690,-2560,0,1792,0,0,1690,5120,2560,1792,0,0,1792,0,0,1690,5120,2560,1690,5120,2560,1792,2560,0,1690,0,0,1792,2560,0,1792,2560,0,1690,0,0,1690,0,0,1792,5120,-2560,1690,2560,0,1792,5120,-2560,1792,5120,-2560,1690,2560,0,1690,2560,0,1792,0,0,1690,5120,-2560,1792,0,0,1792,0,0,1690,5120,-2560,1690,5120,-2560,1792,-2560,0,1690,0,0,1792,-2560,0,1792,-2560,0,1690,0,0,1690,0,0,1792,5120,2560,1792,-2560,0,1894,5120,2560,1894,5120,2560,1792,-2560,0,1792,-2560,0,1894,0,0,1792,5120,2560,1894,0,0,1894,0,0,1792,5120,2560,1792,5120,2560,1894,2560,0,1792,0,0,1894,2560,0,1894,2560,0,1792,0,0,1792,0,0,1894,5120,-2560,1792,2560,0,1894,5120,-2560,1894,5120,-2560,1792,2560,0,1792,2560,0,1894,0,0,1792,5120,-2560,1894,0,0,1894,0,0,1792,5120,-2560,1792,5120,-2560,1894,-2560,0,1792,0,0,1894,-2560,0,1894,-2560,0,1792,0,0,1792,0,0,1894,5120,2560,1894,-2560,0,1997,5120,2560,1997,5120,2560,1894,-2560,0,1894,-2560,0,1997,0,0,1894,5120,2560,1997,0,0,1997,0,0,1894,5120,2560,1894,5120,2560,1997,2560,0,1894,0,0,1997,2560,0,1997,2560,0,1894,0,0,1894,0,0,1997,5120,-2560,1894,2560,0,1997,5120,-2560,1997,5120,-2560,1894,2560,0,1894,2560,0,1997,0,0,1894,5120,-2560,1997,0,0,1997,0,0,1894,5120,-2560,1894,5120,-2560,1997,-2560,0,1894,0,0,1997,-2560,0,1997,-2560,0,1894,0,0,1894,0,0,1997,5120,-2560,2099,2560,0,2099,0,0,2099,5120,2560,2099,-2560,0,2099,0,0,2099,5120,2560,1997,-2560,0,2099,5120,2560,2099,5120,2560,1997,-2560,0,1997,-2560,0,2099,0,0,1997,5120,2560,2099,0,0,2099,0,0,1997,5120,2560,1997,5120,2560,2099,2560,0,1997,0,0,2099,2560,0,2099,2560,0,1997,0,0,1997,0,0,2099,5120,-2560,1997,2560,0,2099,5120,-2560,2099,5120,-2560,1997,2560,0,1997,2560,0,2099,0,0,1997,5120,-2560,2099,0,0,2099,0,0,1997,5120,-2560,1997,5120,-2560,2099,-2560,0,1997,0,0,2099,-2560,0,2099,-2560,0,1997,0,0,1997,0,0,2099],
+   'normal':[0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,-162000,486000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,229000,-458000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,0,512000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,362000,362000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,-229000,-458000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0,0,-512000,0],
+   'color':[220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255,220,220,64,255],
+   'index':[0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1],
+});